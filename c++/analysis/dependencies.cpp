@@ -0,0 +1,212 @@
+#include "dependencies.h"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+void CollectNames(const Expression& expr, const std::vector<std::string>& params,
+                  std::unordered_set<std::string>& globals, std::unordered_set<std::string>& callees) {
+    auto read = [&](const std::string& name) {
+        if (std::find(params.begin(), params.end(), name) == params.end()) {
+            globals.insert(name);
+        }
+    };
+    switch (expr.kind) {
+        case ExprKind::NUMBER:
+            break;
+        case ExprKind::VARIABLE:
+            read(static_cast<const VariableExpr&>(expr).name);
+            break;
+        case ExprKind::BINARY: {
+            const auto& binary = static_cast<const BinaryExpr&>(expr);
+            CollectNames(*binary.left, params, globals, callees);
+            CollectNames(*binary.right, params, globals, callees);
+            break;
+        }
+        case ExprKind::TERNARY: {
+            const auto& ternary = static_cast<const TernaryExpr&>(expr);
+            CollectNames(*ternary.cond, params, globals, callees);
+            CollectNames(*ternary.then_expr, params, globals, callees);
+            CollectNames(*ternary.else_expr, params, globals, callees);
+            break;
+        }
+        case ExprKind::CALL: {
+            const auto& call = static_cast<const CallExpr&>(expr);
+            callees.insert(call.callee);
+            for (const auto& arg : call.args) {
+                CollectNames(*arg, params, globals, callees);
+            }
+            break;
+        }
+        case ExprKind::VAR_LESS_CONST:
+            read(static_cast<const VarLessConstExpr&>(expr).name);
+            break;
+        case ExprKind::VAR_SUB_CONST:
+            read(static_cast<const VarSubConstExpr&>(expr).name);
+            break;
+        case ExprKind::CALL_VAR_SUB_CONST: {
+            const auto& fused = static_cast<const CallVarSubConstExpr&>(expr);
+            callees.insert(fused.callee);
+            read(fused.name);
+            break;
+        }
+        case ExprKind::IF_VAR_EQ_CONST: {
+            const auto& fused = static_cast<const IfVarEqConstExpr&>(expr);
+            read(fused.name);
+            CollectNames(*fused.then_expr, params, globals, callees);
+            CollectNames(*fused.else_expr, params, globals, callees);
+            break;
+        }
+    }
+}
+
+bool MayFail(const Expression& expr, const std::vector<std::string>& locals) {
+    auto global = [&](const std::string& name) {
+        return std::find(locals.begin(), locals.end(), name) == locals.end();
+    };
+    switch (expr.kind) {
+        case ExprKind::NUMBER:
+            return false;
+        case ExprKind::VARIABLE:
+            return global(static_cast<const VariableExpr&>(expr).name);
+        case ExprKind::BINARY: {
+            const auto& binary = static_cast<const BinaryExpr&>(expr);
+            return binary.op == OperatorToken::DIVIDE || MayFail(*binary.left, locals) ||
+                   MayFail(*binary.right, locals);
+        }
+        case ExprKind::TERNARY: {
+            const auto& ternary = static_cast<const TernaryExpr&>(expr);
+            return MayFail(*ternary.cond, locals) || MayFail(*ternary.then_expr, locals) ||
+                   MayFail(*ternary.else_expr, locals);
+        }
+        case ExprKind::VAR_LESS_CONST:
+            return global(static_cast<const VarLessConstExpr&>(expr).name);
+        case ExprKind::VAR_SUB_CONST:
+            return global(static_cast<const VarSubConstExpr&>(expr).name);
+        case ExprKind::IF_VAR_EQ_CONST: {
+            const auto& fused = static_cast<const IfVarEqConstExpr&>(expr);
+            return global(fused.name) || MayFail(*fused.then_expr, locals) ||
+                   MayFail(*fused.else_expr, locals);
+        }
+        case ExprKind::CALL:
+        case ExprKind::CALL_VAR_SUB_CONST:
+            break;
+    }
+    return true;
+}
+
+std::unique_ptr<Expression>* RootExpression(Statement& stmt) {
+    if (auto ret = dynamic_cast<Return*>(&stmt)) {
+        return &ret->value;
+    }
+    if (auto assignment = dynamic_cast<Assignment*>(&stmt)) {
+        return &assignment->value;
+    }
+    return nullptr;
+}
+
+void CollectNestedDefs(const Statement& stmt, std::unordered_set<std::string>& names) {
+    if (auto func = dynamic_cast<const FunctionDef*>(&stmt)) {
+        if (auto nested = dynamic_cast<const FunctionDef*>(func->Body())) {
+            names.insert(nested->name);
+            CollectNestedDefs(*nested, names);
+        }
+    }
+}
+
+namespace {
+
+struct FunctionSummary {
+    std::vector<std::string> globals;
+    std::vector<std::string> callees;
+};
+
+const FunctionSummary& summarize(const FunctionDef& func,
+                                 std::unordered_map<const FunctionDef*, FunctionSummary>& summaries) {
+    auto it = summaries.find(&func);
+    if (it != summaries.end()) {
+        return it->second;
+    }
+    std::unordered_set<std::string> globals;
+    std::unordered_set<std::string> callees;
+    const Expression* body = nullptr;
+    if (auto ret = dynamic_cast<const Return*>(func.Body())) {
+        body = ret->value.get();
+    } else if (auto assignment = dynamic_cast<const Assignment*>(func.Body())) {
+        body = assignment->value.get();
+    }
+    if (body) {
+        CollectNames(*body, func.params, globals, callees);
+    }
+    FunctionSummary summary{{globals.begin(), globals.end()}, {callees.begin(), callees.end()}};
+    return summaries.emplace(&func, std::move(summary)).first->second;
+}
+
+}  // namespace
+
+std::vector<DependencyNode> BuildDependencyGraph(const Program& program) {
+    static const std::vector<std::string> no_params;
+    std::vector<DependencyNode> nodes;
+    std::unordered_map<std::string, const FunctionDef*> functions;
+    std::unordered_map<std::string, size_t> last_assignment;
+    std::unordered_map<const FunctionDef*, FunctionSummary> summaries;
+    for (const auto& stmt : program.statements) {
+        DependencyNode node;
+        if (auto func = dynamic_cast<const FunctionDef*>(stmt.get())) {
+            functions[func->name] = func;
+            continue;
+        } else if (auto assignment = dynamic_cast<const Assignment*>(stmt.get())) {
+            node.expr = assignment->value.get();
+            node.name = &assignment->name;
+        } else if (auto ret = dynamic_cast<const Return*>(stmt.get())) {
+            node.expr = ret->value.get();
+        } else {
+            continue;
+        }
+
+        size_t id = nodes.size();
+        std::unordered_set<std::string> globals;
+        std::unordered_set<std::string> callees;
+        CollectNames(*node.expr, no_params, globals, callees);
+
+        // Function bodies resolve names when called, so the node also reads
+        // whatever the functions bound at this point read.
+        std::vector<std::string> pending(callees.begin(), callees.end());
+        while (!pending.empty()) {
+            std::string callee = std::move(pending.back());
+            pending.pop_back();
+            auto it = functions.find(callee);
+            const FunctionDef* func = it == functions.end() ? nullptr : it->second;
+            node.functions.emplace_back(callee, func);
+            if (!func) {
+                continue;
+            }
+            const FunctionSummary& called = summarize(*func, summaries);
+            globals.insert(called.globals.begin(), called.globals.end());
+            for (const auto& next : called.callees) {
+                if (callees.insert(next).second) {
+                    pending.push_back(next);
+                }
+            }
+        }
+
+        for (const auto& global : globals) {
+            auto source = last_assignment.find(global);
+            if (source == last_assignment.end()) {
+                node.globals.emplace_back(global, DependencyNode::kUnbound);
+            } else {
+                node.globals.emplace_back(global, source->second);
+                nodes[source->second].dependents.push_back(id);
+            }
+        }
+
+        bool is_return = !node.name;
+        if (!is_return) {
+            last_assignment[*node.name] = id;
+        }
+        nodes.push_back(std::move(node));
+        if (is_return) {
+            break;
+        }
+    }
+    return nodes;
+}
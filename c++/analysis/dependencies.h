@@ -0,0 +1,45 @@
+#ifndef TOY_LANG_DEPENDENCIES
+#define TOY_LANG_DEPENDENCIES
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "../ast/ast.h"
+
+// One top-level assignment, or the first top-level return, together with
+// everything its evaluation can read. Names resolve as sequential execution
+// would see them at this point of the program: a global to its latest earlier
+// assignment, a function to its latest earlier `def`. Globals read inside
+// called function bodies count as reads of the node.
+struct DependencyNode {
+    static constexpr size_t kUnbound = static_cast<size_t>(-1);
+
+    const Expression* expr = nullptr;
+    const std::string* name = nullptr;  // null for the return
+    std::vector<std::pair<std::string, size_t>> globals;  // name -> source node or kUnbound
+    std::vector<std::pair<std::string, const FunctionDef*>> functions;  // null when undefined
+    std::vector<size_t> dependents;
+};
+
+// Nodes in program order; statements after the first top-level return are
+// never executed and are left out. Every edge points to an earlier node.
+std::vector<DependencyNode> BuildDependencyGraph(const Program& program);
+
+// Adds the globals `expr` reads, other than `params`, and the functions it
+// calls, fused nodes included.
+void CollectNames(const Expression& expr, const std::vector<std::string>& params,
+                  std::unordered_set<std::string>& globals, std::unordered_set<std::string>& callees);
+
+// Whether evaluating `expr` can raise: a division, a read of anything but
+// `locals`, or a call. Fused nodes included.
+bool MayFail(const Expression& expr, const std::vector<std::string>& locals);
+
+// The value of a return or an assignment; null for a `def`.
+std::unique_ptr<Expression>* RootExpression(Statement& stmt);
+
+// Adds the names of the functions `def`ined inside `stmt`'s body, at any depth.
+void CollectNestedDefs(const Statement& stmt, std::unordered_set<std::string>& names);
+
+#endif // TOY_LANG_DEPENDENCIES
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <sstream>
+#include "dependencies.h"
+#include "../parser/parser.h"
+
+class DependenciesTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Program> parse(const std::string& source) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        return parser.Parse();
+    }
+
+    static std::vector<std::pair<std::string, size_t>> sorted(
+        std::vector<std::pair<std::string, size_t>> globals) {
+        std::sort(globals.begin(), globals.end());
+        return globals;
+    }
+};
+
+TEST_F(DependenciesTest, ResolvesToLatestEarlierAssignment) {
+    auto program = parse("x = 1\ny = x + z\nx = 2\nw = x * y\n");
+    auto graph = BuildDependencyGraph(*program);
+    ASSERT_EQ(graph.size(), 4u);
+    using Globals = std::vector<std::pair<std::string, size_t>>;
+    EXPECT_EQ(sorted(graph[1].globals), (Globals{{"x", 0}, {"z", DependencyNode::kUnbound}}));
+    EXPECT_EQ(sorted(graph[3].globals), (Globals{{"x", 2}, {"y", 1}}));
+    EXPECT_EQ(graph[0].dependents, std::vector<size_t>{1});
+    EXPECT_EQ(graph[2].dependents, std::vector<size_t>{3});
+}
+
+TEST_F(DependenciesTest, FollowsCalledFunctions) {
+    auto program = parse(
+        "rate = 3\n"
+        "def g(x) return x * rate + h()\n"
+        "def f(x) return g(x)\n"
+        "y = f(2)\n"
+        "return y\n"
+        "z = 1\n");
+    auto graph = BuildDependencyGraph(*program);
+    ASSERT_EQ(graph.size(), 3u);
+    EXPECT_EQ(graph[1].globals, (std::vector<std::pair<std::string, size_t>>{{"rate", 0}}));
+    EXPECT_EQ(graph[1].functions.size(), 3u);
+    EXPECT_EQ(graph[2].name, nullptr);
+}
+
+TEST_F(DependenciesTest, FindsRootsAndNestedDefs) {
+    auto program = parse("def f(a) def g(b) def h(c) return c\nx = 1\nreturn x\n");
+    EXPECT_EQ(RootExpression(*program->statements[0]), nullptr);
+    EXPECT_EQ(RootExpression(*program->statements[1])->get()->kind, ExprKind::NUMBER);
+    EXPECT_EQ(RootExpression(*program->statements[2])->get()->kind, ExprKind::VARIABLE);
+
+    std::unordered_set<std::string> nested;
+    CollectNestedDefs(*program->statements[0], nested);
+    EXPECT_EQ(nested, (std::unordered_set<std::string>{"g", "h"}));
+}
+
+TEST_F(DependenciesTest, FindsExpressionsThatMayFail) {
+    auto program = parse("x = a + 1\ny = a / 2\nz = a < 1\nreturn f(a)\n");
+    const std::vector<std::string> locals{"a"};
+    EXPECT_FALSE(MayFail(**RootExpression(*program->statements[0]), locals));
+    EXPECT_TRUE(MayFail(**RootExpression(*program->statements[0]), {}));
+    EXPECT_TRUE(MayFail(**RootExpression(*program->statements[1]), locals));
+    EXPECT_FALSE(MayFail(**RootExpression(*program->statements[2]), locals));
+    EXPECT_TRUE(MayFail(**RootExpression(*program->statements[3]), locals));
+
+    IfVarEqConstExpr fused("a", Integer(0), std::make_unique<NumberExpr>(Integer(1)),
+                           std::make_unique<VariableExpr>("b"));
+    EXPECT_TRUE(MayFail(fused, locals));
+    EXPECT_FALSE(MayFail(fused, {"a", "b"}));
+}
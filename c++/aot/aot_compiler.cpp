@@ -0,0 +1,410 @@
+#include "aot_compiler.h"
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+// Raised while emitting when the program leaves the native subset.
+struct Unsupported {};
+
+const char* kPrelude = R"(#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+    jmp_buf bail;
+    int64_t* globals;
+    unsigned char* assigned;
+    unsigned char* defined;
+    long depth;
+} toy_ctx;
+
+static __attribute__((noreturn, cold)) void toy_bail(toy_ctx* c) { longjmp(c->bail, 1); }
+
+static inline int64_t toy_add(toy_ctx* c, int64_t a, int64_t b) {
+    int64_t r;
+    if (__builtin_add_overflow(a, b, &r)) toy_bail(c);
+    return r;
+}
+
+static inline int64_t toy_sub(toy_ctx* c, int64_t a, int64_t b) {
+    int64_t r;
+    if (__builtin_sub_overflow(a, b, &r)) toy_bail(c);
+    return r;
+}
+
+static inline int64_t toy_mul(toy_ctx* c, int64_t a, int64_t b) {
+    int64_t r;
+    if (__builtin_mul_overflow(a, b, &r)) toy_bail(c);
+    return r;
+}
+
+static inline int64_t toy_div(toy_ctx* c, int64_t a, int64_t b) {
+    if (b == 0 || (a == INT64_MIN && b == -1)) toy_bail(c);
+    return a / b;
+}
+
+static inline int64_t toy_global(toy_ctx* c, int i) {
+    if (!c->assigned[i]) toy_bail(c);
+    return c->globals[i];
+}
+
+)";
+
+class CEmitter {
+public:
+    // Returns the C translation unit, or nullopt when the program has to run
+    // on the VM. Global slots are numbered in `globals`.
+    std::optional<std::string> Emit(const Program& program, size_t max_depth,
+                                    std::unordered_map<std::string, size_t>& globals) {
+        globals_ = &globals;
+        try {
+            return emitProgram(program, max_depth);
+        } catch (const Unsupported&) {
+            return std::nullopt;
+        }
+    }
+
+private:
+    struct Callee {
+        size_t index;
+        size_t arity;
+        bool checked;  // may run before its def statement
+    };
+
+    std::unordered_map<std::string, Callee> functions_;
+    std::unordered_map<std::string, size_t>* globals_ = nullptr;
+    const std::vector<std::string>* params_ = nullptr;
+
+    std::string emitProgram(const Program& program, size_t max_depth) {
+        size_t first_code = program.statements.size();
+        for (size_t i = 0; i < program.statements.size(); ++i) {
+            if (!dynamic_cast<const FunctionDef*>(program.statements[i].get())) {
+                first_code = std::min(first_code, i);
+                continue;
+            }
+            const auto& func = static_cast<const FunctionDef&>(*program.statements[i]);
+            if (functions_.count(func.name)) {
+                throw Unsupported{};
+            }
+            functions_.emplace(func.name, Callee{functions_.size(), func.params.size(), i > first_code});
+        }
+
+        std::ostringstream out;
+        out << kPrelude;
+        std::ostringstream bodies;
+        for (const auto& stmt : program.statements) {
+            auto func = dynamic_cast<const FunctionDef*>(stmt.get());
+            if (!func) {
+                continue;
+            }
+            const Expression* body = bodyExpression(*func->Body());
+            if (!body) {
+                throw Unsupported{};
+            }
+            const Callee& callee = functions_.at(func->name);
+            std::string signature = "static int64_t toy_f" + std::to_string(callee.index) + "(toy_ctx* c";
+            for (size_t i = 0; i < func->params.size(); ++i) {
+                signature += ", int64_t p" + std::to_string(i);
+            }
+            signature += ")";
+            out << signature << ";\n";
+
+            params_ = &func->params;
+            bodies << "\n" << signature << " {\n";
+            if (callee.checked) {
+                bodies << "    if (!c->defined[" << callee.index << "]) toy_bail(c);\n";
+            }
+            bodies << "    if (++c->depth > " << max_depth << "L) toy_bail(c);\n";
+            bodies << "    int64_t r = " << expression(*body) << ";\n";
+            bodies << "    --c->depth;\n    return r;\n}\n";
+        }
+        out << bodies.str();
+
+        static const std::vector<std::string> no_params;
+        params_ = &no_params;
+        std::ostringstream run;
+        for (const auto& stmt : program.statements) {
+            if (auto func = dynamic_cast<const FunctionDef*>(stmt.get())) {
+                run << "    defined[" << functions_.at(func->name).index << "] = 1;\n";
+            } else if (auto assignment = dynamic_cast<const Assignment*>(stmt.get())) {
+                size_t slot = global(assignment->name);
+                run << "    globals[" << slot << "] = " << expression(*assignment->value) << ";\n";
+                run << "    assigned[" << slot << "] = 1;\n";
+            } else if (auto ret = dynamic_cast<const Return*>(stmt.get())) {
+                run << "    *result = " << expression(*ret->value) << ";\n    return 1;\n";
+                break;
+            }
+        }
+        out << "\nint toy_run(int64_t* globals, unsigned char* assigned, int64_t* result) {\n";
+        out << "    unsigned char defined[" << std::max<size_t>(functions_.size(), 1) << "];\n";
+        out << "    toy_ctx ctx;\n    toy_ctx* c = &ctx;\n";
+        out << "    memset(defined, 0, sizeof(defined));\n";
+        out << "    ctx.globals = globals;\n    ctx.assigned = assigned;\n    ctx.defined = defined;\n";
+        out << "    ctx.depth = 0;\n";
+        out << "    if (setjmp(ctx.bail)) return -1;\n";
+        out << run.str();
+        out << "    return 0;\n}\n";
+        return out.str();
+    }
+
+    static const Expression* bodyExpression(const Statement& body) {
+        if (auto ret = dynamic_cast<const Return*>(&body)) {
+            return ret->value.get();
+        }
+        if (auto assignment = dynamic_cast<const Assignment*>(&body)) {
+            return assignment->value.get();
+        }
+        return nullptr;
+    }
+
+    size_t global(const std::string& name) {
+        return globals_->emplace(name, globals_->size()).first->second;
+    }
+
+    std::string constant(const Integer& value) {
+        if (!value.IsSmall()) {
+            throw Unsupported{};
+        }
+        if (value.Small() == std::numeric_limits<int64_t>::min()) {
+            return "INT64_MIN";
+        }
+        return "INT64_C(" + std::to_string(value.Small()) + ")";
+    }
+
+    std::string variable(const std::string& name) {
+        auto param = std::find(params_->begin(), params_->end(), name);
+        if (param != params_->end()) {
+            return "p" + std::to_string(param - params_->begin());
+        }
+        return "toy_global(c, " + std::to_string(global(name)) + ")";
+    }
+
+    std::string binary(OperatorToken op, const std::string& left, const std::string& right) {
+        switch (op) {
+            case OperatorToken::PLUS:
+                return "toy_add(c, " + left + ", " + right + ")";
+            case OperatorToken::MINUS:
+                return "toy_sub(c, " + left + ", " + right + ")";
+            case OperatorToken::MULTIPLY:
+                return "toy_mul(c, " + left + ", " + right + ")";
+            case OperatorToken::DIVIDE:
+                return "toy_div(c, " + left + ", " + right + ")";
+            case OperatorToken::EQ_EQ:
+                return "(int64_t)(" + left + " == " + right + ")";
+            case OperatorToken::NOT_EQ:
+                return "(int64_t)(" + left + " != " + right + ")";
+            case OperatorToken::LESS:
+                return "(int64_t)(" + left + " < " + right + ")";
+            default:
+                throw Unsupported{};
+        }
+    }
+
+    std::string call(const std::string& name, const std::vector<std::string>& args) {
+        auto it = functions_.find(name);
+        if (it == functions_.end() || it->second.arity != args.size()) {
+            throw Unsupported{};
+        }
+        std::string code = "toy_f" + std::to_string(it->second.index) + "(c";
+        for (const auto& arg : args) {
+            code += ", " + arg;
+        }
+        return code + ")";
+    }
+
+    std::string conditional(const std::string& cond, const std::string& then_code, const std::string& else_code) {
+        return "(" + cond + " ? " + then_code + " : " + else_code + ")";
+    }
+
+    std::string expression(const Expression& expr) {
+        switch (expr.kind) {
+            case ExprKind::NUMBER:
+                return constant(static_cast<const NumberExpr&>(expr).value);
+            case ExprKind::VARIABLE:
+                return variable(static_cast<const VariableExpr&>(expr).name);
+            case ExprKind::BINARY: {
+                const auto& node = static_cast<const BinaryExpr&>(expr);
+                return binary(node.op, expression(*node.left), expression(*node.right));
+            }
+            case ExprKind::TERNARY: {
+                const auto& node = static_cast<const TernaryExpr&>(expr);
+                return conditional(expression(*node.cond), expression(*node.then_expr),
+                                   expression(*node.else_expr));
+            }
+            case ExprKind::CALL: {
+                const auto& node = static_cast<const CallExpr&>(expr);
+                std::vector<std::string> args;
+                for (const auto& arg : node.args) {
+                    args.push_back(expression(*arg));
+                }
+                return call(node.callee, args);
+            }
+            case ExprKind::VAR_LESS_CONST: {
+                const auto& node = static_cast<const VarLessConstExpr&>(expr);
+                return binary(OperatorToken::LESS, variable(node.name), constant(node.constant));
+            }
+            case ExprKind::VAR_SUB_CONST: {
+                const auto& node = static_cast<const VarSubConstExpr&>(expr);
+                return binary(OperatorToken::MINUS, variable(node.name), constant(node.constant));
+            }
+            case ExprKind::CALL_VAR_SUB_CONST: {
+                const auto& node = static_cast<const CallVarSubConstExpr&>(expr);
+                return call(node.callee, {binary(OperatorToken::MINUS, variable(node.name), constant(node.constant))});
+            }
+            case ExprKind::IF_VAR_EQ_CONST: {
+                const auto& node = static_cast<const IfVarEqConstExpr&>(expr);
+                return conditional(binary(OperatorToken::EQ_EQ, variable(node.name), constant(node.constant)),
+                                   expression(*node.then_expr), expression(*node.else_expr));
+            }
+        }
+        throw Unsupported{};
+    }
+};
+
+// FNV-1a; stable across builds, unlike std::hash.
+uint64_t sourceHash(const std::string& source) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char byte : source) {
+        hash = (hash ^ byte) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::string quote(const std::string& path) {
+    std::string quoted = "'";
+    for (char ch : path) {
+        if (ch == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += ch;
+        }
+    }
+    return quoted + "'";
+}
+
+// Whether `path` itself, not a symlink, is of `type` (S_IFDIR or S_IFREG),
+// owned by this user and clear of the `forbidden` permission bits, so no one
+// else can have put or changed what it holds.
+bool isPrivate(const std::string& path, mode_t type, mode_t forbidden) {
+    struct stat info;
+    return ::lstat(path.c_str(), &info) == 0 && (info.st_mode & S_IFMT) == type && info.st_uid == ::geteuid() &&
+           (info.st_mode & forbidden) == 0;
+}
+
+// Returns the path of the shared object built from `source`, compiling it
+// unless a previous build is cached. Empty when the compiler fails or the
+// cache directory or a cached object is not private to this user.
+std::string buildSharedObject(const std::string& source, const AotOptions& options) {
+    namespace fs = std::filesystem;
+    fs::path dir;
+    mode_t dir_forbidden = S_IWGRP | S_IWOTH;
+    std::error_code error;
+    if (options.cache_dir.empty()) {
+        // The system temp directory is shared, so the default cache is a
+        // per-user directory only its owner can even list.
+        dir = fs::temp_directory_path(error) / ("toy_lang_aot-" + std::to_string(::geteuid()));
+        ::mkdir(dir.c_str(), 0700);
+        dir_forbidden = S_IRWXG | S_IRWXO;
+    } else {
+        dir = options.cache_dir;
+        fs::create_directories(dir, error);
+    }
+    if (!isPrivate(dir.string(), S_IFDIR, dir_forbidden)) {
+        return "";
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "toy_%016llx", static_cast<unsigned long long>(sourceHash(source)));
+    fs::path object = dir / (std::string(name) + ".so");
+    if (fs::exists(object, error)) {
+        return isPrivate(object.string(), S_IFREG, S_IWGRP | S_IWOTH) ? object.string() : "";
+    }
+
+    // Every builder, in this process or another, reserves its own source
+    // file with mkstemps and races only on the rename of the object.
+    std::string c_file = (dir / (std::string(name) + ".XXXXXX.c")).string();
+    int fd = ::mkstemps(c_file.data(), 2);
+    if (fd < 0) {
+        return "";
+    }
+    bool written = ::write(fd, source.data(), source.size()) == static_cast<ssize_t>(source.size());
+    ::close(fd);
+    std::string temporary = c_file.substr(0, c_file.size() - 2) + ".so";
+    if (!written) {
+        fs::remove(c_file, error);
+        return "";
+    }
+    std::string command = options.compiler + " -O2 -shared -fPIC -o " + quote(temporary) + " " + quote(c_file) +
+                          " > /dev/null 2>&1";
+    int status = std::system(command.c_str());
+    fs::remove(c_file, error);
+    if (status != 0) {
+        fs::remove(temporary, error);
+        return "";
+    }
+    fs::rename(temporary, object, error);
+    if (error) {
+        fs::remove(temporary, error);
+    }
+    return isPrivate(object.string(), S_IFREG, S_IWGRP | S_IWOTH) ? object.string() : "";
+}
+
+}  // namespace
+
+AotProgram::AotProgram(const Program& program, AotOptions options) : fallback_(program) {
+    std::optional<std::string> source = CEmitter().Emit(program, options.max_depth, global_index_);
+    if (!source) {
+        return;
+    }
+    std::string object = buildSharedObject(*source, options);
+    if (object.empty()) {
+        return;
+    }
+    handle_ = ::dlopen(object.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle_) {
+        return;
+    }
+    run_ = reinterpret_cast<RunFn>(::dlsym(handle_, "toy_run"));
+    globals_.resize(global_index_.size());
+    assigned_.resize(global_index_.size());
+}
+
+AotProgram::~AotProgram() {
+    if (handle_) {
+        ::dlclose(handle_);
+    }
+}
+
+std::optional<Integer> AotProgram::Run() {
+    if (run_) {
+        std::fill(assigned_.begin(), assigned_.end(), 0);
+        int64_t result = 0;
+        int status = run_(globals_.data(), assigned_.data(), &result);
+        if (status >= 0) {
+            native_ran_ = true;
+            return status == 1 ? std::optional<Integer>(result) : std::nullopt;
+        }
+        ++fallbacks_;
+    }
+    native_ran_ = false;
+    return fallback_.Run();
+}
+
+Integer AotProgram::GetGlobal(const std::string& name) const {
+    if (!native_ran_) {
+        return fallback_.GetGlobal(name);
+    }
+    auto it = global_index_.find(name);
+    if (it == global_index_.end() || !assigned_[it->second]) {
+        throw NameError("Undefined variable: " + name);
+    }
+    return Integer(globals_[it->second]);
+}
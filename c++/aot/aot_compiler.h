@@ -0,0 +1,62 @@
+#ifndef TOY_LANG_AOT_COMPILER
+#define TOY_LANG_AOT_COMPILER
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../ast/ast.h"
+#include "../error.h"
+#include "../vm/vm.h"
+
+struct AotOptions {
+    std::string compiler = "cc";
+    std::string cache_dir;    // empty: a private "toy_lang_aot-<uid>" under the system temp directory
+    size_t max_depth = 10000;  // deeper native recursion falls back to the VM
+};
+
+// Translates a Program to C, builds it into a shared object with the local
+// C compiler and runs it through dlopen. Objects are cached on disk under the
+// hash of the generated source, so only the first construction for a given
+// program pays for the compiler. Only a cache directory and objects owned by
+// the current user and writable by no one else are used; a program whose
+// cache fails that check runs on the VM.
+//
+// Native code computes with int64_t. Whenever it cannot reproduce the exact
+// semantics (overflow into big integers, division by zero, an unbound name,
+// recursion beyond `max_depth`), the run is abandoned and repeated on a
+// BytecodeProgram, which also produces the error, if any. Programs outside
+// the native subset (redefined or unknown functions, arity mismatches,
+// non-value function bodies, big literals) always run on the VM.
+class AotProgram {
+public:
+    explicit AotProgram(const Program& program, AotOptions options = {});
+    ~AotProgram();
+
+    AotProgram(const AotProgram&) = delete;
+    AotProgram& operator=(const AotProgram&) = delete;
+
+    std::optional<Integer> Run();
+
+    Integer GetGlobal(const std::string& name) const;
+
+    bool IsNative() const { return run_ != nullptr; }
+    size_t Fallbacks() const { return fallbacks_; }
+
+private:
+    // Returns 1 with *result set after a top-level return, 0 at the end of
+    // the program and -1 when the run has to be repeated on the VM.
+    using RunFn = int (*)(int64_t* globals, unsigned char* assigned, int64_t* result);
+
+    BytecodeProgram fallback_;
+    void* handle_ = nullptr;
+    RunFn run_ = nullptr;
+    std::unordered_map<std::string, size_t> global_index_;
+    std::vector<int64_t> globals_;
+    std::vector<unsigned char> assigned_;
+    bool native_ran_ = false;  // whether the globals of the last run are in globals_
+    size_t fallbacks_ = 0;
+};
+
+#endif // TOY_LANG_AOT_COMPILER
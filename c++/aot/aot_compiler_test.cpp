@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <atomic>
+#include <filesystem>
+#include <sstream>
+#include <thread>
+#include "aot_compiler.h"
+#include "../interpreter/interpreter.h"
+#include "../optimizer/fusion.h"
+#include "../parser/parser.h"
+
+class AotCompilerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        options_.cache_dir = (std::filesystem::temp_directory_path() /
+                              ("toy_lang_aot_test_" + std::to_string(::getpid()))).string();
+    }
+
+    void TearDown() override { std::filesystem::remove_all(options_.cache_dir); }
+
+    std::unique_ptr<Program> parse(const std::string& source) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        return parser.Parse();
+    }
+
+    AotOptions options_;
+};
+
+TEST_F(AotCompilerTest, CompilesPureIntegerScripts) {
+    const char* sources[] = {
+        "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\nreturn fib(20)\n",
+        "def add(x, y)\n    x = x + y\nreturn add(2, 3)\n",
+        "scale = 10\ndef f(x) return x * scale\nreturn f(4)\n",
+        "def f(a, b, c, d, e) return a - b + c * d / e\nreturn f(1, 2, 3, 4, 5)\n",
+        "def f(c) return 10 - (if c then 1 else 2)\nreturn f(0) * 100 + f(1) + (7 != 8) + (0 - 7) / 2\n",
+        "x = 1 + 2 * 3\ny = (x - 1) / 2\nz = if x < y then 10 else 20\n",
+    };
+    for (const char* source : sources) {
+        auto program = parse(source);
+        AotProgram compiled(*program, options_);
+        EXPECT_TRUE(compiled.IsNative()) << source;
+        EXPECT_EQ(compiled.Run(), Interpreter().Run(*program)) << source;
+        EXPECT_EQ(compiled.Fallbacks(), 0u) << source;
+    }
+}
+
+TEST_F(AotCompilerTest, ExposesGlobals) {
+    AotProgram compiled(*parse("x = 6 * 7\ny = x / 5\n"), options_);
+    EXPECT_THROW(compiled.GetGlobal("x"), NameError);
+    EXPECT_FALSE(compiled.Run().has_value());
+    EXPECT_EQ(compiled.GetGlobal("x"), 42);
+    EXPECT_EQ(compiled.GetGlobal("y"), 8);
+    EXPECT_THROW(compiled.GetGlobal("z"), NameError);
+}
+
+TEST_F(AotCompilerTest, RunsFusedNodes) {
+    auto program = parse(
+        "def sum(n) return if n == 0 then 0 else n + sum(n - 1)\n"
+        "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\n"
+        "return sum(100) + fib(10)\n");
+    EXPECT_GT(FuseExpressions(*program), 0u);
+    AotProgram compiled(*program, options_);
+    EXPECT_TRUE(compiled.IsNative());
+    EXPECT_EQ(compiled.Run(), 5050 + 55);
+}
+
+TEST_F(AotCompilerTest, FallsBackToExactSemantics) {
+    AotProgram overflow(*parse("def f(x) return x * x\nreturn f(4294967296) + 1\n"), options_);
+    EXPECT_TRUE(overflow.IsNative());
+    EXPECT_EQ(overflow.Run(), Integer::Parse("18446744073709551617"));
+    EXPECT_EQ(overflow.Fallbacks(), 1u);
+
+    AotProgram deep(*parse("def sum(n) return if n == 0 then 0 else n + sum(n - 1)\nreturn sum(100000)\n"),
+                    options_);
+    EXPECT_EQ(deep.Run(), 5000050000);
+    EXPECT_EQ(deep.Fallbacks(), 1u);
+
+    EXPECT_THROW(AotProgram(*parse("x = 1 / 0\n"), options_).Run(), RuntimeError);
+    EXPECT_THROW(AotProgram(*parse("x = y\n"), options_).Run(), NameError);
+    EXPECT_THROW(AotProgram(*parse("x = f(1)\ndef f(a) return a\n"), options_).Run(), NameError);
+}
+
+TEST_F(AotCompilerTest, RunsUnsupportedProgramsOnVm) {
+    const char* sources[] = {
+        "def f() return 1\nx = f()\ndef f() return 2\nreturn x + f()\n",
+        "return 100000000000000000000000 / 7\n",
+    };
+    for (const char* source : sources) {
+        auto program = parse(source);
+        AotProgram compiled(*program, options_);
+        EXPECT_FALSE(compiled.IsNative()) << source;
+        EXPECT_EQ(compiled.Run(), Interpreter().Run(*program)) << source;
+    }
+    EXPECT_THROW(AotProgram(*parse("x = f(1)\n"), options_).Run(), NameError);
+    EXPECT_THROW(AotProgram(*parse("def f(a) return a\nx = f(1, 2)\n"), options_).Run(), RuntimeError);
+    EXPECT_THROW(AotProgram(*parse("def f(a) def g(b) return b\nx = f(1)\n"), options_).Run(), RuntimeError);
+}
+
+TEST_F(AotCompilerTest, CachesSharedObjects) {
+    const char* source = "def sq(n) return n * n\nreturn sq(12)\n";
+    AotProgram first(*parse(source), options_);
+    AotProgram second(*parse(source), options_);
+    AotProgram other(*parse("return 1\n"), options_);
+    EXPECT_EQ(first.Run(), 144);
+    EXPECT_EQ(second.Run(), 144);
+    size_t objects = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(options_.cache_dir)) {
+        EXPECT_EQ(entry.path().extension(), ".so");
+        ++objects;
+    }
+    EXPECT_EQ(objects, 2u);
+}
+
+TEST_F(AotCompilerTest, TrustsOnlyPrivateCaches) {
+    namespace fs = std::filesystem;
+    const char* source = "def sq(n) return n * n\nreturn sq(12)\n";
+    fs::path object;
+    {
+        AotProgram compiled(*parse(source), options_);
+        ASSERT_TRUE(compiled.IsNative());
+        object = fs::directory_iterator(options_.cache_dir)->path();
+    }
+
+    // A cached object someone else could have written is not loaded.
+    fs::permissions(object, fs::perms::group_write | fs::perms::others_write, fs::perm_options::add);
+    AotProgram writable(*parse(source), options_);
+    EXPECT_FALSE(writable.IsNative());
+    EXPECT_EQ(writable.Run(), 144);
+
+    // Nor is anything from a directory others can write to.
+    fs::permissions(object, fs::perms::group_write | fs::perms::others_write, fs::perm_options::remove);
+    fs::permissions(options_.cache_dir, fs::perms::all, fs::perm_options::add);
+    AotProgram shared(*parse(source), options_);
+    EXPECT_FALSE(shared.IsNative());
+    EXPECT_EQ(shared.Run(), 144);
+    AotProgram uncached(*parse("return 7\n"), options_);
+    EXPECT_FALSE(uncached.IsNative());
+    EXPECT_EQ(uncached.Run(), 7);
+}
+
+TEST_F(AotCompilerTest, BuildsConcurrently) {
+    const char* source = "def sq(n) return n * n + 1\nreturn sq(12)\n";
+    std::vector<std::thread> threads;
+    std::atomic<size_t> native{0};
+    for (size_t i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            AotProgram compiled(*parse(source), options_);
+            native += compiled.IsNative() && compiled.Run() == 145;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(native, 4u);
+    for (const auto& entry : std::filesystem::directory_iterator(options_.cache_dir)) {
+        EXPECT_EQ(entry.path().extension(), ".so");
+    }
+}
+
+TEST_F(AotCompilerTest, FallsBackWithoutCompiler) {
+    options_.compiler = "/nonexistent/cc";
+    AotProgram compiled(*parse("return 2 + 3\n"), options_);
+    EXPECT_FALSE(compiled.IsNative());
+    EXPECT_EQ(compiled.Run(), 5);
+}
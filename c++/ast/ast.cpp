@@ -1 +1,165 @@
-#include "ast.h"
\ No newline at end of file
+#include "ast.h"
+#include <cstdlib>
+#include <new>
+#include "../error.h"
+
+namespace {
+
+thread_local NodeArena* current_arena = nullptr;
+
+// Every node is preceded by the arena it came from, null for the heap. Nodes
+// need no more than pointer alignment, which the header keeps.
+constexpr size_t kNodeHeader = sizeof(NodeArena*);
+
+}  // namespace
+
+NodeArena::Scope::Scope(NodeArena* arena) : previous_(current_arena) {
+    current_arena = arena;
+}
+
+NodeArena::Scope::~Scope() {
+    current_arena = previous_;
+}
+
+void* NodeArena::AllocateNode(size_t size) {
+    NodeArena* arena = current_arena;
+    void* block = arena ? arena->memory_.allocate(kNodeHeader + size, alignof(NodeArena*))
+                        : std::malloc(kNodeHeader + size);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *static_cast<NodeArena**>(block) = arena;
+    return static_cast<char*>(block) + kNodeHeader;
+}
+
+void NodeArena::ReleaseNode(void* node) noexcept {
+    if (!node) {
+        return;
+    }
+    void* block = static_cast<char*>(node) - kNodeHeader;
+    if (!*static_cast<NodeArena**>(block)) {
+        std::free(block);
+    }
+}
+
+void ReleaseExpression(std::unique_ptr<Expression> expr) {
+    thread_local std::vector<std::unique_ptr<Expression>>* pending = nullptr;
+    if (!expr) {
+        return;
+    }
+    if (pending) {
+        pending->push_back(std::move(expr));
+        return;
+    }
+    std::vector<std::unique_ptr<Expression>> worklist;
+    pending = &worklist;
+    worklist.push_back(std::move(expr));
+    while (!worklist.empty()) {
+        auto next = std::move(worklist.back());
+        worklist.pop_back();
+        next.reset();
+    }
+    pending = nullptr;
+}
+
+std::unique_ptr<Expression> CloneExpression(const Expression& expr) {
+    if (auto number = dynamic_cast<const NumberExpr*>(&expr)) {
+        return std::make_unique<NumberExpr>(number->value);
+    }
+    if (auto variable = dynamic_cast<const VariableExpr*>(&expr)) {
+        return std::make_unique<VariableExpr>(variable->name);
+    }
+    if (auto binary = dynamic_cast<const BinaryExpr*>(&expr)) {
+        return std::make_unique<BinaryExpr>(binary->op, CloneExpression(*binary->left),
+                                            CloneExpression(*binary->right));
+    }
+    if (auto call = dynamic_cast<const CallExpr*>(&expr)) {
+        std::vector<std::unique_ptr<Expression>> args;
+        args.reserve(call->args.size());
+        for (const auto& arg : call->args) {
+            args.push_back(CloneExpression(*arg));
+        }
+        return std::make_unique<CallExpr>(call->callee, std::move(args));
+    }
+    if (auto ternary = dynamic_cast<const TernaryExpr*>(&expr)) {
+        return std::make_unique<TernaryExpr>(CloneExpression(*ternary->cond),
+                                             CloneExpression(*ternary->then_expr),
+                                             CloneExpression(*ternary->else_expr));
+    }
+    if (auto fused = dynamic_cast<const VarLessConstExpr*>(&expr)) {
+        return std::make_unique<VarLessConstExpr>(fused->name, fused->constant);
+    }
+    if (auto fused = dynamic_cast<const VarSubConstExpr*>(&expr)) {
+        return std::make_unique<VarSubConstExpr>(fused->name, fused->constant);
+    }
+    if (auto fused = dynamic_cast<const CallVarSubConstExpr*>(&expr)) {
+        return std::make_unique<CallVarSubConstExpr>(fused->callee, fused->name, fused->constant);
+    }
+    if (auto fused = dynamic_cast<const IfVarEqConstExpr*>(&expr)) {
+        return std::make_unique<IfVarEqConstExpr>(fused->name, fused->constant,
+                                                  CloneExpression(*fused->then_expr),
+                                                  CloneExpression(*fused->else_expr));
+    }
+    throw RuntimeError("Cannot clone unknown expression node");
+}
+
+FunctionDef::FunctionDef(std::string name, std::vector<std::string> params, std::string body_source,
+                         BodyParser parse)
+    : name(std::move(name)), params(std::move(params)), deferred_(std::make_unique<DeferredBody>()) {
+    deferred_->source = std::move(body_source);
+    deferred_->parse = std::move(parse);
+}
+
+Statement* FunctionDef::Body() const {
+    if (!deferred_) {
+        return body_.get();
+    }
+    if (!deferred_->parsed.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(deferred_->mutex);
+        if (!deferred_->parsed.load(std::memory_order_relaxed)) {
+            deferred_->body = deferred_->parse(deferred_->source);
+            deferred_->parsed.store(true, std::memory_order_release);
+            std::string().swap(deferred_->source);
+            deferred_->parse = nullptr;
+        }
+    }
+    return deferred_->body.get();
+}
+
+bool FunctionDef::IsBodyParsed() const {
+    return !deferred_ || deferred_->parsed.load(std::memory_order_acquire);
+}
+
+std::unique_ptr<Statement> CloneStatement(const Statement& stmt) {
+    if (auto assignment = dynamic_cast<const Assignment*>(&stmt)) {
+        return std::make_unique<Assignment>(assignment->name, CloneExpression(*assignment->value));
+    }
+    if (auto ret = dynamic_cast<const Return*>(&stmt)) {
+        return std::make_unique<Return>(CloneExpression(*ret->value));
+    }
+    if (auto func = dynamic_cast<const FunctionDef*>(&stmt)) {
+        return std::make_unique<FunctionDef>(func->name, func->params, CloneStatement(*func->Body()));
+    }
+    throw RuntimeError("Cannot clone unknown statement node");
+}
+
+size_t CountNodes(const Expression& expr) {
+    if (auto binary = dynamic_cast<const BinaryExpr*>(&expr)) {
+        return 1 + CountNodes(*binary->left) + CountNodes(*binary->right);
+    }
+    if (auto call = dynamic_cast<const CallExpr*>(&expr)) {
+        size_t count = 1;
+        for (const auto& arg : call->args) {
+            count += CountNodes(*arg);
+        }
+        return count;
+    }
+    if (auto ternary = dynamic_cast<const TernaryExpr*>(&expr)) {
+        return 1 + CountNodes(*ternary->cond) + CountNodes(*ternary->then_expr) +
+               CountNodes(*ternary->else_expr);
+    }
+    if (auto fused = dynamic_cast<const IfVarEqConstExpr*>(&expr)) {
+        return 1 + CountNodes(*fused->then_expr) + CountNodes(*fused->else_expr);
+    }
+    return 1;
+}
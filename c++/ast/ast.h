@@ -1,7 +1,11 @@
 #ifndef TOY_LANG_AST
 #define TOY_LANG_AST
 
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <variant>
@@ -9,37 +13,100 @@
 #include <utility>
 #include "../tokenizer/tokenizer.h"
 
+enum class ExprKind {
+    NUMBER,
+    VARIABLE,
+    BINARY,
+    CALL,
+    TERNARY,
+    VAR_LESS_CONST,
+    VAR_SUB_CONST,
+    CALL_VAR_SUB_CONST,
+    IF_VAR_EQ_CONST
+};
+
+// Bump allocator for the nodes of many programs parsed together. While a
+// Scope is open on a thread, the expression and statement nodes created on
+// that thread are carved from the arena; deleting one then only runs its
+// destructor, and the memory is returned all at once with the arena. Nodes
+// created outside a scope, such as by the optimizer passes, come from the
+// heap as usual, and the two kinds mix freely in one tree.
+class NodeArena {
+public:
+    NodeArena() = default;
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    class Scope {
+    public:
+        explicit Scope(NodeArena* arena);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        NodeArena* previous_;
+    };
+
+    static void* AllocateNode(size_t size);
+    static void ReleaseNode(void* node) noexcept;
+
+private:
+    std::pmr::monotonic_buffer_resource memory_;
+};
+
 class Expression {
 public:
+    explicit Expression(ExprKind kind) : kind(kind) {}
     virtual ~Expression() = default;
+    const ExprKind kind;
+
+    static void* operator new(size_t size) { return NodeArena::AllocateNode(size); }
+    static void operator delete(void* node) noexcept { NodeArena::ReleaseNode(node); }
 };
 
+// Destroys an expression tree without recursing on the native stack: nodes
+// with children hand them to this function from their destructors, and only
+// the outermost call drains the queue. Trees of any depth can be released.
+void ReleaseExpression(std::unique_ptr<Expression> expr);
+
 class Statement {
 public:
     virtual ~Statement() = default;
+
+    static void* operator new(size_t size) { return NodeArena::AllocateNode(size); }
+    static void operator delete(void* node) noexcept { NodeArena::ReleaseNode(node); }
 };
 
 class Program {
 public:
+    // Set when nodes of the program live in an arena, which the program then
+    // keeps alive; such nodes must not be moved into a program outliving it.
+    std::shared_ptr<NodeArena> arena;
     std::vector<std::unique_ptr<Statement>> statements;
 };
 
 class NumberExpr : public Expression {
 public:
-    explicit NumberExpr(int value) : value(value) {}
-    int value;
+    explicit NumberExpr(Integer value) : Expression(ExprKind::NUMBER), value(std::move(value)) {}
+    Integer value;
 };
 
 class VariableExpr : public Expression {
 public:
-    explicit VariableExpr(std::string name) : name(std::move(name)) {}
+    explicit VariableExpr(std::string name) : Expression(ExprKind::VARIABLE), name(std::move(name)) {}
     std::string name;
 };
 
 class BinaryExpr : public Expression {
 public:
     BinaryExpr(OperatorToken op, std::unique_ptr<Expression> left, std::unique_ptr<Expression> right)
-        : op(op), left(std::move(left)), right(std::move(right)) {}
+        : Expression(ExprKind::BINARY), op(op), left(std::move(left)), right(std::move(right)) {}
+    ~BinaryExpr() override {
+        ReleaseExpression(std::move(left));
+        ReleaseExpression(std::move(right));
+    }
     OperatorToken op;
     std::unique_ptr<Expression> left;
     std::unique_ptr<Expression> right;
@@ -48,7 +115,12 @@ public:
 class CallExpr : public Expression {
 public:
     CallExpr(std::string callee, std::vector<std::unique_ptr<Expression>> args)
-        : callee(std::move(callee)), args(std::move(args)) {}
+        : Expression(ExprKind::CALL), callee(std::move(callee)), args(std::move(args)) {}
+    ~CallExpr() override {
+        for (auto& arg : args) {
+            ReleaseExpression(std::move(arg));
+        }
+    }
     std::string callee;
     std::vector<std::unique_ptr<Expression>> args;
 };
@@ -56,12 +128,67 @@ public:
 class TernaryExpr : public Expression {
 public:
     TernaryExpr(std::unique_ptr<Expression> cond, std::unique_ptr<Expression> then_expr, std::unique_ptr<Expression> else_expr)
-        : cond(std::move(cond)), then_expr(std::move(then_expr)), else_expr(std::move(else_expr)) {}
+        : Expression(ExprKind::TERNARY), cond(std::move(cond)), then_expr(std::move(then_expr)),
+          else_expr(std::move(else_expr)) {}
+    ~TernaryExpr() override {
+        ReleaseExpression(std::move(cond));
+        ReleaseExpression(std::move(then_expr));
+        ReleaseExpression(std::move(else_expr));
+    }
     std::unique_ptr<Expression> cond;
     std::unique_ptr<Expression> then_expr;
     std::unique_ptr<Expression> else_expr;
 };
 
+// Fused forms of frequent shapes, produced by FuseExpressions. Operands are
+// stored inline so an evaluator handles the whole shape in one dispatch.
+
+// name < constant
+class VarLessConstExpr : public Expression {
+public:
+    VarLessConstExpr(std::string name, Integer constant)
+        : Expression(ExprKind::VAR_LESS_CONST), name(std::move(name)), constant(std::move(constant)) {}
+    std::string name;
+    Integer constant;
+};
+
+// name - constant
+class VarSubConstExpr : public Expression {
+public:
+    VarSubConstExpr(std::string name, Integer constant)
+        : Expression(ExprKind::VAR_SUB_CONST), name(std::move(name)), constant(std::move(constant)) {}
+    std::string name;
+    Integer constant;
+};
+
+// callee(name - constant)
+class CallVarSubConstExpr : public Expression {
+public:
+    CallVarSubConstExpr(std::string callee, std::string name, Integer constant)
+        : Expression(ExprKind::CALL_VAR_SUB_CONST), callee(std::move(callee)), name(std::move(name)),
+          constant(std::move(constant)) {}
+    std::string callee;
+    std::string name;
+    Integer constant;
+};
+
+// if name == constant then then_expr else else_expr
+class IfVarEqConstExpr : public Expression {
+public:
+    IfVarEqConstExpr(std::string name, Integer constant, std::unique_ptr<Expression> then_expr,
+                     std::unique_ptr<Expression> else_expr)
+        : Expression(ExprKind::IF_VAR_EQ_CONST), name(std::move(name)), constant(std::move(constant)),
+          then_expr(std::move(then_expr)), else_expr(std::move(else_expr)) {}
+    ~IfVarEqConstExpr() override {
+        ReleaseExpression(std::move(then_expr));
+        ReleaseExpression(std::move(else_expr));
+    }
+    std::string name;
+    Integer constant;
+    std::unique_ptr<Expression> then_expr;
+    std::unique_ptr<Expression> else_expr;
+};
+
 class Assignment : public Statement {
 public:
     Assignment(std::string name, std::unique_ptr<Expression> value)
@@ -78,11 +205,38 @@ public:
 
 class FunctionDef : public Statement {
 public:
+    using BodyParser = std::function<std::unique_ptr<Statement>(const std::string& source)>;
+
     FunctionDef(std::string name, std::vector<std::string> params, std::unique_ptr<Statement> body)
-        : name(std::move(name)), params(std::move(params)), body(std::move(body)) {}
+        : name(std::move(name)), params(std::move(params)), body_(std::move(body)) {}
+
+    // A def whose body is kept as source text and handed to `parse` on the
+    // first call of Body().
+    FunctionDef(std::string name, std::vector<std::string> params, std::string body_source, BodyParser parse);
+
+    // The body, parsing a deferred one first. Safe to call concurrently; a
+    // body that fails to parse throws on every call.
+    Statement* Body() const;
+    bool IsBodyParsed() const;
+
     std::string name;
     std::vector<std::string> params;
-    std::unique_ptr<Statement> body;
+
+private:
+    struct DeferredBody {
+        std::mutex mutex;
+        std::atomic<bool> parsed{false};
+        std::string source;
+        BodyParser parse;
+        std::unique_ptr<Statement> body;
+    };
+
+    std::unique_ptr<Statement> body_;  // eagerly parsed bodies only
+    std::unique_ptr<DeferredBody> deferred_;
 };
 
+std::unique_ptr<Expression> CloneExpression(const Expression& expr);
+std::unique_ptr<Statement> CloneStatement(const Statement& stmt);
+size_t CountNodes(const Expression& expr);
+
 #endif // TOY_LANG_AST 
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include "async_evaluator.h"
+#include <map>
+#include "../interpreter/interpreter.h"
+
+// Suspends the awaiting coroutine until dispatch() has run the call.
+struct AsyncEvaluator::HostCall {
+    HostCall(AsyncEvaluator& evaluator, const std::string& name, std::vector<Integer> args)
+        : evaluator(evaluator), name(name), args(std::move(args)) {}
+
+    AsyncEvaluator& evaluator;
+    const std::string& name;
+    std::vector<Integer> args;
+    Integer result;
+    std::exception_ptr error;
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        evaluator.pending_.push_back(PendingCall{&name, std::move(args), handle, &result, &error});
+    }
+
+    Integer await_resume() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(result);
+    }
+};
+
+void AsyncEvaluator::RegisterHost(std::string name, size_t arity, HostFunction function) {
+    hosts_[std::move(name)] = Host{arity, std::move(function)};
+}
+
+std::vector<AsyncResult> AsyncEvaluator::RunBatch(const std::vector<const Program*>& programs) {
+    std::vector<Script> scripts;
+    scripts.reserve(programs.size());
+    std::vector<Task<std::optional<Integer>>> tasks;
+    tasks.reserve(programs.size());
+    for (const Program* program : programs) {
+        scripts.push_back(Script{program, {}, {}});
+        tasks.push_back(run(scripts.back()));
+        tasks.back().Start();
+    }
+    while (!pending_.empty()) {
+        dispatch();
+    }
+
+    std::vector<AsyncResult> results(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        try {
+            results[i].value = tasks[i].Result();
+        } catch (...) {
+            results[i].error = std::current_exception();
+        }
+    }
+    return results;
+}
+
+const AsyncStats& AsyncEvaluator::Stats() const {
+    return stats_;
+}
+
+void AsyncEvaluator::dispatch() {
+    std::vector<PendingCall> calls = std::move(pending_);
+    pending_.clear();
+
+    std::map<std::string, std::vector<size_t>> groups;
+    for (size_t i = 0; i < calls.size(); ++i) {
+        groups[*calls[i].name].push_back(i);
+    }
+    for (const auto& [name, indices] : groups) {
+        std::vector<std::vector<Integer>> args;
+        args.reserve(indices.size());
+        for (size_t index : indices) {
+            args.push_back(std::move(calls[index].args));
+        }
+        ++stats_.batches;
+        stats_.host_calls += indices.size();
+        try {
+            std::vector<Integer> results = hosts_.at(name).function(args);
+            if (results.size() != indices.size()) {
+                throw RuntimeError("Host function '" + name + "' returned " + std::to_string(results.size()) +
+                                   " results for " + std::to_string(indices.size()) + " calls");
+            }
+            for (size_t i = 0; i < indices.size(); ++i) {
+                *calls[indices[i]].result = std::move(results[i]);
+            }
+        } catch (...) {
+            for (size_t index : indices) {
+                *calls[index].error = std::current_exception();
+            }
+        }
+    }
+
+    // Resumed programs run until their next host call or completion; new
+    // calls land in pending_ for the next round.
+    for (const auto& call : calls) {
+        call.handle.resume();
+    }
+}
+
+Task<std::optional<Integer>> AsyncEvaluator::run(Script& script) {
+    for (const auto& stmt : script.program->statements) {
+        if (auto func = dynamic_cast<const FunctionDef*>(stmt.get())) {
+            script.functions[func->name] = func;
+        } else if (auto assignment = dynamic_cast<const Assignment*>(stmt.get())) {
+            script.globals[assignment->name] = co_await eval(script, *assignment->value, nullptr);
+        } else if (auto ret = dynamic_cast<const Return*>(stmt.get())) {
+            co_return co_await eval(script, *ret->value, nullptr);
+        }
+    }
+    co_return std::nullopt;
+}
+
+Task<Integer> AsyncEvaluator::eval(Script& script, const Expression& expr, Frame* frame) {
+    switch (expr.kind) {
+        case ExprKind::NUMBER:
+            co_return static_cast<const NumberExpr&>(expr).value;
+        case ExprKind::VARIABLE:
+            co_return lookup(script, static_cast<const VariableExpr&>(expr).name, frame);
+        case ExprKind::BINARY: {
+            const auto& binary = static_cast<const BinaryExpr&>(expr);
+            Integer left = co_await eval(script, *binary.left, frame);
+            Integer right = co_await eval(script, *binary.right, frame);
+            co_return ApplyOperator(binary.op, left, right);
+        }
+        case ExprKind::TERNARY: {
+            const auto& ternary = static_cast<const TernaryExpr&>(expr);
+            if (!(co_await eval(script, *ternary.cond, frame)).IsZero()) {
+                co_return co_await eval(script, *ternary.then_expr, frame);
+            }
+            co_return co_await eval(script, *ternary.else_expr, frame);
+        }
+        case ExprKind::CALL: {
+            const auto& call_expr = static_cast<const CallExpr&>(expr);
+            const FunctionDef* func = resolve(script, call_expr.callee, call_expr.args.size());
+            std::vector<Integer> args;
+            args.reserve(call_expr.args.size());
+            for (const auto& arg : call_expr.args) {
+                args.push_back(co_await eval(script, *arg, frame));
+            }
+            co_return co_await call(script, func, call_expr.callee, std::move(args));
+        }
+        case ExprKind::VAR_LESS_CONST: {
+            const auto& fused = static_cast<const VarLessConstExpr&>(expr);
+            co_return Integer(lookup(script, fused.name, frame) < fused.constant);
+        }
+        case ExprKind::VAR_SUB_CONST: {
+            const auto& fused = static_cast<const VarSubConstExpr&>(expr);
+            co_return lookup(script, fused.name, frame) - fused.constant;
+        }
+        case ExprKind::CALL_VAR_SUB_CONST: {
+            const auto& fused = static_cast<const CallVarSubConstExpr&>(expr);
+            const FunctionDef* func = resolve(script, fused.callee, 1);
+            std::vector<Integer> args{lookup(script, fused.name, frame) - fused.constant};
+            co_return co_await call(script, func, fused.callee, std::move(args));
+        }
+        case ExprKind::IF_VAR_EQ_CONST: {
+            const auto& fused = static_cast<const IfVarEqConstExpr&>(expr);
+            if (lookup(script, fused.name, frame) == fused.constant) {
+                co_return co_await eval(script, *fused.then_expr, frame);
+            }
+            co_return co_await eval(script, *fused.else_expr, frame);
+        }
+    }
+    throw RuntimeError("Unknown expression node");
+}
+
+const FunctionDef* AsyncEvaluator::resolve(const Script& script, const std::string& callee, size_t arity) const {
+    size_t expected = 0;
+    const FunctionDef* func = nullptr;
+    auto defined = script.functions.find(callee);
+    if (defined != script.functions.end()) {
+        func = defined->second;
+        expected = func->params.size();
+    } else {
+        auto host = hosts_.find(callee);
+        if (host == hosts_.end()) {
+            throw NameError("Undefined function: " + callee);
+        }
+        expected = host->second.arity;
+    }
+    if (expected != arity) {
+        throw RuntimeError("Function '" + callee + "' expects " + std::to_string(expected) +
+                           " arguments, got " + std::to_string(arity));
+    }
+    return func;
+}
+
+Task<Integer> AsyncEvaluator::call(Script& script, const FunctionDef* func, const std::string& callee,
+                                   std::vector<Integer> args) {
+    if (!func) {
+        HostCall host_call(*this, hosts_.find(callee)->first, std::move(args));
+        co_return co_await host_call;
+    }
+    Frame frame;
+    for (size_t i = 0; i < args.size(); ++i) {
+        frame[func->params[i]] = std::move(args[i]);
+    }
+    const Statement* body = func->Body();
+    if (auto ret = dynamic_cast<const Return*>(body)) {
+        co_return co_await eval(script, *ret->value, &frame);
+    }
+    if (auto assignment = dynamic_cast<const Assignment*>(body)) {
+        co_return co_await eval(script, *assignment->value, &frame);
+    }
+    throw RuntimeError("Function '" + func->name + "' does not return a value");
+}
+
+Integer AsyncEvaluator::lookup(const Script& script, const std::string& name, const Frame* frame) const {
+    if (frame) {
+        auto it = frame->find(name);
+        if (it != frame->end()) {
+            return it->second;
+        }
+    }
+    auto it = script.globals.find(name);
+    if (it == script.globals.end()) {
+        throw NameError("Undefined variable: " + name);
+    }
+    return it->second;
+}
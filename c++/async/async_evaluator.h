@@ -0,0 +1,81 @@
+#ifndef TOY_LANG_ASYNC_EVALUATOR
+#define TOY_LANG_ASYNC_EVALUATOR
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "task.h"
+#include "../ast/ast.h"
+#include "../error.h"
+
+// A host function receives the argument lists of every call collected in one
+// round and returns one result per call, in order.
+using HostFunction = std::function<std::vector<Integer>(const std::vector<std::vector<Integer>>& calls)>;
+
+struct AsyncResult {
+    std::optional<Integer> value;  // as Interpreter::Run would return it
+    std::exception_ptr error;
+};
+
+struct AsyncStats {
+    size_t host_calls = 0;
+    size_t batches = 0;
+};
+
+// Evaluates many programs at once as coroutines. A call to a host function
+// suspends its program; when no program can make progress, the pending calls
+// are grouped per host function, each group is dispatched as one batched
+// call, and the suspended programs resume with the results.
+//
+// Each program sees Interpreter semantics with its own globals and
+// functions; a name defined by the program shadows a host function.
+class AsyncEvaluator {
+public:
+    void RegisterHost(std::string name, size_t arity, HostFunction function);
+
+    std::vector<AsyncResult> RunBatch(const std::vector<const Program*>& programs);
+
+    const AsyncStats& Stats() const;
+
+private:
+    using Frame = std::unordered_map<std::string, Integer>;
+
+    struct Host {
+        size_t arity;
+        HostFunction function;
+    };
+
+    struct Script {
+        const Program* program;
+        std::unordered_map<std::string, Integer> globals;
+        std::unordered_map<std::string, const FunctionDef*> functions;
+    };
+
+    struct PendingCall {
+        const std::string* name;
+        std::vector<Integer> args;
+        std::coroutine_handle<> handle;
+        Integer* result;
+        std::exception_ptr* error;
+    };
+
+    struct HostCall;
+
+    std::unordered_map<std::string, Host> hosts_;
+    std::vector<PendingCall> pending_;
+    AsyncStats stats_;
+
+    Task<std::optional<Integer>> run(Script& script);
+    Task<Integer> eval(Script& script, const Expression& expr, Frame* frame);
+    const FunctionDef* resolve(const Script& script, const std::string& callee, size_t arity) const;
+    Task<Integer> call(Script& script, const FunctionDef* func, const std::string& callee,
+                       std::vector<Integer> args);
+    Integer lookup(const Script& script, const std::string& name, const Frame* frame) const;
+    void dispatch();
+};
+
+#endif // TOY_LANG_ASYNC_EVALUATOR
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "async_evaluator.h"
+#include "../interpreter/interpreter.h"
+#include "../parser/parser.h"
+
+class AsyncEvaluatorTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Program> parse(const std::string& source) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        return parser.Parse();
+    }
+
+    // Host stub: lookup(k) = 10 * k, recording the size of every batch.
+    void registerLookup(AsyncEvaluator& evaluator) {
+        evaluator.RegisterHost("lookup", 1, [this](const std::vector<std::vector<Integer>>& calls) {
+            batch_sizes_.push_back(calls.size());
+            std::vector<Integer> results;
+            for (const auto& args : calls) {
+                results.push_back(args[0] * 10);
+            }
+            return results;
+        });
+    }
+
+    std::vector<size_t> batch_sizes_;
+};
+
+TEST_F(AsyncEvaluatorTest, MatchesInterpreterWithoutHostCalls) {
+    auto program = parse(
+        "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\n"
+        "x = fib(12)\n"
+        "return x * 2\n");
+    AsyncEvaluator evaluator;
+    auto results = evaluator.RunBatch({program.get()});
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_FALSE(results[0].error);
+    EXPECT_EQ(results[0].value, Interpreter().Run(*program));
+    EXPECT_EQ(evaluator.Stats().batches, 0u);
+}
+
+TEST_F(AsyncEvaluatorTest, BatchesCallsAcrossPrograms) {
+    std::vector<std::unique_ptr<Program>> programs;
+    std::vector<const Program*> batch;
+    for (int i = 0; i < 8; ++i) {
+        programs.push_back(parse("x = lookup(" + std::to_string(i) + ")\nreturn x + lookup(x)\n"));
+        batch.push_back(programs.back().get());
+    }
+    AsyncEvaluator evaluator;
+    registerLookup(evaluator);
+    auto results = evaluator.RunBatch(batch);
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_EQ(results[i].value, 10 * i + 100 * i);
+    }
+    EXPECT_EQ(batch_sizes_, (std::vector<size_t>{8, 8}));
+    EXPECT_EQ(evaluator.Stats().host_calls, 16u);
+}
+
+TEST_F(AsyncEvaluatorTest, SuspendsInsideUserFunctions) {
+    auto first = parse("def sum(n) return if n == 0 then 0 else lookup(n) + sum(n - 1)\nreturn sum(3)\n");
+    auto second = parse("def f(a, b) return lookup(a) * b\nreturn f(2, 3)\n");
+    AsyncEvaluator evaluator;
+    registerLookup(evaluator);
+    auto results = evaluator.RunBatch({first.get(), second.get()});
+    EXPECT_EQ(results[0].value, 60);
+    EXPECT_EQ(results[1].value, 60);
+    EXPECT_EQ(batch_sizes_, (std::vector<size_t>{2, 1, 1}));
+}
+
+TEST_F(AsyncEvaluatorTest, ReportsErrorsPerProgram) {
+    auto ok = parse("return lookup(1)\n");
+    auto missing = parse("return nothing(1)\n");
+    auto arity = parse("return lookup(1, 2)\n");
+    auto failing = parse("return fail(1)\n");
+    AsyncEvaluator evaluator;
+    registerLookup(evaluator);
+    evaluator.RegisterHost("fail", 1, [](const std::vector<std::vector<Integer>>&) -> std::vector<Integer> {
+        throw RuntimeError("feature store unavailable");
+    });
+    auto results = evaluator.RunBatch({ok.get(), missing.get(), arity.get(), failing.get()});
+    EXPECT_EQ(results[0].value, 10);
+    EXPECT_THROW(std::rethrow_exception(results[1].error), NameError);
+    EXPECT_THROW(std::rethrow_exception(results[2].error), RuntimeError);
+    EXPECT_THROW(std::rethrow_exception(results[3].error), RuntimeError);
+}
+
+TEST_F(AsyncEvaluatorTest, ProgramFunctionsShadowHosts) {
+    auto program = parse("def lookup(k) return k + 1\nreturn lookup(1)\n");
+    AsyncEvaluator evaluator;
+    registerLookup(evaluator);
+    EXPECT_EQ(evaluator.RunBatch({program.get()})[0].value, 2);
+    EXPECT_TRUE(batch_sizes_.empty());
+}
@@ -0,0 +1,50 @@
+#include <filesystem>
+#include <sstream>
+#include "bench.h"
+#include "../aot/aot_compiler.h"
+#include "../compiler/closure_compiler.h"
+#include "../parser/parser.h"
+#include "../vm/vm.h"
+
+// Steady-state run time of natively compiled programs against the closure
+// compiler and the bytecode VM, plus the one-off cost of building a shared
+// object and of loading it from the cache.
+
+namespace {
+
+std::unique_ptr<Program> parse(const char* source) {
+    std::stringstream ss(source);
+    Parser parser(&ss);
+    return parser.Parse();
+}
+
+void run(const char* name, const char* source) {
+    auto program = parse(source);
+    ClosureProgram closure(*program);
+    Report(std::string(name) + "/closure", Measure([&] { DoNotOptimize(closure.Run()); }));
+    BytecodeProgram bytecode(*program);
+    Report(std::string(name) + "/bytecode", Measure([&] { DoNotOptimize(bytecode.Run()); }));
+    AotProgram native(*program);
+    Report(std::string(name) + "/aot", Measure([&] { DoNotOptimize(native.Run()); }));
+}
+
+}  // namespace
+
+int main() {
+    using Clock = std::chrono::steady_clock;
+    AotOptions options;
+    options.cache_dir = "/tmp/toy_lang_aot_bench_" + std::to_string(Clock::now().time_since_epoch().count());
+    auto program = parse("def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\nreturn fib(25)\n");
+    auto start = Clock::now();
+    AotProgram cold(*program, options);
+    Report("build/cold", BenchResult{std::chrono::duration<double>(Clock::now() - start).count(), 1});
+    Report("build/cached", Measure([&] { AotProgram compiled(*program, options); }));
+    std::filesystem::remove_all(options.cache_dir);
+
+    run("fib", "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\nreturn fib(25)\n");
+    run("gcd",
+        "def gcd(a, b) return if b == 0 then a else gcd(b, a - a / b * b)\n"
+        "def loop(n, acc) return if n == 0 then acc else loop(n - 1, acc + gcd(n * 7919, 104729))\n"
+        "return loop(2000, 0)\n");
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include "bench.h"
+#include "../async/async_evaluator.h"
+#include "../parser/parser.h"
+
+// Scripts making host calls against a stub with a fixed per-dispatch latency:
+// throughput as a function of how many scripts share one batch.
+
+namespace {
+
+std::unique_ptr<Program> parse(const std::string& source) {
+    std::stringstream ss(source);
+    Parser parser(&ss);
+    return parser.Parse();
+}
+
+}  // namespace
+
+int main() {
+    AsyncEvaluator evaluator;
+    evaluator.RegisterHost("feature", 1, [](const std::vector<std::vector<Integer>>& calls) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        std::vector<Integer> results;
+        for (const auto& args : calls) {
+            results.push_back(args[0] + 1);
+        }
+        return results;
+    });
+
+    const size_t scripts = 256;
+    std::vector<std::unique_ptr<Program>> programs;
+    for (size_t i = 0; i < scripts; ++i) {
+        programs.push_back(parse("a = feature(" + std::to_string(i) + ")\nreturn feature(a) * 2\n"));
+    }
+    for (size_t batch = 1; batch <= scripts; batch *= 4) {
+        auto result = Measure([&] {
+            for (size_t first = 0; first < scripts; first += batch) {
+                std::vector<const Program*> group;
+                for (size_t i = first; i < first + batch && i < scripts; ++i) {
+                    group.push_back(programs[i].get());
+                }
+                DoNotOptimize(evaluator.RunBatch(group));
+            }
+        });
+        Report("batch/" + std::to_string(batch), result);
+    }
+    return 0;
+}
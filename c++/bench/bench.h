@@ -0,0 +1,208 @@
+#ifndef TOY_LANG_BENCH
+#define TOY_LANG_BENCH
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <initializer_list>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Minimal timing harness shared by the benchmark executables.
+
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchResult {
+    double seconds = 0;
+    size_t iterations = 0;
+
+    double NanosPerIteration() const { return iterations == 0 ? 0 : seconds * 1e9 / iterations; }
+};
+
+// Runs fn until at least min_seconds have elapsed, doubling the batch size.
+template <typename Fn>
+BenchResult Measure(Fn&& fn, double min_seconds = 0.2) {
+    using Clock = std::chrono::steady_clock;
+    BenchResult result;
+    size_t batch = 1;
+    while (result.seconds < min_seconds) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < batch; ++i) {
+            fn();
+        }
+        result.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+        result.iterations += batch;
+        batch *= 2;
+    }
+    return result;
+}
+
+inline void Report(const std::string& name, const BenchResult& result) {
+    std::printf("%-40s %12.1f ns/iter %10zu iters\n", name.c_str(), result.NanosPerIteration(),
+                result.iterations);
+}
+
+// Hardware counters of the calling thread, read through perf_event_open.
+// Each event is opened on its own, so one the kernel refuses (containers,
+// perf_event_paranoid, virtual machines, other systems) is simply missing.
+// Values are scaled up when the kernel had to multiplex the counters.
+class PerfCounters {
+public:
+    enum Event { CYCLES, INSTRUCTIONS, BRANCH_MISSES, L1D_MISSES, LLC_MISSES, EVENT_COUNT };
+
+    PerfCounters() {
+#ifdef __linux__
+        const std::pair<uint32_t, uint64_t> events[EVENT_COUNT] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        };
+        for (int i = 0; i < EVENT_COUNT; ++i) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = events[i].first;
+            attr.config = events[i].second;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool Available() const {
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Start() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void Stop() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+#endif
+    }
+
+    std::optional<double> Value(Event event) const {
+#ifdef __linux__
+        uint64_t data[3];  // value, time enabled, time running
+        if (fds_[event] >= 0 && read(fds_[event], data, sizeof(data)) == sizeof(data) && data[2] > 0) {
+            return static_cast<double>(data[0]) * data[1] / data[2];
+        }
+#endif
+        (void)event;
+        return std::nullopt;
+    }
+
+private:
+    int fds_[EVENT_COUNT] = {-1, -1, -1, -1, -1};
+};
+
+// Set TOY_LANG_PERF=1 to have ReportCounters collect hardware counters.
+inline bool PerfRequested() {
+    const char* value = std::getenv("TOY_LANG_PERF");
+    return value && *value && std::string(value) != "0";
+}
+
+// When requested, runs fn `iterations` times under PerfCounters and prints
+// the counters per unit of work of one iteration, one line per unit given
+// (for example {{"byte", 81000}, {"token", 21000}}). Missing counters print
+// as "-".
+template <typename Fn>
+void ReportCounters(const std::string& name, Fn&& fn, std::initializer_list<std::pair<const char*, double>> units,
+                    size_t iterations = 10) {
+    if (!PerfRequested()) {
+        return;
+    }
+    PerfCounters counters;
+    if (!counters.Available()) {
+        std::printf("%-40s hardware counters unavailable\n", name.c_str());
+        return;
+    }
+    fn();  // warm up caches and allocators outside the measured region
+    counters.Start();
+    for (size_t i = 0; i < iterations; ++i) {
+        fn();
+    }
+    counters.Stop();
+
+    auto format = [](std::optional<double> value, double per, char* out, size_t size) {
+        if (value) {
+            std::snprintf(out, size, "%.3f", *value / per);
+        } else {
+            std::snprintf(out, size, "-");
+        }
+    };
+    auto cycles = counters.Value(PerfCounters::CYCLES);
+    auto instructions = counters.Value(PerfCounters::INSTRUCTIONS);
+    char ipc[32];
+    format(cycles && instructions ? std::optional<double>(*instructions) : std::nullopt,
+           cycles && *cycles > 0 ? *cycles : 1, ipc, sizeof(ipc));
+    for (const auto& [unit, count] : units) {
+        double per = count * iterations;
+        char values[PerfCounters::EVENT_COUNT][32];
+        for (int i = 0; i < PerfCounters::EVENT_COUNT; ++i) {
+            format(counters.Value(static_cast<PerfCounters::Event>(i)), per, values[i], sizeof(values[i]));
+        }
+        std::printf("%-40s per %-5s cycles %s instr %s br-miss %s l1d-miss %s llc-miss %s ipc %s\n",
+                    name.c_str(), unit, values[PerfCounters::CYCLES], values[PerfCounters::INSTRUCTIONS],
+                    values[PerfCounters::BRANCH_MISSES], values[PerfCounters::L1D_MISSES],
+                    values[PerfCounters::LLC_MISSES], ipc);
+    }
+}
+
+inline std::string ReadFile(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+#endif // TOY_LANG_BENCH
@@ -0,0 +1,36 @@
+#include <sstream>
+#include "bench.h"
+#include "../cache/program_cache.h"
+#include "../parser/parser.h"
+
+// Front-end cost of a repeated script: parsing every time versus a cache hit.
+
+namespace {
+
+std::string makeScript(size_t functions) {
+    std::string source;
+    for (size_t i = 0; i < functions; ++i) {
+        std::string name = "f" + std::to_string(i);
+        source += "def " + name + "(n, m) return if n < 2 then n * m else " + name + "(n - 1, m + 3) / 2\n";
+        source += "x" + std::to_string(i) + " = " + name + "(10, " + std::to_string(i) + ")\n";
+    }
+    return source + "return x0\n";
+}
+
+void run(const char* name, const std::string& source) {
+    Report(std::string(name) + "/parse", Measure([&] {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        DoNotOptimize(parser.Parse());
+    }));
+    ProgramCache cache(64 << 20);
+    Report(std::string(name) + "/cached", Measure([&] { DoNotOptimize(cache.Get(source)); }));
+}
+
+}  // namespace
+
+int main() {
+    run("small", makeScript(1));
+    run("large", makeScript(200));
+    return 0;
+}
@@ -0,0 +1,34 @@
+#include <sstream>
+#include "bench.h"
+#include "../compiler/closure_compiler.h"
+#include "../interpreter/interpreter.h"
+#include "../optimizer/fusion.h"
+#include "../parser/parser.h"
+
+// Compares the tree-walking interpreter with closure-compiled programs.
+
+namespace {
+
+std::unique_ptr<Program> parse(const char* source) {
+    std::stringstream ss(source);
+    Parser parser(&ss);
+    return parser.Parse();
+}
+
+void run(const char* name, const char* source) {
+    auto program = parse(source);
+    Report(std::string(name) + "/interpreter", Measure([&] { DoNotOptimize(Interpreter().Run(*program)); }));
+    ClosureProgram compiled(*program);
+    Report(std::string(name) + "/closure", Measure([&] { DoNotOptimize(compiled.Run()); }));
+    FuseExpressions(*program);
+    ClosureProgram fused(*program);
+    Report(std::string(name) + "/closure+fused", Measure([&] { DoNotOptimize(fused.Run()); }));
+}
+
+}  // namespace
+
+int main() {
+    run("fib", "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\nreturn fib(20)\n");
+    run("sum", "def sum(n) return if n == 0 then 0 else n + sum(n - 1)\nreturn sum(5000)\n");
+    return 0;
+}
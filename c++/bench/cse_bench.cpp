@@ -0,0 +1,67 @@
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bench.h"
+#include "../interpreter/interpreter.h"
+#include "../optimizer/cse.h"
+#include "../parser/parser.h"
+
+// Usage: cse_bench [script...]
+// Prints dedup ratios and tree vs. DAG evaluation time for every script, or
+// for a small built-in corpus when no files are given.
+
+namespace {
+
+std::vector<std::pair<std::string, std::string>> builtinCorpus() {
+    return {
+        {"square_sum",
+         "def f(a, b) return (a + b) * (a + b) + (a + b) * (a - b)\n"
+         "def loop(n, acc) return if n == 0 then acc else loop(n - 1, acc + f(n, acc / 7))\n"
+         "return loop(2000, 1)\n"},
+        {"ternary_arms",
+         "def w(x) return x * x - 3 * x + 1\n"
+         "def g(n) return if n < 50 then w(n + 1) - w(n) else w(n + 1) + w(n)\n"
+         "def loop(n, acc) return if n == 0 then acc else loop(n - 1, acc + g(n))\n"
+         "return loop(2000, 0)\n"},
+        {"no_sharing",
+         "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\n"
+         "return fib(18)\n"},
+    };
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    auto corpus = builtinCorpus();
+    if (argc > 1) {
+        corpus.clear();
+        for (int i = 1; i < argc; ++i) {
+            corpus.emplace_back(argv[i], ReadFile(argv[i]));
+        }
+    }
+
+    size_t total_tree = 0;
+    size_t total_dag = 0;
+    for (const auto& [name, source] : corpus) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        auto program = parser.Parse();
+        CseInterpreter cse(*program);
+        total_tree += cse.Stats().tree_nodes;
+        total_dag += cse.Stats().dag_nodes;
+        std::printf("%s: %zu tree nodes, %zu dag nodes, dedup ratio %.2f\n", name.c_str(),
+                    cse.Stats().tree_nodes, cse.Stats().dag_nodes, cse.Stats().DedupRatio());
+
+        Report(name + "/tree", Measure([&] {
+            Interpreter interpreter;
+            DoNotOptimize(interpreter.Run(*program));
+        }));
+        Report(name + "/dag", Measure([&] { DoNotOptimize(cse.Run()); }));
+    }
+    CseStats total{total_tree, total_dag};
+    std::printf("corpus: %zu tree nodes, %zu dag nodes, dedup ratio %.2f\n", total_tree, total_dag,
+                total.DedupRatio());
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include <sstream>
+#include "bench.h"
+#include "../compiler/closure_compiler.h"
+#include "../optimizer/dead_code.h"
+#include "../parser/parser.h"
+
+// Loads a large prelude of helpers and tables of which the entry point uses a
+// handful, and compares pruning it against compiling it whole.
+
+namespace {
+
+std::string prelude(size_t helpers) {
+    std::string source;
+    for (size_t i = 0; i < helpers; ++i) {
+        std::string name = "h" + std::to_string(i);
+        std::string prev = i == 0 ? "" : "h" + std::to_string(i - 1);
+        source += "def " + name + "(x) return " + (i % 8 == 0 ? std::string("x + 1") : prev + "(x) * 3 / 2") + "\n";
+        source += "t" + std::to_string(i) + " = " + name + "(" + std::to_string(i % 100) + ")\n";
+    }
+    return source + "return h12(t3) + h5(t12)\n";
+}
+
+std::unique_ptr<Program> parse(const std::string& source, ParserOptions options = {}) {
+    std::stringstream ss(source);
+    Parser parser(&ss, options);
+    return parser.Parse();
+}
+
+}  // namespace
+
+int main() {
+    std::string source = prelude(2000);
+    auto whole = parse(source);
+    auto pruned = parse(source);
+    auto report = DeadCodeEliminator().Run(*pruned);
+    std::printf("prelude: %zu statements, %zu kept, %zu defs and %zu assignments pruned\n",
+                whole->statements.size(), pruned->statements.size(), report.functions.size(),
+                report.assignments.size());
+    Report("parse", Measure([&] { DoNotOptimize(parse(source)); }));
+    Report("parse-prune", Measure([&] {
+        auto program = parse(source);
+        DoNotOptimize(DeadCodeEliminator().Run(*program));
+    }));
+    Report("parse-prune/lazy", Measure([&] {
+        auto program = parse(source, ParserOptions{true});
+        DoNotOptimize(DeadCodeEliminator().Run(*program));
+    }));
+    Report("compile/whole", Measure([&] { DoNotOptimize(ClosureProgram(*whole)); }));
+    Report("compile/pruned", Measure([&] { DoNotOptimize(ClosureProgram(*pruned)); }));
+    ClosureProgram whole_closure(*whole);
+    ClosureProgram pruned_closure(*pruned);
+    Report("run/whole", Measure([&] { DoNotOptimize(whole_closure.Run()); }));
+    Report("run/pruned", Measure([&] { DoNotOptimize(pruned_closure.Run()); }));
+    return 0;
+}
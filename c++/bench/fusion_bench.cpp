@@ -0,0 +1,46 @@
+#include <cstdio>
+#include <sstream>
+#include "bench.h"
+#include "../interpreter/interpreter.h"
+#include "../optimizer/fusion.h"
+#include "../parser/parser.h"
+
+// Evaluates recursive scripts with and without fused expression nodes.
+
+namespace {
+
+std::unique_ptr<Program> parse(const char* source) {
+    std::stringstream ss(source);
+    Parser parser(&ss);
+    return parser.Parse();
+}
+
+size_t countNodes(const Program& program) {
+    size_t count = 0;
+    for (const auto& stmt : program.statements) {
+        auto func = dynamic_cast<const FunctionDef*>(stmt.get());
+        auto ret = func ? dynamic_cast<const Return*>(func->Body()) : nullptr;
+        if (ret) {
+            count += CountNodes(*ret->value);
+        }
+    }
+    return count;
+}
+
+void run(const char* name, const char* source) {
+    auto plain = parse(source);
+    auto fused = parse(source);
+    size_t created = FuseExpressions(*fused);
+    std::printf("%s: %zu fused nodes, function body nodes %zu -> %zu\n", name, created,
+                countNodes(*plain), countNodes(*fused));
+    Report(std::string(name) + "/plain", Measure([&] { DoNotOptimize(Interpreter().Run(*plain)); }));
+    Report(std::string(name) + "/fused", Measure([&] { DoNotOptimize(Interpreter().Run(*fused)); }));
+}
+
+}  // namespace
+
+int main() {
+    run("fib", "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\nreturn fib(20)\n");
+    run("sum", "def sum(n) return if n == 0 then 0 else n + sum(n - 1)\nreturn sum(5000)\n");
+    return 0;
+}
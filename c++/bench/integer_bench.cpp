@@ -0,0 +1,62 @@
+#include <cstdint>
+#include <vector>
+#include "bench.h"
+#include "../integer/integer.h"
+
+// Compares the Integer fast path with unchecked and overflow-checked int64_t
+// arithmetic on values that never overflow, then shows the cost once results
+// go big.
+
+namespace {
+
+std::vector<int64_t> inputs() {
+    std::vector<int64_t> values(4096);
+    uint64_t state = 12345;
+    for (auto& value : values) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        value = static_cast<int64_t>(state >> 44) - (1 << 19);
+    }
+    return values;
+}
+
+}  // namespace
+
+int main() {
+    auto raw = inputs();
+    std::vector<Integer> boxed(raw.begin(), raw.end());
+
+    Report("int64/mul_add", Measure([&] {
+        int64_t acc = 0;
+        for (size_t i = 1; i < raw.size(); ++i) {
+            acc = acc + raw[i] * raw[i - 1] - raw[i] / 3;
+        }
+        DoNotOptimize(acc);
+    }));
+    Report("int64_checked/mul_add", Measure([&] {
+        int64_t acc = 0;
+        bool overflow = false;
+        for (size_t i = 1; i < raw.size(); ++i) {
+            int64_t product;
+            overflow |= __builtin_mul_overflow(raw[i], raw[i - 1], &product);
+            overflow |= __builtin_add_overflow(acc, product, &acc);
+            overflow |= __builtin_sub_overflow(acc, raw[i] / 3, &acc);
+        }
+        DoNotOptimize(acc);
+        DoNotOptimize(overflow);
+    }));
+    Report("Integer/mul_add", Measure([&] {
+        Integer acc;
+        for (size_t i = 1; i < boxed.size(); ++i) {
+            acc = acc + boxed[i] * boxed[i - 1] - boxed[i] / Integer(3);
+        }
+        DoNotOptimize(acc);
+    }));
+    Report("Integer/factorial_200", Measure([] {
+        Integer product(1);
+        for (int i = 2; i <= 200; ++i) {
+            product = product * Integer(i);
+        }
+        DoNotOptimize(product);
+    }));
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include <sstream>
+#include "bench.h"
+#include "../compiler/closure_compiler.h"
+#include "../interpreter/interpreter.h"
+#include "../native/native_registry.h"
+#include "../parser/parser.h"
+
+// The same driver loop calling gcd/max implemented as script functions and
+// as registered natives.
+
+namespace {
+
+const char* kDriver =
+    "def run(n) return if n == 0 then 0 else gcd(n * 7919, 104729 - n) + max(n, 500) + run(n - 1)\n"
+    "return run(2000)\n";
+
+const char* kScriptFunctions =
+    "def gcd(a, b) return if b == 0 then a else gcd(b, a - a / b * b)\n"
+    "def max(a, b) return if a < b then b else a\n";
+
+std::unique_ptr<Program> parse(const std::string& source) {
+    std::stringstream ss(source);
+    Parser parser(&ss);
+    return parser.Parse();
+}
+
+}  // namespace
+
+int main() {
+    NativeRegistry registry;
+    registry.Add("gcd", [](int64_t a, int64_t b) {
+        while (b != 0) {
+            int64_t rest = a % b;
+            a = b;
+            b = rest;
+        }
+        return a;
+    });
+    registry.Add("max", [](int64_t a, int64_t b) { return a < b ? b : a; });
+
+    auto scripted = parse(std::string(kScriptFunctions) + kDriver);
+    auto native = parse(kDriver);
+
+    Report("interpreter/script", Measure([&] { DoNotOptimize(Interpreter().Run(*scripted)); }));
+    Report("interpreter/native", Measure([&] { DoNotOptimize(Interpreter(&registry).Run(*native)); }));
+    ClosureProgram compiled_script(*scripted);
+    ClosureProgram compiled_native(*native, &registry);
+    Report("closure/script", Measure([&] { DoNotOptimize(compiled_script.Run()); }));
+    Report("closure/native", Measure([&] { DoNotOptimize(compiled_native.Run()); }));
+    return 0;
+}
@@ -0,0 +1,26 @@
+#include <sstream>
+#include <thread>
+#include "bench.h"
+#include "../interpreter/interpreter.h"
+#include "../parallel/parallel.h"
+#include "../parser/parser.h"
+
+// Hundreds of independent expensive assignments, sequential versus scheduled
+// on a thread pool.
+
+int main() {
+    std::string source = "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\n";
+    for (int i = 0; i < 200; ++i) {
+        source += "v" + std::to_string(i) + " = fib(16)\n";
+    }
+    std::stringstream ss(source);
+    Parser parser(&ss);
+    auto program = parser.Parse();
+
+    Report("sequential", Measure([&] { DoNotOptimize(Interpreter().Run(*program)); }));
+    for (size_t threads = 1; threads <= std::thread::hardware_concurrency(); threads *= 2) {
+        ParallelEvaluator evaluator(threads);
+        Report("parallel/" + std::to_string(threads), Measure([&] { DoNotOptimize(evaluator.Run(*program)); }));
+    }
+    return 0;
+}
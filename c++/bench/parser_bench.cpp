@@ -0,0 +1,185 @@
+#include <sstream>
+#include "bench.h"
+#include "../parser/parser.h"
+#include "../parser/parser_session.h"
+
+// Parses operator-heavy generated scripts; the tokenize-only pass shows how
+// much of the time is the parser's own, and the pipelined parse how much of
+// it overlaps with lexing on another thread. The library case loads a file of
+// defs eagerly and with deferred bodies, of which a request would use few.
+// The ingest case parses many one-line scripts, each with a fresh parser or
+// all through one session, one at a time or as a batch sharing an arena.
+// With TOY_LANG_PERF=1 the tokenize and parse passes also report hardware
+// counters per byte, token and node. The stream case pulls statements one at
+// a time, timing the first and the whole file.
+
+namespace {
+
+std::string makeScript(size_t lines) {
+    std::string source;
+    for (size_t i = 0; i < lines; ++i) {
+        source += "x" + std::to_string(i) +
+                  " = a * 2 + b / 3 - c * (d + e) < f == g + h * i - f(j, k * 2) + (if a < b then c - d else e * 4)\n";
+    }
+    return source;
+}
+
+// Each line nests 50 parenthesized levels: a + (b * (c - (d + ... ))).
+std::string makeNestedScript(size_t lines) {
+    std::string expr = "z";
+    const char* ops[] = {" + ", " * ", " - ", " < "};
+    for (size_t level = 0; level < 50; ++level) {
+        expr = "v" + std::to_string(level) + ops[level % 4] + "(" + expr + ")";
+    }
+    std::string source;
+    for (size_t i = 0; i < lines; ++i) {
+        source += "x = " + expr + "\n";
+    }
+    return source;
+}
+
+std::string makeLibrary(size_t defs) {
+    std::string source;
+    for (size_t i = 0; i < defs; ++i) {
+        source += "def f" + std::to_string(i) + "(a, b, c)\n    return if a < b then a * 2 + b / 3 - c * (a + b) " +
+                  "else f" + std::to_string(i / 2) + "(b, c, a - 1) + (a + b) * (b - c) / (c + 1)\n";
+    }
+    return source;
+}
+
+void load(const char* name, const std::string& source) {
+    Report(std::string(name) + "/eager", Measure([&] {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        DoNotOptimize(parser.Parse());
+    }));
+    Report(std::string(name) + "/lazy", Measure([&] {
+        std::stringstream ss(source);
+        Parser parser(&ss, ParserOptions{true});
+        DoNotOptimize(parser.Parse());
+    }));
+    Report(std::string(name) + "/lazy+use-10", Measure([&] {
+        std::stringstream ss(source);
+        Parser parser(&ss, ParserOptions{true});
+        auto program = parser.Parse();
+        for (size_t i = 0; i < 10; ++i) {
+            DoNotOptimize(static_cast<FunctionDef&>(*program->statements[i * 97]).Body());
+        }
+    }));
+}
+
+void ingest(const char* name, size_t count) {
+    std::vector<std::string> scripts;
+    for (size_t i = 0; i < count; ++i) {
+        scripts.push_back("total = price * " + std::to_string(i % 97) + " + fee\n");
+    }
+    std::vector<std::string_view> views(scripts.begin(), scripts.end());
+    Report(std::string(name) + "/fresh-parser", Measure([&] {
+        for (const auto& script : scripts) {
+            std::stringstream ss(script);
+            Parser parser(&ss);
+            DoNotOptimize(parser.Parse());
+        }
+    }));
+    ParserSession session;
+    Report(std::string(name) + "/session-heap", Measure([&] {
+        std::vector<std::unique_ptr<Program>> programs;
+        for (auto view : views) {
+            programs.push_back(session.Parse(view));
+        }
+        DoNotOptimize(programs);
+    }));
+    Report(std::string(name) + "/session-batch", Measure([&] { DoNotOptimize(session.ParseBatch(views)); }));
+}
+
+size_t countNodes(const Statement& stmt) {
+    if (auto func = dynamic_cast<const FunctionDef*>(&stmt)) {
+        return 1 + countNodes(*func->Body());
+    }
+    if (auto ret = dynamic_cast<const Return*>(&stmt)) {
+        return 1 + CountNodes(*ret->value);
+    }
+    if (auto assignment = dynamic_cast<const Assignment*>(&stmt)) {
+        return 1 + CountNodes(*assignment->value);
+    }
+    return 1;
+}
+
+// Reads a string in place, so opening the input does not copy the file.
+class ViewBuffer : public std::streambuf {
+public:
+    explicit ViewBuffer(const std::string& source) {
+        char* begin = const_cast<char*>(source.data());
+        setg(begin, begin, begin + source.size());
+    }
+};
+
+void stream(const char* name, const std::string& source) {
+    Report(std::string(name) + "/first-statement", Measure([&] {
+        ViewBuffer buffer(source);
+        std::istream in(&buffer);
+        Parser parser(&in);
+        DoNotOptimize(parser.NextStatement());
+    }));
+    Report(std::string(name) + "/stream-all", Measure([&] {
+        ViewBuffer buffer(source);
+        std::istream in(&buffer);
+        Parser parser(&in);
+        while (auto stmt = parser.NextStatement()) {
+            DoNotOptimize(stmt);
+        }
+    }));
+    Report(std::string(name) + "/parse-all", Measure([&] {
+        ViewBuffer buffer(source);
+        std::istream in(&buffer);
+        Parser parser(&in);
+        DoNotOptimize(parser.Parse());
+    }));
+}
+
+void run(const char* name, const std::string& source) {
+    size_t tokens = 0;
+    auto tokenize = [&] {
+        std::stringstream ss(source);
+        Tokenizer tokenizer(&ss);
+        tokens = 0;
+        while (!tokenizer.IsEnd()) {
+            DoNotOptimize(tokenizer.GetToken());
+            tokenizer.Next();
+            ++tokens;
+        }
+    };
+    auto parse = [&] {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        DoNotOptimize(parser.Parse());
+    };
+    Report(std::string(name) + "/tokenize", Measure(tokenize));
+    Report(std::string(name) + "/parse", Measure(parse));
+    Report(std::string(name) + "/parse-pipelined", Measure([&] {
+        std::stringstream ss(source);
+        Parser parser(&ss, ParserOptions{false, true});
+        DoNotOptimize(parser.Parse());
+    }));
+
+    std::stringstream ss(source);
+    auto program = Parser(&ss).Parse();
+    size_t nodes = 0;
+    for (const auto& stmt : program->statements) {
+        nodes += countNodes(*stmt);
+    }
+    double bytes = static_cast<double>(source.size());
+    ReportCounters(std::string(name) + "/tokenize", tokenize, {{"byte", bytes}, {"token", double(tokens)}});
+    ReportCounters(std::string(name) + "/parse", parse, {{"byte", bytes}, {"node", double(nodes)}});
+}
+
+}  // namespace
+
+int main() {
+    run("operators", makeScript(2000));
+    run("nested", makeNestedScript(1000));
+    load("library", makeLibrary(5000));
+    ingest("ingest-10000", 10000);
+    stream("stream-20000", makeScript(20000));
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include <sstream>
+#include "bench.h"
+#include "../compiler/closure_compiler.h"
+#include "../interpreter/interpreter.h"
+#include "../optimizer/specializer.h"
+#include "../parser/parser.h"
+
+// Runs helper-heavy loops whose calls pass literal arguments, before and
+// after specialization, on the interpreter and the closure compiler.
+
+namespace {
+
+std::unique_ptr<Program> parse(const char* source) {
+    std::stringstream ss(source);
+    Parser parser(&ss);
+    return parser.Parse();
+}
+
+void run(const char* name, const char* source) {
+    auto generic = parse(source);
+    auto specialized = parse(source);
+    auto report = Specializer().Run(*specialized);
+    std::printf("%s: %zu clones, %zu sites\n", name, report.clones.size(), report.specialized.size());
+    Report(std::string(name) + "/interpreter", Measure([&] { DoNotOptimize(Interpreter().Run(*generic)); }));
+    Report(std::string(name) + "/interpreter-specialized",
+           Measure([&] { DoNotOptimize(Interpreter().Run(*specialized)); }));
+    ClosureProgram closure(*generic);
+    Report(std::string(name) + "/closure", Measure([&] { DoNotOptimize(closure.Run()); }));
+    ClosureProgram closure_specialized(*specialized);
+    Report(std::string(name) + "/closure-specialized", Measure([&] { DoNotOptimize(closure_specialized.Run()); }));
+}
+
+}  // namespace
+
+int main() {
+    run("pow",
+        "def pow(x, n) return if n == 0 then 1 else x * pow(x, n - 1)\n"
+        "def loop(i, acc) return if i == 0 then acc else loop(i - 1, acc + pow(i, 4) - pow(i, 2))\n"
+        "return loop(2000, 0)\n");
+    run("scale",
+        "def scale(x, num, den) return if den == 0 then 0 else x * num / den\n"
+        "def clamp(x, lo, hi) return if x < lo then lo else if hi < x then hi else x\n"
+        "def loop(i, acc) return if i == 0 then acc else loop(i - 1, acc + clamp(scale(i, 3, 2), 10, 2500))\n"
+        "return loop(2000, 0)\n");
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <sstream>
+#include "bench.h"
+#include "../compiler/closure_compiler.h"
+#include "../interpreter/interpreter.h"
+#include "../parser/parser.h"
+#include "../vm/context_pool.h"
+#include "../vm/vm.h"
+
+// Compares the native-recursive engines with the heap-frame bytecode VM.
+// The deep case only runs on the VM; the metered runs carry a fuel budget
+// and a deadline. The request cases serve a small script
+// per call, compiling it each time versus running a pooled context of a
+// shared compiled program.
+
+namespace {
+
+std::unique_ptr<Program> parse(const char* source) {
+    std::stringstream ss(source);
+    Parser parser(&ss);
+    return parser.Parse();
+}
+
+void run(const char* name, const char* source, bool native_recursive) {
+    auto program = parse(source);
+    if (native_recursive) {
+        Report(std::string(name) + "/interpreter", Measure([&] { DoNotOptimize(Interpreter().Run(*program)); }));
+        ClosureProgram closure(*program);
+        Report(std::string(name) + "/closure", Measure([&] { DoNotOptimize(closure.Run()); }));
+    }
+    BytecodeProgram bytecode(*program);
+    Report(std::string(name) + "/bytecode", Measure([&] { DoNotOptimize(bytecode.Run()); }));
+    Report(std::string(name) + "/bytecode-metered", Measure([&] {
+        ExecutionLimits limits{uint64_t(1) << 40, std::chrono::steady_clock::now() + std::chrono::hours(1)};
+        DoNotOptimize(bytecode.Run(limits));
+    }));
+}
+
+void serve(const char* name, const char* source) {
+    auto program = parse(source);
+    Report(std::string(name) + "/compile+run", Measure([&] { DoNotOptimize(BytecodeProgram(*program).Run()); }));
+    ContextPool pool(std::make_shared<const CompiledProgram>(*program));
+    Report(std::string(name) + "/pooled", Measure([&] { DoNotOptimize(pool.Acquire()->Run()); }));
+}
+
+}  // namespace
+
+int main() {
+    run("fib", "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\nreturn fib(20)\n", true);
+    run("sum", "def sum(n) return if n == 0 then 0 else n + sum(n - 1)\nreturn sum(5000)\n", true);
+    run("sum-deep", "def sum(n) return if n == 0 then 0 else n + sum(n - 1)\nreturn sum(1000000)\n", false);
+    serve("request", "rate = 3\ndef price(qty, unit) return if qty < 10 then qty * unit else qty * unit * 9 / 10\n"
+                     "total = price(12, 250) + price(3, 99) * rate\nreturn total\n");
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "program_cache.h"
+#include <algorithm>
+#include <sstream>
+#include "../parser/parser.h"
+
+namespace {
+
+// Rough heap footprint of a parsed program: the retained source text plus a
+// fixed charge per statement and per expression node.
+constexpr size_t kStatementBytes = 64;
+constexpr size_t kNodeBytes = 64;
+
+size_t statementBytes(const Statement& stmt) {
+    if (auto func = dynamic_cast<const FunctionDef*>(&stmt)) {
+        size_t bytes = kStatementBytes + func->name.size();
+        for (const auto& param : func->params) {
+            bytes += sizeof(std::string) + param.size();
+        }
+        return bytes + statementBytes(*func->Body());
+    }
+    if (auto assignment = dynamic_cast<const Assignment*>(&stmt)) {
+        return kStatementBytes + assignment->name.size() + CountNodes(*assignment->value) * kNodeBytes;
+    }
+    if (auto ret = dynamic_cast<const Return*>(&stmt)) {
+        return kStatementBytes + CountNodes(*ret->value) * kNodeBytes;
+    }
+    return kStatementBytes;
+}
+
+size_t programBytes(const std::string& source, const Program& program) {
+    size_t bytes = sizeof(Program) + source.size();
+    for (const auto& stmt : program.statements) {
+        bytes += statementBytes(*stmt);
+    }
+    return bytes;
+}
+
+}  // namespace
+
+ProgramCache::ProgramCache(size_t byte_budget, Prepare prepare, size_t shards)
+    : shards_(std::max<size_t>(shards, 1)),
+      shard_budget_(byte_budget / std::max<size_t>(shards, 1)),
+      prepare_(std::move(prepare)) {}
+
+std::shared_ptr<const Program> ProgramCache::Get(const std::string& source) {
+    uint64_t hash = std::hash<std::string>()(source);
+    Shard& shard = shards_[(hash >> 48) % shards_.size()];
+    if (auto program = lookup(shard, hash, source)) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return program;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+
+    std::stringstream ss(source);
+    Parser parser(&ss);
+    std::shared_ptr<Program> program = parser.Parse();
+    if (prepare_) {
+        prepare_(*program);
+    }
+    size_t bytes = programBytes(source, *program);
+    if (bytes > shard_budget_) {
+        return program;
+    }
+    return insert(shard, Entry{hash, source, std::move(program), bytes});
+}
+
+ProgramCacheStats ProgramCache::Stats() const {
+    ProgramCacheStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.evictions = evictions_.load(std::memory_order_relaxed);
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.entries += shard.lru.size();
+        stats.bytes += shard.bytes;
+    }
+    return stats;
+}
+
+std::shared_ptr<const Program> ProgramCache::lookup(Shard& shard, uint64_t hash, const std::string& source) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto [first, last] = shard.index.equal_range(hash);
+    for (auto it = first; it != last; ++it) {
+        if (it->second->source == source) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return it->second->program;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const Program> ProgramCache::insert(Shard& shard, Entry entry) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto [first, last] = shard.index.equal_range(entry.hash);
+    for (auto it = first; it != last; ++it) {
+        if (it->second->source == entry.source) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return it->second->program;
+        }
+    }
+    while (!shard.lru.empty() && shard.bytes + entry.bytes > shard_budget_) {
+        auto victim = std::prev(shard.lru.end());
+        auto [begin, end] = shard.index.equal_range(victim->hash);
+        for (auto it = begin; it != end; ++it) {
+            if (it->second == victim) {
+                shard.index.erase(it);
+                break;
+            }
+        }
+        shard.bytes -= victim->bytes;
+        shard.lru.erase(victim);
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+    shard.bytes += entry.bytes;
+    shard.lru.push_front(std::move(entry));
+    shard.index.emplace(shard.lru.front().hash, shard.lru.begin());
+    return shard.lru.front().program;
+}
@@ -0,0 +1,69 @@
+#ifndef TOY_LANG_PROGRAM_CACHE
+#define TOY_LANG_PROGRAM_CACHE
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../ast/ast.h"
+
+struct ProgramCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+// Parsed programs keyed by the hash of their source text, for services that
+// see the same scripts over and over. A hit returns the shared Program
+// without touching the tokenizer or parser.
+//
+// Entries are spread over independently locked shards by hash, each with its
+// own LRU list and an equal slice of the byte budget, so lookups of different
+// scripts rarely contend. Parsing happens outside the lock: concurrent misses
+// on the same source may both parse, and the first to insert wins. Sources
+// that fail to parse are not cached.
+class ProgramCache {
+public:
+    // Runs once on every freshly parsed program before it is shared, e.g. to
+    // apply optimizer passes. The program is immutable afterwards.
+    using Prepare = std::function<void(Program&)>;
+
+    explicit ProgramCache(size_t byte_budget, Prepare prepare = nullptr, size_t shards = 16);
+
+    std::shared_ptr<const Program> Get(const std::string& source);
+
+    ProgramCacheStats Stats() const;
+
+private:
+    struct Entry {
+        uint64_t hash;
+        std::string source;
+        std::shared_ptr<const Program> program;
+        size_t bytes;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> lru;  // most recently used first
+        std::unordered_multimap<uint64_t, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    std::vector<Shard> shards_;
+    size_t shard_budget_;
+    Prepare prepare_;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+    std::atomic<size_t> evictions_{0};
+
+    std::shared_ptr<const Program> lookup(Shard& shard, uint64_t hash, const std::string& source);
+    std::shared_ptr<const Program> insert(Shard& shard, Entry entry);
+};
+
+#endif // TOY_LANG_PROGRAM_CACHE
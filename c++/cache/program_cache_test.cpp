@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "program_cache.h"
+#include "../error.h"
+#include "../interpreter/interpreter.h"
+#include "../optimizer/fusion.h"
+
+TEST(ProgramCacheTest, ReusesParsedPrograms) {
+    ProgramCache cache(1 << 20);
+    auto first = cache.Get("x = 1 + 2\nreturn x * 3\n");
+    auto second = cache.Get("x = 1 + 2\nreturn x * 3\n");
+    auto other = cache.Get("return 4\n");
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first, other);
+    EXPECT_EQ(Interpreter().Run(*second), 9);
+
+    ProgramCacheStats stats = cache.Stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.evictions, 0u);
+    EXPECT_EQ(stats.entries, 2u);
+    EXPECT_GT(stats.bytes, 0u);
+}
+
+TEST(ProgramCacheTest, PreparesOnlyOnMiss) {
+    size_t prepared = 0;
+    ProgramCache cache(1 << 20, [&](Program& program) {
+        ++prepared;
+        FuseExpressions(program);
+    });
+    const std::string source = "def sum(n) return if n == 0 then 0 else n + sum(n - 1)\nreturn sum(10)\n";
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(Interpreter().Run(*cache.Get(source)), 55);
+    }
+    EXPECT_EQ(prepared, 1u);
+}
+
+TEST(ProgramCacheTest, EvictsLeastRecentlyUsed) {
+    ProgramCache cache(1024, nullptr, 1);
+    const std::string a = "a = 1\n";
+    const std::string b = "b = 2\n";
+    auto first = cache.Get(a);
+    size_t entry_bytes = cache.Stats().bytes;
+    ASSERT_GT(entry_bytes, 0u);
+
+    std::vector<std::string> filler;
+    for (size_t i = 0; i < 1024 / entry_bytes + 1; ++i) {
+        filler.push_back("v" + std::to_string(i) + " = 3\n");
+    }
+    cache.Get(b);
+    for (const auto& source : filler) {
+        cache.Get(a);  // keep a hot while b ages out
+        cache.Get(source);
+    }
+    ProgramCacheStats stats = cache.Stats();
+    EXPECT_GT(stats.evictions, 0u);
+    EXPECT_LE(stats.bytes, 1024u);
+    EXPECT_EQ(cache.Get(a), first);
+
+    size_t misses = cache.Stats().misses;
+    cache.Get(b);
+    EXPECT_EQ(cache.Stats().misses, misses + 1);
+}
+
+TEST(ProgramCacheTest, SkipsProgramsOverBudget) {
+    ProgramCache cache(16, nullptr, 1);
+    auto first = cache.Get("x = 1\n");
+    auto second = cache.Get("x = 1\n");
+    EXPECT_NE(first, second);
+    EXPECT_EQ(cache.Stats().entries, 0u);
+}
+
+TEST(ProgramCacheTest, DoesNotCacheSyntaxErrors) {
+    ProgramCache cache(1 << 20);
+    EXPECT_THROW(cache.Get("x = (1\n"), SyntaxError);
+    EXPECT_THROW(cache.Get("x = (1\n"), SyntaxError);
+    EXPECT_EQ(cache.Stats().entries, 0u);
+    EXPECT_EQ(cache.Stats().misses, 2u);
+}
+
+TEST(ProgramCacheTest, ConcurrentLookups) {
+    ProgramCache cache(1 << 20);
+    std::vector<std::string> sources;
+    for (int i = 0; i < 32; ++i) {
+        sources.push_back("return " + std::to_string(i) + " * 2\n");
+    }
+    std::vector<std::thread> threads;
+    std::vector<int> failures(4, 0);
+    for (size_t t = 0; t < failures.size(); ++t) {
+        threads.emplace_back([&, t] {
+            for (int round = 0; round < 50; ++round) {
+                for (size_t i = 0; i < sources.size(); ++i) {
+                    if (Interpreter().Run(*cache.Get(sources[i])) != Integer(static_cast<int64_t>(2 * i))) {
+                        ++failures[t];
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int failed : failures) {
+        EXPECT_EQ(failed, 0);
+    }
+    ProgramCacheStats stats = cache.Stats();
+    EXPECT_EQ(stats.entries, sources.size());
+    EXPECT_EQ(stats.hits + stats.misses, failures.size() * 50 * sources.size());
+    EXPECT_LE(stats.misses, failures.size() * sources.size());
+}
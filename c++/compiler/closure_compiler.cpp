@@ -0,0 +1,496 @@
+#include "closure_compiler.h"
+#include <algorithm>
+#include <array>
+
+namespace {
+
+struct AddOp {
+    static Integer Apply(const Integer& left, const Integer& right) { return left + right; }
+};
+
+struct SubOp {
+    static Integer Apply(const Integer& left, const Integer& right) { return left - right; }
+};
+
+struct MulOp {
+    static Integer Apply(const Integer& left, const Integer& right) { return left * right; }
+};
+
+struct DivOp {
+    static Integer Apply(const Integer& left, const Integer& right) {
+        if (right.IsZero()) {
+            throw RuntimeError("Division by zero");
+        }
+        return left / right;
+    }
+};
+
+struct EqOp {
+    static Integer Apply(const Integer& left, const Integer& right) { return Integer(left == right); }
+};
+
+struct NotEqOp {
+    static Integer Apply(const Integer& left, const Integer& right) { return Integer(left != right); }
+};
+
+struct LessOp {
+    static Integer Apply(const Integer& left, const Integer& right) { return Integer(left < right); }
+};
+
+// Operand kinds a binary node can be specialized on.
+
+struct Slot {
+    uint32_t index;
+    const Integer& Get(const Integer* slots) const { return slots[index]; }
+};
+
+struct Const {
+    Integer value;
+    const Integer& Get(const Integer*) const { return value; }
+};
+
+struct Node {
+    std::unique_ptr<ClosureNode> node;
+    Integer Get(const Integer* slots) const { return node->Eval(slots); }
+};
+
+template <typename Op, typename L, typename R>
+class Binary final : public ClosureNode {
+public:
+    Binary(L left, R right) : left_(std::move(left)), right_(std::move(right)) {}
+
+    Integer Eval(const Integer* slots) const override {
+        auto&& left = left_.Get(slots);
+        auto&& right = right_.Get(slots);
+        return Op::Apply(left, right);
+    }
+
+private:
+    L left_;
+    R right_;
+};
+
+class ConstNode final : public ClosureNode {
+public:
+    explicit ConstNode(Integer value) : value_(std::move(value)) {}
+    Integer Eval(const Integer*) const override { return value_; }
+
+private:
+    Integer value_;
+};
+
+class SlotNode final : public ClosureNode {
+public:
+    explicit SlotNode(uint32_t index) : index_(index) {}
+    Integer Eval(const Integer* slots) const override { return slots[index_]; }
+
+private:
+    uint32_t index_;
+};
+
+class GlobalNode final : public ClosureNode {
+public:
+    explicit GlobalNode(const ClosureGlobal* global) : global_(global) {}
+
+    Integer Eval(const Integer*) const override {
+        if (!global_->value) {
+            throw NameError("Undefined variable: " + global_->name);
+        }
+        return *global_->value;
+    }
+
+private:
+    const ClosureGlobal* global_;
+};
+
+class TernaryNode final : public ClosureNode {
+public:
+    TernaryNode(std::unique_ptr<ClosureNode> cond, std::unique_ptr<ClosureNode> then_node,
+                std::unique_ptr<ClosureNode> else_node)
+        : cond_(std::move(cond)), then_(std::move(then_node)), else_(std::move(else_node)) {}
+
+    Integer Eval(const Integer* slots) const override {
+        return cond_->Eval(slots).IsZero() ? else_->Eval(slots) : then_->Eval(slots);
+    }
+
+private:
+    std::unique_ptr<ClosureNode> cond_;
+    std::unique_ptr<ClosureNode> then_;
+    std::unique_ptr<ClosureNode> else_;
+};
+
+const ClosureFunction& resolve(const ClosureFunctionSlot& slot, size_t arity) {
+    if (!slot.bound) {
+        throw NameError("Undefined function: " + slot.name);
+    }
+    if (slot.bound->arity != arity) {
+        throw RuntimeError("Function '" + slot.name + "' expects " + std::to_string(slot.bound->arity) +
+                           " arguments, got " + std::to_string(arity));
+    }
+    return *slot.bound;
+}
+
+Integer invoke(const ClosureFunction& func, const Integer* args) {
+    if (!func.body) {
+        throw RuntimeError("Function '" + func.name + "' does not return a value");
+    }
+    return func.body->Eval(args);
+}
+
+// Arguments live in a fixed array on the native stack for small arities.
+template <size_t N>
+class FixedCall final : public ClosureNode {
+public:
+    FixedCall(const ClosureFunctionSlot* slot, std::array<std::unique_ptr<ClosureNode>, N> args)
+        : slot_(slot), args_(std::move(args)) {}
+
+    Integer Eval(const Integer* slots) const override {
+        const ClosureFunction& func = resolve(*slot_, N);
+        std::array<Integer, N> values;
+        for (size_t i = 0; i < N; ++i) {
+            values[i] = args_[i]->Eval(slots);
+        }
+        return invoke(func, values.data());
+    }
+
+private:
+    const ClosureFunctionSlot* slot_;
+    std::array<std::unique_ptr<ClosureNode>, N> args_;
+};
+
+class VariadicCall final : public ClosureNode {
+public:
+    VariadicCall(const ClosureFunctionSlot* slot, std::vector<std::unique_ptr<ClosureNode>> args)
+        : slot_(slot), args_(std::move(args)) {}
+
+    Integer Eval(const Integer* slots) const override {
+        const ClosureFunction& func = resolve(*slot_, args_.size());
+        std::vector<Integer> values;
+        values.reserve(args_.size());
+        for (const auto& arg : args_) {
+            values.push_back(arg->Eval(slots));
+        }
+        return invoke(func, values.data());
+    }
+
+private:
+    const ClosureFunctionSlot* slot_;
+    std::vector<std::unique_ptr<ClosureNode>> args_;
+};
+
+template <size_t N>
+std::unique_ptr<ClosureNode> makeFixedCall(const ClosureFunctionSlot* slot,
+                                           std::vector<std::unique_ptr<ClosureNode>>& args) {
+    std::array<std::unique_ptr<ClosureNode>, N> fixed;
+    std::move(args.begin(), args.end(), fixed.begin());
+    return std::make_unique<FixedCall<N>>(slot, std::move(fixed));
+}
+
+// Arguments go straight from a stack array into the native thunk.
+template <size_t N>
+class NativeCall final : public ClosureNode {
+public:
+    NativeCall(const NativeFunction* native, std::array<std::unique_ptr<ClosureNode>, N> args)
+        : native_(native), args_(std::move(args)) {}
+
+    Integer Eval(const Integer* slots) const override {
+        std::array<Integer, N> values;
+        for (size_t i = 0; i < N; ++i) {
+            values[i] = args_[i]->Eval(slots);
+        }
+        return native_->thunk(native_->target.get(), values.data());
+    }
+
+private:
+    const NativeFunction* native_;
+    std::array<std::unique_ptr<ClosureNode>, N> args_;
+};
+
+template <size_t N = 0>
+std::unique_ptr<ClosureNode> makeNativeCall(const NativeFunction* native,
+                                            std::vector<std::unique_ptr<ClosureNode>>& args) {
+    if constexpr (N == kMaxNativeArity) {
+        std::array<std::unique_ptr<ClosureNode>, N> fixed;
+        std::move(args.begin(), args.end(), fixed.begin());
+        return std::make_unique<NativeCall<N>>(native, std::move(fixed));
+    } else {
+        if (args.size() != N) {
+            return makeNativeCall<N + 1>(native, args);
+        }
+        std::array<std::unique_ptr<ClosureNode>, N> fixed;
+        std::move(args.begin(), args.end(), fixed.begin());
+        return std::make_unique<NativeCall<N>>(native, std::move(fixed));
+    }
+}
+
+// Raises an error known at compile time when (and only if) it is evaluated.
+class ThrowNode final : public ClosureNode {
+public:
+    explicit ThrowNode(std::string message) : message_(std::move(message)) {}
+    Integer Eval(const Integer*) const override { throw RuntimeError(message_); }
+
+private:
+    std::string message_;
+};
+
+struct Operand {
+    enum class Kind { SLOT, CONST, NODE };
+    Kind kind = Kind::CONST;
+    uint32_t slot = 0;
+    Integer value{};
+    std::unique_ptr<ClosureNode> node{};
+};
+
+template <typename Op, typename L>
+std::unique_ptr<ClosureNode> makeBinary(L left, Operand right) {
+    switch (right.kind) {
+        case Operand::Kind::SLOT:
+            return std::make_unique<Binary<Op, L, Slot>>(std::move(left), Slot{right.slot});
+        case Operand::Kind::CONST:
+            return std::make_unique<Binary<Op, L, Const>>(std::move(left), Const{right.value});
+        case Operand::Kind::NODE:
+            return std::make_unique<Binary<Op, L, Node>>(std::move(left), Node{std::move(right.node)});
+    }
+    throw RuntimeError("Unknown operand kind");
+}
+
+template <typename Op>
+std::unique_ptr<ClosureNode> makeBinary(Operand left, Operand right) {
+    switch (left.kind) {
+        case Operand::Kind::SLOT:
+            return makeBinary<Op>(Slot{left.slot}, std::move(right));
+        case Operand::Kind::CONST:
+            return makeBinary<Op>(Const{left.value}, std::move(right));
+        case Operand::Kind::NODE:
+            return makeBinary<Op>(Node{std::move(left.node)}, std::move(right));
+    }
+    throw RuntimeError("Unknown operand kind");
+}
+
+std::unique_ptr<ClosureNode> makeBinary(OperatorToken op, Operand left, Operand right) {
+    switch (op) {
+        case OperatorToken::PLUS:
+            return makeBinary<AddOp>(std::move(left), std::move(right));
+        case OperatorToken::MINUS:
+            return makeBinary<SubOp>(std::move(left), std::move(right));
+        case OperatorToken::MULTIPLY:
+            return makeBinary<MulOp>(std::move(left), std::move(right));
+        case OperatorToken::DIVIDE:
+            return makeBinary<DivOp>(std::move(left), std::move(right));
+        case OperatorToken::EQ_EQ:
+            return makeBinary<EqOp>(std::move(left), std::move(right));
+        case OperatorToken::NOT_EQ:
+            return makeBinary<NotEqOp>(std::move(left), std::move(right));
+        case OperatorToken::LESS:
+            return makeBinary<LessOp>(std::move(left), std::move(right));
+        default:
+            throw RuntimeError("Unsupported binary operator");
+    }
+}
+
+}  // namespace
+
+class ClosureCompiler {
+public:
+    ClosureCompiler(ClosureProgram& program, const std::vector<std::string>& params)
+        : program_(program), params_(params) {}
+
+    std::unique_ptr<ClosureNode> Compile(const Expression& expr) {
+        switch (expr.kind) {
+            case ExprKind::NUMBER:
+                return std::make_unique<ConstNode>(static_cast<const NumberExpr&>(expr).value);
+            case ExprKind::VARIABLE:
+                return materialize(variable(static_cast<const VariableExpr&>(expr).name));
+            case ExprKind::BINARY: {
+                const auto& binary = static_cast<const BinaryExpr&>(expr);
+                return makeBinary(binary.op, operand(*binary.left), operand(*binary.right));
+            }
+            case ExprKind::TERNARY: {
+                const auto& ternary = static_cast<const TernaryExpr&>(expr);
+                return std::make_unique<TernaryNode>(Compile(*ternary.cond), Compile(*ternary.then_expr),
+                                                     Compile(*ternary.else_expr));
+            }
+            case ExprKind::CALL: {
+                const auto& call = static_cast<const CallExpr&>(expr);
+                std::vector<std::unique_ptr<ClosureNode>> args;
+                for (const auto& arg : call.args) {
+                    args.push_back(Compile(*arg));
+                }
+                return makeCall(call.callee, std::move(args));
+            }
+            case ExprKind::VAR_LESS_CONST: {
+                const auto& fused = static_cast<const VarLessConstExpr&>(expr);
+                return makeBinary(OperatorToken::LESS, variable(fused.name), constant(fused.constant));
+            }
+            case ExprKind::VAR_SUB_CONST: {
+                const auto& fused = static_cast<const VarSubConstExpr&>(expr);
+                return makeBinary(OperatorToken::MINUS, variable(fused.name), constant(fused.constant));
+            }
+            case ExprKind::CALL_VAR_SUB_CONST: {
+                const auto& fused = static_cast<const CallVarSubConstExpr&>(expr);
+                std::vector<std::unique_ptr<ClosureNode>> args;
+                args.push_back(makeBinary(OperatorToken::MINUS, variable(fused.name), constant(fused.constant)));
+                return makeCall(fused.callee, std::move(args));
+            }
+            case ExprKind::IF_VAR_EQ_CONST: {
+                const auto& fused = static_cast<const IfVarEqConstExpr&>(expr);
+                return std::make_unique<TernaryNode>(
+                    makeBinary(OperatorToken::EQ_EQ, variable(fused.name), constant(fused.constant)),
+                    Compile(*fused.then_expr), Compile(*fused.else_expr));
+            }
+        }
+        throw RuntimeError("Unknown expression node");
+    }
+
+private:
+    ClosureProgram& program_;
+    const std::vector<std::string>& params_;
+
+    Operand constant(const Integer& value) {
+        return Operand{Operand::Kind::CONST, 0, value};
+    }
+
+    Operand variable(const std::string& name) {
+        auto param = std::find(params_.begin(), params_.end(), name);
+        if (param != params_.end()) {
+            return Operand{Operand::Kind::SLOT, static_cast<uint32_t>(param - params_.begin())};
+        }
+        return Operand{Operand::Kind::NODE, 0, Integer(), std::make_unique<GlobalNode>(&program_.global(name))};
+    }
+
+    Operand operand(const Expression& expr) {
+        switch (expr.kind) {
+            case ExprKind::NUMBER:
+                return constant(static_cast<const NumberExpr&>(expr).value);
+            case ExprKind::VARIABLE:
+                return variable(static_cast<const VariableExpr&>(expr).name);
+            default:
+                return Operand{Operand::Kind::NODE, 0, Integer(), Compile(expr)};
+        }
+    }
+
+    std::unique_ptr<ClosureNode> materialize(Operand operand) {
+        switch (operand.kind) {
+            case Operand::Kind::SLOT:
+                return std::make_unique<SlotNode>(operand.slot);
+            case Operand::Kind::CONST:
+                return std::make_unique<ConstNode>(operand.value);
+            case Operand::Kind::NODE:
+                return std::move(operand.node);
+        }
+        throw RuntimeError("Unknown operand kind");
+    }
+
+    std::unique_ptr<ClosureNode> makeCall(const std::string& callee,
+                                          std::vector<std::unique_ptr<ClosureNode>> args) {
+        if (program_.natives_ && !program_.defined_.count(callee)) {
+            if (const NativeFunction* native = program_.natives_->Find(callee)) {
+                if (native->arity != args.size()) {
+                    return std::make_unique<ThrowNode>("Function '" + callee + "' expects " +
+                                                       std::to_string(native->arity) + " arguments, got " +
+                                                       std::to_string(args.size()));
+                }
+                return makeNativeCall(native, args);
+            }
+        }
+        const ClosureFunctionSlot* slot = &program_.functionSlot(callee);
+        switch (args.size()) {
+            case 0:
+                return makeFixedCall<0>(slot, args);
+            case 1:
+                return makeFixedCall<1>(slot, args);
+            case 2:
+                return makeFixedCall<2>(slot, args);
+            case 3:
+                return makeFixedCall<3>(slot, args);
+            case 4:
+                return makeFixedCall<4>(slot, args);
+            default:
+                return std::make_unique<VariadicCall>(slot, std::move(args));
+        }
+    }
+};
+
+ClosureProgram::ClosureProgram(const Program& program, const NativeRegistry* natives) : natives_(natives) {
+    static const std::vector<std::string> no_params;
+    for (const auto& stmt : program.statements) {
+        if (auto func = dynamic_cast<const FunctionDef*>(stmt.get())) {
+            defined_.insert(func->name);
+        }
+    }
+    for (const auto& stmt : program.statements) {
+        if (auto func = dynamic_cast<const FunctionDef*>(stmt.get())) {
+            auto compiled = std::make_unique<ClosureFunction>();
+            compiled->name = func->name;
+            compiled->arity = func->params.size();
+            ClosureCompiler compiler(*this, func->params);
+            if (auto ret = dynamic_cast<const Return*>(func->Body())) {
+                compiled->body = compiler.Compile(*ret->value);
+            } else if (auto assignment = dynamic_cast<const Assignment*>(func->Body())) {
+                compiled->body = compiler.Compile(*assignment->value);
+            }
+            functionSlot(func->name);
+            steps_.push_back(Step{StepKind::DEFINE, function_index_.at(func->name), compiled.get()});
+            functions_.push_back(std::move(compiled));
+        } else if (auto assignment = dynamic_cast<const Assignment*>(stmt.get())) {
+            ClosureCompiler compiler(*this, no_params);
+            auto value = compiler.Compile(*assignment->value);
+            global(assignment->name);
+            steps_.push_back(Step{StepKind::ASSIGN, global_index_.at(assignment->name), nullptr, std::move(value)});
+        } else if (auto ret = dynamic_cast<const Return*>(stmt.get())) {
+            ClosureCompiler compiler(*this, no_params);
+            steps_.push_back(Step{StepKind::RETURN, 0, nullptr, compiler.Compile(*ret->value)});
+        }
+    }
+}
+
+std::optional<Integer> ClosureProgram::Run() {
+    for (auto& global : globals_) {
+        global->value.reset();
+    }
+    for (auto& slot : function_slots_) {
+        slot->bound = nullptr;
+    }
+    const Integer* no_slots = nullptr;
+    for (const auto& step : steps_) {
+        switch (step.kind) {
+            case StepKind::DEFINE:
+                function_slots_[step.target]->bound = step.function;
+                break;
+            case StepKind::ASSIGN:
+                globals_[step.target]->value = step.value->Eval(no_slots);
+                break;
+            case StepKind::RETURN:
+                return step.value->Eval(no_slots);
+        }
+    }
+    return std::nullopt;
+}
+
+Integer ClosureProgram::GetGlobal(const std::string& name) const {
+    auto it = global_index_.find(name);
+    if (it == global_index_.end() || !globals_[it->second]->value) {
+        throw NameError("Undefined variable: " + name);
+    }
+    return *globals_[it->second]->value;
+}
+
+ClosureGlobal& ClosureProgram::global(const std::string& name) {
+    auto it = global_index_.find(name);
+    if (it != global_index_.end()) {
+        return *globals_[it->second];
+    }
+    global_index_.emplace(name, globals_.size());
+    globals_.push_back(std::make_unique<ClosureGlobal>(ClosureGlobal{name, std::nullopt}));
+    return *globals_.back();
+}
+
+ClosureFunctionSlot& ClosureProgram::functionSlot(const std::string& name) {
+    auto it = function_index_.find(name);
+    if (it != function_index_.end()) {
+        return *function_slots_[it->second];
+    }
+    function_index_.emplace(name, function_slots_.size());
+    function_slots_.push_back(std::make_unique<ClosureFunctionSlot>(ClosureFunctionSlot{name, nullptr}));
+    return *function_slots_.back();
+}
@@ -0,0 +1,81 @@
+#ifndef TOY_LANG_CLOSURE_COMPILER
+#define TOY_LANG_CLOSURE_COMPILER
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../ast/ast.h"
+#include "../error.h"
+#include "../native/native_registry.h"
+
+// A compiled expression: evaluation is a virtual call into a node whose
+// operands were resolved at compile time. `slots` holds the arguments of the
+// enclosing function invocation.
+class ClosureNode {
+public:
+    virtual ~ClosureNode() = default;
+    virtual Integer Eval(const Integer* slots) const = 0;
+};
+
+struct ClosureFunction {
+    std::string name;
+    size_t arity = 0;
+    std::unique_ptr<ClosureNode> body;  // null when the body does not yield a value
+};
+
+// Storage a compiled program binds against. Globals and function names are
+// resolved to these slots once, at compile time; only the slot contents are
+// looked at while running.
+struct ClosureGlobal {
+    std::string name;
+    std::optional<Integer> value;
+};
+
+struct ClosureFunctionSlot {
+    std::string name;
+    const ClosureFunction* bound = nullptr;
+};
+
+// Compiles every expression of a Program into a tree of ClosureNodes, one
+// template instantiation per operator and operand kind (parameter slot,
+// literal or generic subexpression), so evaluation needs no per-node type
+// switch and no name lookups.
+class ClosureProgram {
+public:
+    // Calls to names the program never defines bind to `natives` here, at
+    // compile time.
+    explicit ClosureProgram(const Program& program, const NativeRegistry* natives = nullptr);
+
+    std::optional<Integer> Run();
+
+    Integer GetGlobal(const std::string& name) const;
+
+private:
+    enum class StepKind { DEFINE, ASSIGN, RETURN };
+
+    struct Step {
+        StepKind kind = StepKind::DEFINE;
+        size_t target = 0;  // function slot / global slot
+        const ClosureFunction* function = nullptr;
+        std::unique_ptr<ClosureNode> value{};
+    };
+
+    std::vector<std::unique_ptr<ClosureFunction>> functions_;
+    std::vector<std::unique_ptr<ClosureGlobal>> globals_;
+    std::vector<std::unique_ptr<ClosureFunctionSlot>> function_slots_;
+    std::unordered_map<std::string, size_t> global_index_;
+    std::unordered_map<std::string, size_t> function_index_;
+    std::vector<Step> steps_;
+    const NativeRegistry* natives_;
+    std::unordered_set<std::string> defined_;
+
+    ClosureGlobal& global(const std::string& name);
+    ClosureFunctionSlot& functionSlot(const std::string& name);
+
+    friend class ClosureCompiler;
+};
+
+#endif // TOY_LANG_CLOSURE_COMPILER
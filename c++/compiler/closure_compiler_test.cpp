@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "closure_compiler.h"
+#include "../interpreter/interpreter.h"
+#include "../optimizer/fusion.h"
+#include "../parser/parser.h"
+
+class ClosureCompilerTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Program> parse(const std::string& source) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        return parser.Parse();
+    }
+};
+
+TEST_F(ClosureCompilerTest, EvaluatesGlobals) {
+    auto program = parse("x = 1 + 2 * 3\ny = (x - 1) / 2\nz = if x < y then 10 else 20\n");
+    ClosureProgram compiled(*program);
+    EXPECT_FALSE(compiled.Run().has_value());
+    EXPECT_EQ(compiled.GetGlobal("x"), 7);
+    EXPECT_EQ(compiled.GetGlobal("y"), 3);
+    EXPECT_EQ(compiled.GetGlobal("z"), 20);
+}
+
+TEST_F(ClosureCompilerTest, MatchesInterpreter) {
+    const char* sources[] = {
+        "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\nreturn fib(15)\n",
+        "def add(x, y)\n    x = x + y\nreturn add(2, 3)\n",
+        "scale = 10\ndef f(x) return x * scale\nreturn f(4)\n",
+        "def f(a, b, c, d, e) return a - b + c * d / e\nreturn f(1, 2, 3, 4, 5)\n",
+        "def choose(n, k) return if k == 0 then 1 else choose(n - 1, k - 1) * n / k\nreturn choose(100, 50)\n",
+    };
+    for (const char* source : sources) {
+        auto program = parse(source);
+        ClosureProgram compiled(*program);
+        EXPECT_EQ(compiled.Run(), Interpreter().Run(*program)) << source;
+    }
+}
+
+TEST_F(ClosureCompilerTest, RunsFusedNodes) {
+    auto program = parse(
+        "def sum(n) return if n == 0 then 0 else n + sum(n - 1)\n"
+        "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\n"
+        "return sum(100) + fib(10)\n");
+    EXPECT_GT(FuseExpressions(*program), 0u);
+    ClosureProgram compiled(*program);
+    EXPECT_EQ(compiled.Run(), 5050 + 55);
+}
+
+TEST_F(ClosureCompilerTest, RebindsOnEachRun) {
+    auto program = parse("def f() return 1\nx = f()\ndef f() return 2\nreturn x + f()\n");
+    ClosureProgram compiled(*program);
+    EXPECT_EQ(compiled.Run(), 3);
+    EXPECT_EQ(compiled.Run(), 3);
+}
+
+TEST_F(ClosureCompilerTest, ReportsErrors) {
+    EXPECT_THROW(ClosureProgram(*parse("x = y\n")).Run(), NameError);
+    EXPECT_THROW(ClosureProgram(*parse("x = f(1)\n")).Run(), NameError);
+    EXPECT_THROW(ClosureProgram(*parse("x = 1 / 0\n")).Run(), RuntimeError);
+    EXPECT_THROW(ClosureProgram(*parse("def f(a) return a\nx = f(1, 2)\n")).Run(), RuntimeError);
+    EXPECT_THROW(ClosureProgram(*parse("def f(a) def g(b) return b\nx = f(1)\n")).Run(), RuntimeError);
+    ClosureProgram compiled(*parse("x = 1\n"));
+    EXPECT_THROW(compiled.GetGlobal("x"), NameError);
+}
@@ -0,0 +1,313 @@
+#include "integer.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+// Sign and magnitude; limbs are base 2^32, least significant first, with no
+// leading zero limbs. Zero has no limbs.
+struct BigInt {
+    bool negative = false;
+    std::vector<uint32_t> limbs;
+    std::atomic<uint32_t> refs{1};
+
+    BigInt() = default;
+    BigInt(bool negative, std::vector<uint32_t> limbs) : negative(negative), limbs(std::move(limbs)) {}
+    BigInt(const BigInt& other) : negative(other.negative), limbs(other.limbs) {}
+    BigInt(BigInt&& other) noexcept : negative(other.negative), limbs(std::move(other.limbs)) {}
+};
+
+namespace {
+
+using Limbs = std::vector<uint32_t>;
+
+void trim(Limbs& limbs) {
+    while (!limbs.empty() && limbs.back() == 0) {
+        limbs.pop_back();
+    }
+}
+
+int compareMagnitude(const Limbs& left, const Limbs& right) {
+    if (left.size() != right.size()) {
+        return left.size() < right.size() ? -1 : 1;
+    }
+    for (size_t i = left.size(); i-- > 0;) {
+        if (left[i] != right[i]) {
+            return left[i] < right[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+Limbs addMagnitude(const Limbs& left, const Limbs& right) {
+    const Limbs& longer = left.size() >= right.size() ? left : right;
+    const Limbs& shorter = left.size() >= right.size() ? right : left;
+    Limbs result(longer.size() + 1);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < longer.size(); ++i) {
+        uint64_t sum = carry + longer[i] + (i < shorter.size() ? shorter[i] : 0);
+        result[i] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+    }
+    result[longer.size()] = static_cast<uint32_t>(carry);
+    trim(result);
+    return result;
+}
+
+// Requires |left| >= |right|.
+Limbs subtractMagnitude(const Limbs& left, const Limbs& right) {
+    Limbs result(left.size());
+    int64_t borrow = 0;
+    for (size_t i = 0; i < left.size(); ++i) {
+        int64_t diff = static_cast<int64_t>(left[i]) - borrow - (i < right.size() ? right[i] : 0);
+        borrow = diff < 0;
+        result[i] = static_cast<uint32_t>(diff + (borrow << 32));
+    }
+    trim(result);
+    return result;
+}
+
+Limbs multiplyMagnitude(const Limbs& left, const Limbs& right) {
+    if (left.empty() || right.empty()) {
+        return {};
+    }
+    Limbs result(left.size() + right.size());
+    for (size_t i = 0; i < left.size(); ++i) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < right.size(); ++j) {
+            uint64_t cur = static_cast<uint64_t>(left[i]) * right[j] + result[i + j] + carry;
+            result[i + j] = static_cast<uint32_t>(cur);
+            carry = cur >> 32;
+        }
+        result[i + right.size()] = static_cast<uint32_t>(carry);
+    }
+    trim(result);
+    return result;
+}
+
+Limbs divideSmall(const Limbs& left, uint32_t divisor, uint32_t* remainder = nullptr) {
+    Limbs result(left.size());
+    uint64_t rest = 0;
+    for (size_t i = left.size(); i-- > 0;) {
+        uint64_t cur = (rest << 32) | left[i];
+        result[i] = static_cast<uint32_t>(cur / divisor);
+        rest = cur % divisor;
+    }
+    trim(result);
+    if (remainder) {
+        *remainder = static_cast<uint32_t>(rest);
+    }
+    return result;
+}
+
+// Shift-subtract long division; divisors wider than one limb are rare enough
+// in scripts that the quadratic bit loop is not worth Knuth's algorithm D.
+Limbs divideMagnitude(const Limbs& left, const Limbs& right) {
+    if (right.size() == 1) {
+        return divideSmall(left, right[0]);
+    }
+    if (compareMagnitude(left, right) < 0) {
+        return {};
+    }
+    Limbs quotient(left.size());
+    Limbs rest;
+    for (size_t bit = left.size() * 32; bit-- > 0;) {
+        uint32_t carry = (left[bit / 32] >> (bit % 32)) & 1;
+        for (auto& limb : rest) {
+            uint32_t next = limb >> 31;
+            limb = (limb << 1) | carry;
+            carry = next;
+        }
+        if (carry) {
+            rest.push_back(carry);
+        }
+        if (compareMagnitude(rest, right) >= 0) {
+            rest = subtractMagnitude(rest, right);
+            quotient[bit / 32] |= 1u << (bit % 32);
+        }
+    }
+    trim(quotient);
+    return quotient;
+}
+
+BigInt addSigned(const BigInt& left, const BigInt& right) {
+    if (left.negative == right.negative) {
+        return BigInt{left.negative, addMagnitude(left.limbs, right.limbs)};
+    }
+    int cmp = compareMagnitude(left.limbs, right.limbs);
+    if (cmp == 0) {
+        return BigInt{};
+    }
+    if (cmp > 0) {
+        return BigInt{left.negative, subtractMagnitude(left.limbs, right.limbs)};
+    }
+    return BigInt{right.negative, subtractMagnitude(right.limbs, left.limbs)};
+}
+
+}  // namespace
+
+Integer Integer::Parse(std::string_view digits) {
+    BigInt big;
+    if (!digits.empty() && digits.front() == '-') {
+        big.negative = true;
+        digits.remove_prefix(1);
+    }
+    for (char c : digits) {
+        uint64_t carry = static_cast<uint64_t>(c - '0');
+        for (auto& limb : big.limbs) {
+            uint64_t cur = static_cast<uint64_t>(limb) * 10 + carry;
+            limb = static_cast<uint32_t>(cur);
+            carry = cur >> 32;
+        }
+        if (carry) {
+            big.limbs.push_back(static_cast<uint32_t>(carry));
+        }
+    }
+    return fromBits(fromBig(std::move(big)));
+}
+
+namespace {
+
+BigInt& unbox(int64_t bits) {
+    return *reinterpret_cast<BigInt*>(static_cast<uintptr_t>(bits) & ~uintptr_t{1});
+}
+
+BigInt fromInt64(int64_t value) {
+    BigInt big;
+    big.negative = value < 0;
+    uint64_t magnitude = big.negative ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    while (magnitude != 0) {
+        big.limbs.push_back(static_cast<uint32_t>(magnitude));
+        magnitude >>= 32;
+    }
+    return big;
+}
+
+// The magnitude of a big value in at most two limbs, or false when wider.
+bool twoLimbMagnitude(const BigInt& big, uint64_t* magnitude) {
+    if (big.limbs.size() > 2) {
+        return false;
+    }
+    *magnitude = 0;
+    for (size_t i = big.limbs.size(); i-- > 0;) {
+        *magnitude = (*magnitude << 32) | big.limbs[i];
+    }
+    return true;
+}
+
+}  // namespace
+
+std::string Integer::ToString() const {
+    if (!isBig(bits_)) {
+        return std::to_string(bits_ >> 1);
+    }
+    const BigInt& big = unbox(bits_);
+    std::string digits;
+    Limbs rest = big.limbs;
+    while (!rest.empty()) {
+        uint32_t chunk;
+        rest = divideSmall(rest, 1000000000u, &chunk);
+        for (int i = 0; i < 9 && (chunk != 0 || !rest.empty()); ++i) {
+            digits.push_back(static_cast<char>('0' + chunk % 10));
+            chunk /= 10;
+        }
+    }
+    if (big.negative) {
+        digits.push_back('-');
+    }
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+}
+
+size_t Integer::Hash() const {
+    if (!isBig(bits_)) {
+        return std::hash<int64_t>()(bits_ >> 1);
+    }
+    const BigInt& big = unbox(bits_);
+    size_t hash = big.negative;
+    for (uint32_t limb : big.limbs) {
+        hash ^= limb + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+int64_t Integer::Add(int64_t left, int64_t right) {
+    return fromBig(addSigned(toBig(left), toBig(right)));
+}
+
+int64_t Integer::Subtract(int64_t left, int64_t right) {
+    BigInt negated = toBig(right);
+    negated.negative = !negated.negative && !negated.limbs.empty();
+    return fromBig(addSigned(toBig(left), negated));
+}
+
+int64_t Integer::Multiply(int64_t left, int64_t right) {
+    BigInt a = toBig(left);
+    BigInt b = toBig(right);
+    return fromBig(BigInt{a.negative != b.negative, multiplyMagnitude(a.limbs, b.limbs)});
+}
+
+int64_t Integer::Divide(int64_t left, int64_t right) {
+    BigInt a = toBig(left);
+    BigInt b = toBig(right);
+    return fromBig(BigInt{a.negative != b.negative, divideMagnitude(a.limbs, b.limbs)});
+}
+
+int Integer::Compare(int64_t left, int64_t right) {
+    BigInt a = toBig(left);
+    BigInt b = toBig(right);
+    if (a.negative != b.negative) {
+        return a.negative ? -1 : 1;
+    }
+    int cmp = compareMagnitude(a.limbs, b.limbs);
+    return a.negative ? -cmp : cmp;
+}
+
+int64_t Integer::box(int64_t value) {
+    return fromBig(fromInt64(value));
+}
+
+bool Integer::bigFitsInt64(int64_t bits) {
+    const BigInt& big = unbox(bits);
+    uint64_t magnitude;
+    return twoLimbMagnitude(big, &magnitude) &&
+           magnitude <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + big.negative;
+}
+
+int64_t Integer::bigToInt64(int64_t bits) {
+    const BigInt& big = unbox(bits);
+    uint64_t magnitude = 0;
+    twoLimbMagnitude(big, &magnitude);
+    return big.negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+}
+
+// Demotes to the inline form whenever the value fits in 63 bits. A big result
+// is returned owning one reference.
+int64_t Integer::fromBig(BigInt big) {
+    trim(big.limbs);
+    uint64_t magnitude;
+    if (twoLimbMagnitude(big, &magnitude) && magnitude <= (uint64_t{1} << 62) - !big.negative) {
+        int64_t value = big.negative ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude);
+        return value * 2;
+    }
+    auto boxed = new BigInt(std::move(big));
+    return static_cast<int64_t>(reinterpret_cast<uintptr_t>(boxed) | 1);
+}
+
+void Integer::retain(int64_t bits) {
+    unbox(bits).refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Integer::release(int64_t bits) {
+    BigInt& big = unbox(bits);
+    if (big.refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete &big;
+    }
+}
+
+BigInt Integer::toBig(int64_t bits) {
+    if (isBig(bits)) {
+        return unbox(bits);
+    }
+    return fromInt64(bits >> 1);
+}
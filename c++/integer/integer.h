@@ -0,0 +1,167 @@
+#ifndef TOY_LANG_INTEGER
+#define TOY_LANG_INTEGER
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+struct BigInt;
+
+// Arbitrary-precision signed integer in one tagged machine word. Values that
+// fit in 63 bits are stored inline, shifted left by one with a clear low bit;
+// anything larger is a pointer to an immutable heap BigInt with the low bit
+// set. Shifting both operands keeps sums, differences and products exact, so
+// every operator first tries an overflow-checked int64_t operation directly on
+// the tagged words. Only results outside 63 bits are promoted, and big results
+// that fall back into range are demoted again.
+class Integer {
+public:
+    Integer(int64_t value = 0) {
+        if (__builtin_expect(__builtin_add_overflow(value, value, &bits_), 0)) {
+            bits_ = box(value);
+        }
+    }
+
+    Integer(const Integer& other) : bits_(other.bits_) {
+        if (isBig(bits_)) {
+            retain(bits_);
+        }
+    }
+
+    Integer(Integer&& other) noexcept : bits_(other.bits_) {
+        other.bits_ = 0;
+    }
+
+    Integer& operator=(const Integer& other) {
+        Integer copy(other);
+        std::swap(bits_, copy.bits_);
+        return *this;
+    }
+
+    Integer& operator=(Integer&& other) noexcept {
+        std::swap(bits_, other.bits_);
+        return *this;
+    }
+
+    ~Integer() {
+        if (isBig(bits_)) {
+            release(bits_);
+        }
+    }
+
+    // Parses an optionally '-'-prefixed string of decimal digits.
+    static Integer Parse(std::string_view digits);
+
+    // Whether the value fits in int64_t, and the value when it does.
+    bool IsSmall() const { return !isBig(bits_) || bigFitsInt64(bits_); }
+    int64_t Small() const { return !isBig(bits_) ? bits_ >> 1 : bigToInt64(bits_); }
+    bool IsZero() const { return bits_ == 0; }
+
+    std::string ToString() const;
+    size_t Hash() const;
+
+    friend Integer operator+(const Integer& left, const Integer& right) {
+        int64_t result;
+        if (__builtin_expect(!isBig(left.bits_ | right.bits_) &&
+                             !__builtin_add_overflow(left.bits_, right.bits_, &result), 1)) {
+            return fromBits(result);
+        }
+        return fromBits(Add(left.bits_, right.bits_));
+    }
+
+    friend Integer operator-(const Integer& left, const Integer& right) {
+        int64_t result;
+        if (__builtin_expect(!isBig(left.bits_ | right.bits_) &&
+                             !__builtin_sub_overflow(left.bits_, right.bits_, &result), 1)) {
+            return fromBits(result);
+        }
+        return fromBits(Subtract(left.bits_, right.bits_));
+    }
+
+    friend Integer operator*(const Integer& left, const Integer& right) {
+        int64_t result;
+        if (__builtin_expect(!isBig(left.bits_ | right.bits_) &&
+                             !__builtin_mul_overflow(left.bits_, right.bits_ >> 1, &result), 1)) {
+            return fromBits(result);
+        }
+        return fromBits(Multiply(left.bits_, right.bits_));
+    }
+
+    // Truncates toward zero. The caller rejects a zero divisor. Only
+    // -2^62 / -1 leaves the inline range.
+    friend Integer operator/(const Integer& left, const Integer& right) {
+        if (__builtin_expect(!isBig(left.bits_ | right.bits_) &&
+                             !(left.bits_ == kMinInline && right.bits_ == -2), 1)) {
+            return fromBits((left.bits_ >> 1) / (right.bits_ >> 1) * 2);
+        }
+        return fromBits(Divide(left.bits_, right.bits_));
+    }
+
+    // Inline values are canonical, so equal words mean equal values and an
+    // inline value never equals a big one.
+    friend bool operator==(const Integer& left, const Integer& right) {
+        if (left.bits_ == right.bits_) {
+            return true;
+        }
+        if (!isBig(left.bits_) || !isBig(right.bits_)) {
+            return false;
+        }
+        return Compare(left.bits_, right.bits_) == 0;
+    }
+
+    friend bool operator!=(const Integer& left, const Integer& right) { return !(left == right); }
+
+    friend bool operator<(const Integer& left, const Integer& right) {
+        if (!isBig(left.bits_ | right.bits_)) {
+            return left.bits_ < right.bits_;
+        }
+        return Compare(left.bits_, right.bits_) < 0;
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const Integer& value) {
+        return out << value.ToString();
+    }
+
+private:
+    // The tagged word of -2^62, the smallest inline value.
+    static constexpr int64_t kMinInline = std::numeric_limits<int64_t>::min();
+
+    // Either value << 1, or the address of a BigInt, immutable and shared
+    // between copies through an atomic reference count, with the low bit set.
+    int64_t bits_ = 0;
+
+    static bool isBig(int64_t bits) { return bits & 1; }
+
+    static Integer fromBits(int64_t bits) {
+        Integer result;
+        result.bits_ = bits;
+        return result;
+    }
+
+    // Slow paths take and return tagged words, the result owning its BigInt,
+    // so neither the operands nor the results of the inline fast paths need
+    // to live in memory.
+    [[gnu::cold]] static int64_t Add(int64_t left, int64_t right);
+    [[gnu::cold]] static int64_t Subtract(int64_t left, int64_t right);
+    [[gnu::cold]] static int64_t Multiply(int64_t left, int64_t right);
+    [[gnu::cold]] static int64_t Divide(int64_t left, int64_t right);
+    [[gnu::cold]] static int Compare(int64_t left, int64_t right);
+    [[gnu::cold]] static int64_t box(int64_t value);
+    [[gnu::cold]] static bool bigFitsInt64(int64_t bits);
+    [[gnu::cold]] static int64_t bigToInt64(int64_t bits);
+
+    static void retain(int64_t bits);
+    static void release(int64_t bits);
+
+    static int64_t fromBig(BigInt big);
+    static BigInt toBig(int64_t bits);
+};
+
+struct IntegerHash {
+    size_t operator()(const Integer& value) const { return value.Hash(); }
+};
+
+#endif // TOY_LANG_INTEGER
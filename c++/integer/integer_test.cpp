@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <limits>
+#include "integer.h"
+
+class IntegerTest : public ::testing::Test {
+protected:
+    const int64_t max_ = std::numeric_limits<int64_t>::max();
+    const int64_t min_ = std::numeric_limits<int64_t>::min();
+};
+
+TEST_F(IntegerTest, SmallArithmeticStaysInline) {
+    Integer a(40);
+    Integer b(2);
+    EXPECT_TRUE((a + b).IsSmall());
+    EXPECT_EQ(a + b, 42);
+    EXPECT_EQ(a - b, 38);
+    EXPECT_EQ(a * b, 80);
+    EXPECT_EQ(a / b, 20);
+    EXPECT_EQ(Integer(-7) / Integer(2), -3);
+    EXPECT_TRUE(Integer(-1) < Integer(0));
+}
+
+TEST_F(IntegerTest, PromotesOnOverflow) {
+    Integer sum = Integer(max_) + Integer(1);
+    EXPECT_FALSE(sum.IsSmall());
+    EXPECT_EQ(sum.ToString(), "9223372036854775808");
+    EXPECT_EQ(Integer(min_) - Integer(1), Integer::Parse("-9223372036854775809"));
+    EXPECT_EQ((Integer(max_) * Integer(max_)).ToString(), "85070591730234615847396907784232501249");
+    EXPECT_EQ((Integer(min_) / Integer(-1)).ToString(), "9223372036854775808");
+}
+
+TEST_F(IntegerTest, DemotesWhenBackInRange) {
+    Integer big = Integer(max_) + Integer(10);
+    Integer back = big - Integer(10);
+    EXPECT_TRUE(back.IsSmall());
+    EXPECT_EQ(back, max_);
+    EXPECT_TRUE((Integer(min_) - Integer(1) + Integer(1)).IsSmall());
+}
+
+TEST_F(IntegerTest, ParsesAndPrints) {
+    EXPECT_TRUE(Integer::Parse("123").IsSmall());
+    EXPECT_EQ(Integer::Parse("123"), 123);
+    EXPECT_EQ(Integer::Parse("-9223372036854775808"), min_);
+    const char* digits = "1000000000000000000000000000000000001";
+    EXPECT_EQ(Integer::Parse(digits).ToString(), digits);
+    EXPECT_EQ(Integer::Parse("-1000000000000000000000").ToString(), "-1000000000000000000000");
+}
+
+TEST_F(IntegerTest, BigDivisionTruncatesTowardZero) {
+    Integer a = Integer::Parse("100000000000000000000000000000");
+    Integer b = Integer::Parse("-300000000000000000000");
+    EXPECT_EQ(a / b, -333333333);
+    EXPECT_EQ(a / Integer(7), Integer::Parse("14285714285714285714285714285"));
+    EXPECT_EQ(b / a, 0);
+}
+
+TEST_F(IntegerTest, ComparesMixedRepresentations) {
+    Integer big = Integer::Parse("100000000000000000000");
+    EXPECT_TRUE(Integer(max_) < big);
+    EXPECT_TRUE(Integer(0) - big < Integer(min_));
+    EXPECT_NE(big, max_);
+    EXPECT_EQ(big.Hash(), Integer::Parse("100000000000000000000").Hash());
+}
+
+TEST_F(IntegerTest, ComputesFactorial) {
+    Integer product(1);
+    for (int i = 2; i <= 30; ++i) {
+        product = product * Integer(i);
+    }
+    EXPECT_EQ(product.ToString(), "265252859812191058636308480000000");
+}
+
+TEST_F(IntegerTest, CrossesTheInlineBoundary) {
+    const int64_t top = (int64_t{1} << 62) - 1;
+    const int64_t bottom = -(int64_t{1} << 62);
+    EXPECT_EQ((Integer(top) + Integer(1)).ToString(), "4611686018427387904");
+    EXPECT_EQ(Integer(top) + Integer(1) - Integer(1), top);
+    EXPECT_EQ((Integer(bottom) - Integer(1)).ToString(), "-4611686018427387905");
+    EXPECT_EQ((Integer(bottom) / Integer(-1)).ToString(), "4611686018427387904");
+    EXPECT_EQ((Integer(top) * Integer(2)).ToString(), "9223372036854775806");
+    EXPECT_EQ(Integer(top) + Integer(1), Integer::Parse("4611686018427387904"));
+    EXPECT_EQ((Integer(top) + Integer(1)).Hash(), Integer::Parse("4611686018427387904").Hash());
+    EXPECT_TRUE(Integer(bottom) < Integer(bottom + 1));
+    EXPECT_TRUE(Integer(bottom) - Integer(1) < Integer(bottom));
+    EXPECT_TRUE(Integer(max_).IsSmall());
+    EXPECT_EQ(Integer(max_).Small(), max_);
+    EXPECT_EQ(Integer(min_).Small(), min_);
+    EXPECT_EQ(Integer(min_).ToString(), "-9223372036854775808");
+}
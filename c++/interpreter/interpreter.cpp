@@ -0,0 +1,195 @@
+#include "interpreter.h"
+
+Integer ApplyOperator(OperatorToken op, const Integer& left, const Integer& right) {
+    switch (op) {
+        case OperatorToken::PLUS:
+            return left + right;
+        case OperatorToken::MINUS:
+            return left - right;
+        case OperatorToken::MULTIPLY:
+            return left * right;
+        case OperatorToken::DIVIDE:
+            if (right.IsZero()) {
+                throw RuntimeError("Division by zero");
+            }
+            return left / right;
+        case OperatorToken::EQ_EQ:
+            return Integer(left == right);
+        case OperatorToken::NOT_EQ:
+            return Integer(left != right);
+        case OperatorToken::LESS:
+            return Integer(left < right);
+        default:
+            throw RuntimeError("Unsupported binary operator");
+    }
+}
+
+Interpreter::Interpreter(const NativeRegistry* natives) : natives_(natives) {}
+
+std::optional<Integer> Interpreter::Run(const Program& program) {
+    for (const auto& stmt : program.statements) {
+        if (auto result = Execute(*stmt)) {
+            return result;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<Integer> Interpreter::Execute(const Statement& stmt) {
+    if (auto func = dynamic_cast<const FunctionDef*>(&stmt)) {
+        functions_[func->name] = func;
+    } else if (auto assignment = dynamic_cast<const Assignment*>(&stmt)) {
+        globals_[assignment->name] = eval(*assignment->value, nullptr);
+    } else if (auto ret = dynamic_cast<const Return*>(&stmt)) {
+        return eval(*ret->value, nullptr);
+    }
+    return std::nullopt;
+}
+
+Integer Interpreter::Evaluate(const Expression& expr) {
+    return eval(expr, nullptr);
+}
+
+bool Interpreter::HasGlobal(const std::string& name) const {
+    return globals_.count(name) != 0;
+}
+
+Integer Interpreter::GetGlobal(const std::string& name) const {
+    auto it = globals_.find(name);
+    if (it == globals_.end()) {
+        throw NameError("Undefined variable: " + name);
+    }
+    return it->second;
+}
+
+void Interpreter::SetGlobal(const std::string& name, std::optional<Integer> value) {
+    if (value) {
+        globals_[name] = std::move(*value);
+    } else {
+        globals_.erase(name);
+    }
+}
+
+void Interpreter::SetFunction(const std::string& name, const FunctionDef* func) {
+    if (func) {
+        functions_[name] = func;
+    } else {
+        functions_.erase(name);
+    }
+}
+
+Integer Interpreter::eval(const Expression& expr, Frame* frame) {
+    switch (expr.kind) {
+        case ExprKind::NUMBER:
+            return static_cast<const NumberExpr&>(expr).value;
+        case ExprKind::VARIABLE:
+            return lookup(static_cast<const VariableExpr&>(expr).name, frame);
+        case ExprKind::BINARY: {
+            const auto& binary = static_cast<const BinaryExpr&>(expr);
+            Integer left = eval(*binary.left, frame);
+            Integer right = eval(*binary.right, frame);
+            return ApplyOperator(binary.op, left, right);
+        }
+        case ExprKind::TERNARY: {
+            const auto& ternary = static_cast<const TernaryExpr&>(expr);
+            if (!eval(*ternary.cond, frame).IsZero()) {
+                return eval(*ternary.then_expr, frame);
+            }
+            return eval(*ternary.else_expr, frame);
+        }
+        case ExprKind::CALL:
+            return call(static_cast<const CallExpr&>(expr), frame);
+        case ExprKind::VAR_LESS_CONST: {
+            const auto& fused = static_cast<const VarLessConstExpr&>(expr);
+            return Integer(lookup(fused.name, frame) < fused.constant);
+        }
+        case ExprKind::VAR_SUB_CONST: {
+            const auto& fused = static_cast<const VarSubConstExpr&>(expr);
+            return lookup(fused.name, frame) - fused.constant;
+        }
+        case ExprKind::CALL_VAR_SUB_CONST: {
+            const auto& fused = static_cast<const CallVarSubConstExpr&>(expr);
+            if (const NativeFunction* native = findNative(fused.callee, 1)) {
+                Integer arg = lookup(fused.name, frame) - fused.constant;
+                return native->Call(&arg);
+            }
+            const FunctionDef& func = resolve(fused.callee, 1);
+            Frame callee_frame;
+            callee_frame[func.params[0]] = lookup(fused.name, frame) - fused.constant;
+            return execBody(func, callee_frame);
+        }
+        case ExprKind::IF_VAR_EQ_CONST: {
+            const auto& fused = static_cast<const IfVarEqConstExpr&>(expr);
+            if (lookup(fused.name, frame) == fused.constant) {
+                return eval(*fused.then_expr, frame);
+            }
+            return eval(*fused.else_expr, frame);
+        }
+    }
+    throw RuntimeError("Unknown expression node");
+}
+
+Integer Interpreter::lookup(const std::string& name, const Frame* frame) const {
+    if (frame) {
+        auto it = frame->find(name);
+        if (it != frame->end()) {
+            return it->second;
+        }
+    }
+    return GetGlobal(name);
+}
+
+const FunctionDef& Interpreter::resolve(const std::string& callee, size_t arity) const {
+    auto it = functions_.find(callee);
+    if (it == functions_.end()) {
+        throw NameError("Undefined function: " + callee);
+    }
+    const FunctionDef& func = *it->second;
+    if (func.params.size() != arity) {
+        throw RuntimeError("Function '" + func.name + "' expects " +
+                           std::to_string(func.params.size()) + " arguments, got " +
+                           std::to_string(arity));
+    }
+    return func;
+}
+
+const NativeFunction* Interpreter::findNative(const std::string& callee, size_t arity) const {
+    if (!natives_ || functions_.count(callee)) {
+        return nullptr;
+    }
+    const NativeFunction* native = natives_->Find(callee);
+    if (native && native->arity != arity) {
+        throw RuntimeError("Function '" + callee + "' expects " + std::to_string(native->arity) +
+                           " arguments, got " + std::to_string(arity));
+    }
+    return native;
+}
+
+Integer Interpreter::call(const CallExpr& call_expr, Frame* frame) {
+    if (const NativeFunction* native = findNative(call_expr.callee, call_expr.args.size())) {
+        Integer args[kMaxNativeArity];
+        for (size_t i = 0; i < call_expr.args.size(); ++i) {
+            args[i] = eval(*call_expr.args[i], frame);
+        }
+        return native->Call(args);
+    }
+    const FunctionDef& func = resolve(call_expr.callee, call_expr.args.size());
+    Frame callee_frame;
+    for (size_t i = 0; i < func.params.size(); ++i) {
+        callee_frame[func.params[i]] = eval(*call_expr.args[i], frame);
+    }
+    return execBody(func, callee_frame);
+}
+
+Integer Interpreter::execBody(const FunctionDef& func, Frame& frame) {
+    const Statement* body = func.Body();
+    if (auto ret = dynamic_cast<const Return*>(body)) {
+        return eval(*ret->value, &frame);
+    }
+    if (auto assignment = dynamic_cast<const Assignment*>(body)) {
+        Integer value = eval(*assignment->value, &frame);
+        frame[assignment->name] = value;
+        return value;
+    }
+    throw RuntimeError("Function '" + func.name + "' does not return a value");
+}
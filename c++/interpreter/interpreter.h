@@ -0,0 +1,57 @@
+#ifndef TOY_LANG_INTERPRETER
+#define TOY_LANG_INTERPRETER
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../ast/ast.h"
+#include "../error.h"
+#include "../native/native_registry.h"
+
+// Applies a binary operator with the language semantics shared by every
+// evaluator: comparisons yield 1 or 0, division truncates and rejects zero.
+Integer ApplyOperator(OperatorToken op, const Integer& left, const Integer& right);
+
+// Reference tree-walking evaluator over a parsed Program.
+//
+// Top-level assignments bind globals, `def` registers a function and a
+// top-level `return` stops the program with its value. Inside a function the
+// body's return value (or the value of an assignment body) is the result.
+// Calls to names the program has not defined fall back to `natives`.
+class Interpreter {
+public:
+    explicit Interpreter(const NativeRegistry* natives = nullptr);
+
+    std::optional<Integer> Run(const Program& program);
+
+    // Executes one top-level statement as Run does; only a `return` yields a
+    // value. A FunctionDef must outlive the calls made to it.
+    std::optional<Integer> Execute(const Statement& stmt);
+
+    Integer Evaluate(const Expression& expr);
+
+    bool HasGlobal(const std::string& name) const;
+    Integer GetGlobal(const std::string& name) const;
+
+    // Rebind state directly, bypassing Run. An empty value or a null function
+    // removes the binding.
+    void SetGlobal(const std::string& name, std::optional<Integer> value);
+    void SetFunction(const std::string& name, const FunctionDef* func);
+
+private:
+    using Frame = std::unordered_map<std::string, Integer>;
+
+    std::unordered_map<std::string, Integer> globals_;
+    std::unordered_map<std::string, const FunctionDef*> functions_;
+    const NativeRegistry* natives_;
+
+    Integer eval(const Expression& expr, Frame* frame);
+    Integer lookup(const std::string& name, const Frame* frame) const;
+    const FunctionDef& resolve(const std::string& callee, size_t arity) const;
+    Integer call(const CallExpr& call, Frame* frame);
+    const NativeFunction* findNative(const std::string& callee, size_t arity) const;
+    Integer execBody(const FunctionDef& func, Frame& frame);
+};
+
+#endif // TOY_LANG_INTERPRETER
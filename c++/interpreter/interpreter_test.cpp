@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "interpreter.h"
+#include "../parser/parser.h"
+
+class InterpreterTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Program> parse(const std::string& source) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        return parser.Parse();
+    }
+};
+
+TEST_F(InterpreterTest, EvaluatesArithmetic) {
+    auto program = parse("x = 1 + 2 * 3\ny = (x - 1) / 2\n");
+    Interpreter interpreter;
+    EXPECT_FALSE(interpreter.Run(*program).has_value());
+    EXPECT_EQ(interpreter.GetGlobal("x"), 7);
+    EXPECT_EQ(interpreter.GetGlobal("y"), 3);
+}
+
+TEST_F(InterpreterTest, EvaluatesComparisonsAndTernary) {
+    auto program = parse("a = 3 < 4\nb = 3 == 4\nc = if 3 != 4 then 10 else 20\n");
+    Interpreter interpreter;
+    interpreter.Run(*program);
+    EXPECT_EQ(interpreter.GetGlobal("a"), 1);
+    EXPECT_EQ(interpreter.GetGlobal("b"), 0);
+    EXPECT_EQ(interpreter.GetGlobal("c"), 10);
+}
+
+TEST_F(InterpreterTest, CallsRecursiveFunction) {
+    auto program = parse(
+        "def fact(n) return if n < 2 then 1 else n * fact(n - 1)\n"
+        "return fact(10)\n");
+    Interpreter interpreter;
+    EXPECT_EQ(interpreter.Run(*program), 3628800);
+}
+
+TEST_F(InterpreterTest, AssignmentBodyYieldsValue) {
+    auto program = parse("def add(x, y)\n    x = x + y\nreturn add(2, 3)\n");
+    Interpreter interpreter;
+    EXPECT_EQ(interpreter.Run(*program), 5);
+}
+
+TEST_F(InterpreterTest, FunctionsReadGlobals) {
+    auto program = parse("scale = 10\ndef f(x) return x * scale\nreturn f(4)\n");
+    Interpreter interpreter;
+    EXPECT_EQ(interpreter.Run(*program), 40);
+}
+
+TEST_F(InterpreterTest, ReportsErrors) {
+    Interpreter interpreter;
+    EXPECT_THROW(interpreter.Run(*parse("x = y\n")), NameError);
+    EXPECT_THROW(interpreter.Run(*parse("x = f(1)\n")), NameError);
+    EXPECT_THROW(interpreter.Run(*parse("x = 1 / 0\n")), RuntimeError);
+    EXPECT_THROW(interpreter.Run(*parse("def f(a) return a\nx = f(1, 2)\n")), RuntimeError);
+}
+
+TEST_F(InterpreterTest, PromotesToBigIntegers) {
+    auto program = parse(
+        "def fact(n) return if n < 2 then 1 else n * fact(n - 1)\n"
+        "def choose(n, k) return fact(n) / (fact(k) * fact(n - k))\n"
+        "big = fact(30)\n"
+        "return choose(60, 30)\n");
+    Interpreter interpreter;
+    EXPECT_EQ(interpreter.Run(*program)->ToString(), "118264581564861424");
+    EXPECT_EQ(interpreter.GetGlobal("big").ToString(), "265252859812191058636308480000000");
+}
+
+TEST_F(InterpreterTest, RunsLazilyParsedFunctions) {
+    std::stringstream ss("def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\n"
+                         "def unused(x) return x +\n"
+                         "def twice(x)\n    y = fib(x) * 2\n"
+                         "return twice(10)\n");
+    Parser parser(&ss, ParserOptions{true});
+    auto program = parser.Parse();
+    EXPECT_EQ(Interpreter().Run(*program), 110);
+    EXPECT_FALSE(dynamic_cast<FunctionDef*>(program->statements[1].get())->IsBodyParsed());
+}
+
+TEST_F(InterpreterTest, ExecutesStreamedStatements) {
+    std::string source = "def sq(x) return x * x\ntotal = 0\n";
+    for (int i = 1; i <= 1000; ++i) {
+        source += "total = total + sq(" + std::to_string(i) + ")\n";
+    }
+    source += "return total\nignored = 1\n";
+
+    std::stringstream ss(source);
+    Parser parser(&ss);
+    Interpreter interpreter;
+    std::vector<std::unique_ptr<Statement>> defs;
+    std::optional<Integer> result;
+    while (auto stmt = parser.NextStatement()) {
+        result = interpreter.Execute(*stmt);
+        if (result) {
+            break;
+        }
+        if (dynamic_cast<FunctionDef*>(stmt.get())) {
+            defs.push_back(std::move(stmt));
+        }
+    }
+    EXPECT_EQ(result, 333833500);
+    EXPECT_EQ(result, Interpreter().Run(*parse(source)));
+    EXPECT_FALSE(interpreter.HasGlobal("ignored"));
+}
@@ -0,0 +1,6 @@
+#include "native_registry.h"
+
+const NativeFunction* NativeRegistry::Find(const std::string& name) const {
+    auto it = functions_.find(name);
+    return it == functions_.end() ? nullptr : &it->second;
+}
@@ -0,0 +1,134 @@
+#ifndef TOY_LANG_NATIVE_REGISTRY
+#define TOY_LANG_NATIVE_REGISTRY
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include "../error.h"
+#include "../integer/integer.h"
+
+// Upper bound on native arity, so callers can pass arguments in a fixed
+// array on the stack.
+constexpr size_t kMaxNativeArity = 8;
+
+// A C++ callable exposed to scripts. `thunk` unpacks the arguments into the
+// callable's parameter types; calling it is one indirect call.
+struct NativeFunction {
+    using Thunk = Integer (*)(const void* target, const Integer* args);
+
+    std::string name;
+    size_t arity = 0;
+    Thunk thunk = nullptr;
+    std::shared_ptr<const void> target;
+
+    Integer Call(const Integer* args) const { return thunk(target.get(), args); }
+};
+
+namespace native_detail {
+
+template <typename T>
+struct Argument {
+    static_assert(std::is_same_v<T, int64_t> || std::is_same_v<T, Integer>,
+                  "native parameters must be int64_t or Integer");
+};
+
+template <>
+struct Argument<int64_t> {
+    static int64_t From(const Integer& value) {
+        if (!value.IsSmall()) {
+            throw RuntimeError("Native argument does not fit in 64 bits");
+        }
+        return value.Small();
+    }
+};
+
+template <>
+struct Argument<Integer> {
+    static const Integer& From(const Integer& value) { return value; }
+};
+
+template <typename R>
+Integer toInteger(R&& result) {
+    using T = std::decay_t<R>;
+    if constexpr (std::is_same_v<T, Integer>) {
+        return std::forward<R>(result);
+    } else {
+        static_assert(std::is_integral_v<T>, "native results must be integral or Integer");
+        if constexpr (std::is_unsigned_v<T> && sizeof(T) >= sizeof(int64_t)) {
+            if (result > static_cast<T>(std::numeric_limits<int64_t>::max())) {
+                return Integer::Parse(std::to_string(result));
+            }
+        }
+        return Integer(static_cast<int64_t>(result));
+    }
+}
+
+template <typename Signature>
+struct Traits;
+
+template <typename C, typename R, typename... Args>
+struct Traits<R (C::*)(Args...) const> {
+    using Parameters = std::tuple<std::decay_t<Args>...>;
+    static constexpr size_t kArity = sizeof...(Args);
+};
+
+template <typename C, typename R, typename... Args>
+struct Traits<R (C::*)(Args...)> : Traits<R (C::*)(Args...) const> {};
+
+template <typename R, typename... Args>
+struct Traits<R (*)(Args...)> {
+    using Parameters = std::tuple<std::decay_t<Args>...>;
+    static constexpr size_t kArity = sizeof...(Args);
+};
+
+template <typename F, typename = void>
+struct CallableTraits : Traits<F> {};
+
+template <typename F>
+struct CallableTraits<F, std::void_t<decltype(&F::operator())>> : Traits<decltype(&F::operator())> {};
+
+template <typename F, typename Parameters, size_t... I>
+Integer invoke(const F& fn, const Integer* args, std::index_sequence<I...>) {
+    return toInteger(fn(Argument<std::tuple_element_t<I, Parameters>>::From(args[I])...));
+}
+
+template <typename F>
+Integer thunk(const void* target, const Integer* args) {
+    using Info = CallableTraits<F>;
+    return invoke<F, typename Info::Parameters>(*static_cast<const F*>(target), args,
+                                                std::make_index_sequence<Info::kArity>());
+}
+
+}  // namespace native_detail
+
+// Named C++ functions callable from scripts. A program-defined function of
+// the same name takes precedence over a native one.
+class NativeRegistry {
+public:
+    // Accepts any callable with int64_t / Integer parameters returning an
+    // integral type or Integer: lambdas, function objects, function pointers.
+    template <typename F>
+    void Add(std::string name, F fn) {
+        using Callable = std::decay_t<F>;
+        constexpr size_t arity = native_detail::CallableTraits<Callable>::kArity;
+        static_assert(arity <= kMaxNativeArity, "too many native parameters");
+        NativeFunction function;
+        function.name = name;
+        function.arity = arity;
+        function.thunk = &native_detail::thunk<Callable>;
+        function.target = std::make_shared<const Callable>(std::move(fn));
+        functions_[std::move(name)] = std::move(function);
+    }
+
+    const NativeFunction* Find(const std::string& name) const;
+
+private:
+    std::unordered_map<std::string, NativeFunction> functions_;
+};
+
+#endif // TOY_LANG_NATIVE_REGISTRY
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "native_registry.h"
+#include "../compiler/closure_compiler.h"
+#include "../interpreter/interpreter.h"
+#include "../parser/parser.h"
+
+namespace {
+
+int64_t gcd(int64_t a, int64_t b) {
+    while (b != 0) {
+        a = std::exchange(b, a % b);
+    }
+    return a < 0 ? -a : a;
+}
+
+}  // namespace
+
+class NativeRegistryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        registry_.Add("gcd", gcd);
+        registry_.Add("max", [](int64_t a, int64_t b) { return a < b ? b : a; });
+        registry_.Add("answer", [] { return 42; });
+        registry_.Add("umax", [] { return std::numeric_limits<uint64_t>::max(); });
+        registry_.Add("pow", [](const Integer& base, int64_t exponent) {
+            Integer result(1);
+            for (int64_t i = 0; i < exponent; ++i) {
+                result = result * base;
+            }
+            return result;
+        });
+    }
+
+    std::unique_ptr<Program> parse(const std::string& source) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        return parser.Parse();
+    }
+
+    std::optional<Integer> interpret(const std::string& source) {
+        return Interpreter(&registry_).Run(*parse(source));
+    }
+
+    std::optional<Integer> compile(const std::string& source) {
+        auto program = parse(source);
+        return ClosureProgram(*program, &registry_).Run();
+    }
+
+    NativeRegistry registry_;
+};
+
+TEST_F(NativeRegistryTest, GeneratesThunks) {
+    const NativeFunction* native = registry_.Find("gcd");
+    ASSERT_NE(native, nullptr);
+    EXPECT_EQ(native->arity, 2u);
+    Integer args[] = {Integer(84), Integer(36)};
+    EXPECT_EQ(native->Call(args), 12);
+    EXPECT_EQ(registry_.Find("answer")->arity, 0u);
+    EXPECT_EQ(registry_.Find("missing"), nullptr);
+}
+
+TEST_F(NativeRegistryTest, CallsFromScripts) {
+    const char* source = "x = gcd(84, 36) + max(3, answer())\nreturn pow(x, 20)\n";
+    EXPECT_EQ(interpret(source), Integer::Parse("44450351179593105816204799588171776"));
+    EXPECT_EQ(compile(source), Integer::Parse("44450351179593105816204799588171776"));
+}
+
+TEST_F(NativeRegistryTest, WidensUnsignedResults) {
+    EXPECT_EQ(interpret("return umax() + 1\n"), Integer::Parse("18446744073709551616"));
+    EXPECT_EQ(compile("return umax()\n"), Integer::Parse("18446744073709551615"));
+}
+
+TEST_F(NativeRegistryTest, ProgramFunctionsShadowNatives) {
+    const char* source = "def max(a, b) return 0\nreturn max(1, 2)\n";
+    EXPECT_EQ(interpret(source), 0);
+    EXPECT_EQ(compile(source), 0);
+}
+
+TEST_F(NativeRegistryTest, ReportsErrors) {
+    EXPECT_THROW(interpret("return gcd(1)\n"), RuntimeError);
+    EXPECT_THROW(compile("return gcd(1)\n"), RuntimeError);
+    EXPECT_THROW(interpret("return gcd(99999999999999999999, 3)\n"), RuntimeError);
+    EXPECT_THROW(compile("return gcd(99999999999999999999, 3)\n"), RuntimeError);
+    EXPECT_THROW(Interpreter().Run(*parse("return gcd(1, 2)\n")), NameError);
+}
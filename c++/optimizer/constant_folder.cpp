@@ -0,0 +1,39 @@
+#include "constant_folder.h"
+#include "../interpreter/interpreter.h"
+
+size_t FoldConstants(std::unique_ptr<Expression>& expr) {
+    if (auto binary = dynamic_cast<BinaryExpr*>(expr.get())) {
+        size_t folded = FoldConstants(binary->left) + FoldConstants(binary->right);
+        auto left = dynamic_cast<NumberExpr*>(binary->left.get());
+        auto right = dynamic_cast<NumberExpr*>(binary->right.get());
+        if (!left || !right) {
+            return folded;
+        }
+        if (binary->op == OperatorToken::DIVIDE && right->value.IsZero()) {
+            return folded;
+        }
+        expr = std::make_unique<NumberExpr>(ApplyOperator(binary->op, left->value, right->value));
+        return folded + 2;
+    }
+    if (auto ternary = dynamic_cast<TernaryExpr*>(expr.get())) {
+        size_t folded = FoldConstants(ternary->cond) + FoldConstants(ternary->then_expr) +
+                        FoldConstants(ternary->else_expr);
+        auto cond = dynamic_cast<NumberExpr*>(ternary->cond.get());
+        if (!cond) {
+            return folded;
+        }
+        auto& taken = !cond->value.IsZero() ? ternary->then_expr : ternary->else_expr;
+        auto& dropped = !cond->value.IsZero() ? ternary->else_expr : ternary->then_expr;
+        folded += 2 + CountNodes(*dropped);
+        expr = std::move(taken);
+        return folded;
+    }
+    if (auto call = dynamic_cast<CallExpr*>(expr.get())) {
+        size_t folded = 0;
+        for (auto& arg : call->args) {
+            folded += FoldConstants(arg);
+        }
+        return folded;
+    }
+    return 0;
+}
@@ -0,0 +1,12 @@
+#ifndef TOY_LANG_CONSTANT_FOLDER
+#define TOY_LANG_CONSTANT_FOLDER
+
+#include <memory>
+#include "../ast/ast.h"
+
+// Folds operators applied to literals and ternaries whose condition is a
+// literal, in place. Divisions by a literal zero are left for the evaluator to
+// report. Returns the number of nodes that were folded away.
+size_t FoldConstants(std::unique_ptr<Expression>& expr);
+
+#endif // TOY_LANG_CONSTANT_FOLDER
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "constant_folder.h"
+#include "../parser/parser.h"
+
+class ConstantFolderTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Expression> parseExpr(const std::string& source) {
+        std::stringstream ss("x = " + source + "\n");
+        Parser parser(&ss);
+        auto program = parser.Parse();
+        return std::move(dynamic_cast<Assignment*>(program->statements[0].get())->value);
+    }
+};
+
+TEST_F(ConstantFolderTest, FoldsArithmetic) {
+    auto expr = parseExpr("(1 + 2) * 3 - 4 / 2");
+    EXPECT_EQ(FoldConstants(expr), 8);
+    auto number = dynamic_cast<NumberExpr*>(expr.get());
+    ASSERT_NE(number, nullptr);
+    EXPECT_EQ(number->value, 7);
+}
+
+TEST_F(ConstantFolderTest, FoldsTernaryWithLiteralCondition) {
+    auto expr = parseExpr("if 2 < 1 then y else y + 1");
+    FoldConstants(expr);
+    auto binary = dynamic_cast<BinaryExpr*>(expr.get());
+    ASSERT_NE(binary, nullptr);
+    EXPECT_EQ(binary->op, OperatorToken::PLUS);
+}
+
+TEST_F(ConstantFolderTest, KeepsDivisionByZero) {
+    auto expr = parseExpr("1 / 0");
+    EXPECT_EQ(FoldConstants(expr), 0);
+    EXPECT_NE(dynamic_cast<BinaryExpr*>(expr.get()), nullptr);
+}
+
+TEST_F(ConstantFolderTest, LeavesVariablesAlone) {
+    auto expr = parseExpr("f(y + 1, 2 * 3)");
+    EXPECT_EQ(FoldConstants(expr), 2);
+    auto call = dynamic_cast<CallExpr*>(expr.get());
+    ASSERT_NE(call, nullptr);
+    EXPECT_NE(dynamic_cast<BinaryExpr*>(call->args[0].get()), nullptr);
+    EXPECT_NE(dynamic_cast<NumberExpr*>(call->args[1].get()), nullptr);
+}
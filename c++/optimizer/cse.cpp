@@ -0,0 +1,238 @@
+#include "cse.h"
+#include "../error.h"
+#include "../interpreter/interpreter.h"
+#include <algorithm>
+#include <functional>
+
+size_t DagNodeHash::operator()(const DagNode& node) const {
+    size_t hash = std::hash<std::string>()(node.name);
+    auto mix = [&hash](size_t value) {
+        hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    };
+    mix(static_cast<size_t>(node.kind));
+    mix(static_cast<size_t>(node.op));
+    mix(node.literal.Hash());
+    mix(node.slot);
+    for (uint32_t operand : node.operands) {
+        mix(operand);
+    }
+    return hash;
+}
+
+ExpressionDag::ExpressionDag(std::vector<std::string> params) : params_(std::move(params)) {}
+
+uint32_t ExpressionDag::Add(const Expression& expr) {
+    DagNode node;
+    if (auto number = dynamic_cast<const NumberExpr*>(&expr)) {
+        return addNumber(number->value);
+    } else if (auto variable = dynamic_cast<const VariableExpr*>(&expr)) {
+        return addVariable(variable->name);
+    } else if (auto binary = dynamic_cast<const BinaryExpr*>(&expr)) {
+        node.kind = DagKind::BINARY;
+        node.op = binary->op;
+        node.operands = {Add(*binary->left), Add(*binary->right)};
+    } else if (auto ternary = dynamic_cast<const TernaryExpr*>(&expr)) {
+        node.kind = DagKind::TERNARY;
+        node.operands = {Add(*ternary->cond), Add(*ternary->then_expr), Add(*ternary->else_expr)};
+    } else if (auto call = dynamic_cast<const CallExpr*>(&expr)) {
+        node.kind = DagKind::CALL;
+        node.name = call->callee;
+        for (const auto& arg : call->args) {
+            node.operands.push_back(Add(*arg));
+        }
+    } else if (auto fused = dynamic_cast<const VarLessConstExpr*>(&expr)) {
+        // Fused nodes enter the graph in the core shape they stand for, so
+        // they share with unfused copies of the same subexpression.
+        node.kind = DagKind::BINARY;
+        node.op = OperatorToken::LESS;
+        node.operands = {addVariable(fused->name), addNumber(fused->constant)};
+    } else if (auto fused = dynamic_cast<const VarSubConstExpr*>(&expr)) {
+        node.kind = DagKind::BINARY;
+        node.op = OperatorToken::MINUS;
+        node.operands = {addVariable(fused->name), addNumber(fused->constant)};
+    } else if (auto fused = dynamic_cast<const CallVarSubConstExpr*>(&expr)) {
+        DagNode arg;
+        arg.kind = DagKind::BINARY;
+        arg.op = OperatorToken::MINUS;
+        arg.operands = {addVariable(fused->name), addNumber(fused->constant)};
+        node.kind = DagKind::CALL;
+        node.name = fused->callee;
+        node.operands = {intern(std::move(arg))};
+    } else if (auto fused = dynamic_cast<const IfVarEqConstExpr*>(&expr)) {
+        DagNode cond;
+        cond.kind = DagKind::BINARY;
+        cond.op = OperatorToken::EQ_EQ;
+        cond.operands = {addVariable(fused->name), addNumber(fused->constant)};
+        node.kind = DagKind::TERNARY;
+        node.operands = {intern(std::move(cond)), Add(*fused->then_expr), Add(*fused->else_expr)};
+    } else {
+        throw RuntimeError("Unknown expression node");
+    }
+    return intern(std::move(node));
+}
+
+uint32_t ExpressionDag::addNumber(const Integer& value) {
+    DagNode node;
+    node.kind = DagKind::NUMBER;
+    node.literal = value;
+    return intern(std::move(node));
+}
+
+uint32_t ExpressionDag::addVariable(const std::string& name) {
+    DagNode node;
+    auto param = std::find(params_.begin(), params_.end(), name);
+    if (param != params_.end()) {
+        node.kind = DagKind::PARAM;
+        node.slot = static_cast<uint32_t>(param - params_.begin());
+    } else {
+        node.kind = DagKind::GLOBAL;
+        node.name = name;
+    }
+    return intern(std::move(node));
+}
+
+uint32_t ExpressionDag::intern(DagNode node) {
+    auto it = index_.find(node);
+    if (it != index_.end()) {
+        return it->second;
+    }
+    auto id = static_cast<uint32_t>(nodes_.size());
+    nodes_.push_back(node);
+    index_.emplace(std::move(node), id);
+    return id;
+}
+
+CseInterpreter::CseInterpreter(const Program& program) {
+    functions_.reserve(program.statements.size());
+    for (const auto& stmt : program.statements) {
+        Step step;
+        const Expression* value = nullptr;
+        if (auto func = dynamic_cast<const FunctionDef*>(stmt.get())) {
+            Function compiled{func->name, func->params.size(), ExpressionDag(func->params), std::nullopt};
+            const Expression* body = nullptr;
+            if (auto ret = dynamic_cast<const Return*>(func->Body())) {
+                body = ret->value.get();
+            } else if (auto assignment = dynamic_cast<const Assignment*>(func->Body())) {
+                body = assignment->value.get();
+            }
+            if (body) {
+                compiled.root = compiled.dag.Add(*body);
+                stats_.tree_nodes += CountNodes(*body);
+                stats_.dag_nodes += compiled.dag.Size();
+            }
+            step.kind = StepKind::DEFINE;
+            step.name = func->name;
+            step.function = functions_.size();
+            functions_.push_back(std::move(compiled));
+            steps_.push_back(std::move(step));
+            continue;
+        }
+        if (auto assignment = dynamic_cast<const Assignment*>(stmt.get())) {
+            step.kind = StepKind::ASSIGN;
+            step.name = assignment->name;
+            value = assignment->value.get();
+        } else if (auto ret = dynamic_cast<const Return*>(stmt.get())) {
+            step.kind = StepKind::RETURN;
+            value = ret->value.get();
+        } else {
+            continue;
+        }
+        step.root = step.dag.Add(*value);
+        stats_.tree_nodes += CountNodes(*value);
+        stats_.dag_nodes += step.dag.Size();
+        steps_.push_back(std::move(step));
+    }
+}
+
+std::optional<Integer> CseInterpreter::Run() {
+    values_.clear();
+    ready_.clear();
+    args_.clear();
+    for (const auto& step : steps_) {
+        switch (step.kind) {
+            case StepKind::DEFINE:
+                bound_[step.name] = &functions_[step.function];
+                break;
+            case StepKind::ASSIGN:
+                globals_[step.name] = evaluate(step.dag, step.root, 0);
+                break;
+            case StepKind::RETURN:
+                return evaluate(step.dag, step.root, 0);
+        }
+    }
+    return std::nullopt;
+}
+
+Integer CseInterpreter::GetGlobal(const std::string& name) const {
+    auto it = globals_.find(name);
+    if (it == globals_.end()) {
+        throw NameError("Undefined variable: " + name);
+    }
+    return it->second;
+}
+
+Integer CseInterpreter::evaluate(const ExpressionDag& dag, uint32_t root, size_t args_base) {
+    size_t base = values_.size();
+    values_.resize(base + dag.Size());
+    ready_.resize(base + dag.Size(), 0);
+    Integer result = eval(dag, root, base, args_base);
+    values_.resize(base);
+    ready_.resize(base);
+    return result;
+}
+
+Integer CseInterpreter::eval(const ExpressionDag& dag, uint32_t id, size_t base, size_t args_base) {
+    if (ready_[base + id]) {
+        return values_[base + id];
+    }
+    const DagNode& node = dag.Node(id);
+    Integer result;
+    switch (node.kind) {
+        case DagKind::NUMBER:
+            return node.literal;
+        case DagKind::PARAM:
+            return args_[args_base + node.slot];
+        case DagKind::GLOBAL:
+            return GetGlobal(node.name);
+        case DagKind::BINARY: {
+            Integer left = eval(dag, node.operands[0], base, args_base);
+            Integer right = eval(dag, node.operands[1], base, args_base);
+            result = ApplyOperator(node.op, left, right);
+            break;
+        }
+        case DagKind::TERNARY:
+            result = !eval(dag, node.operands[0], base, args_base).IsZero()
+                         ? eval(dag, node.operands[1], base, args_base)
+                         : eval(dag, node.operands[2], base, args_base);
+            break;
+        case DagKind::CALL:
+            result = call(node, dag, base, args_base);
+            break;
+    }
+    values_[base + id] = result;
+    ready_[base + id] = 1;
+    return result;
+}
+
+Integer CseInterpreter::call(const DagNode& node, const ExpressionDag& dag, size_t base, size_t args_base) {
+    auto it = bound_.find(node.name);
+    if (it == bound_.end()) {
+        throw NameError("Undefined function: " + node.name);
+    }
+    const Function& func = *it->second;
+    if (func.arity != node.operands.size()) {
+        throw RuntimeError("Function '" + func.name + "' expects " + std::to_string(func.arity) +
+                           " arguments, got " + std::to_string(node.operands.size()));
+    }
+    size_t callee_args = args_.size();
+    for (uint32_t operand : node.operands) {
+        Integer value = eval(dag, operand, base, args_base);
+        args_.push_back(std::move(value));
+    }
+    if (!func.root) {
+        throw RuntimeError("Function '" + func.name + "' does not return a value");
+    }
+    Integer result = evaluate(func.dag, *func.root, callee_args);
+    args_.resize(callee_args);
+    return result;
+}
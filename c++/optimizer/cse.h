@@ -0,0 +1,117 @@
+#ifndef TOY_LANG_CSE
+#define TOY_LANG_CSE
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../ast/ast.h"
+
+enum class DagKind {
+    NUMBER,
+    PARAM,
+    GLOBAL,
+    BINARY,
+    TERNARY,
+    CALL
+};
+
+struct DagNode {
+    DagKind kind;
+    OperatorToken op = OperatorToken::PLUS;
+    Integer literal;
+    uint32_t slot = 0;
+    std::string name;          // global or callee name
+    std::vector<uint32_t> operands;
+
+    bool operator==(const DagNode& other) const {
+        return kind == other.kind && op == other.op && literal == other.literal && slot == other.slot &&
+               name == other.name && operands == other.operands;
+    }
+};
+
+struct DagNodeHash {
+    size_t operator()(const DagNode& node) const;
+};
+
+// Hash-consed expression graph: structurally identical subexpressions are
+// stored once, and every operand index is smaller than its user's index.
+// Fused nodes are added in their core shape.
+class ExpressionDag {
+public:
+    explicit ExpressionDag(std::vector<std::string> params = {});
+
+    uint32_t Add(const Expression& expr);
+
+    const DagNode& Node(uint32_t id) const { return nodes_[id]; }
+    size_t Size() const { return nodes_.size(); }
+
+private:
+    std::vector<std::string> params_;
+    std::vector<DagNode> nodes_;
+    std::unordered_map<DagNode, uint32_t, DagNodeHash> index_;
+
+    uint32_t intern(DagNode node);
+    uint32_t addNumber(const Integer& value);
+    uint32_t addVariable(const std::string& name);
+};
+
+struct CseStats {
+    size_t tree_nodes = 0;
+    size_t dag_nodes = 0;
+
+    double DedupRatio() const {
+        return dag_nodes == 0 ? 1.0 : static_cast<double>(tree_nodes) / dag_nodes;
+    }
+};
+
+// Evaluates a Program with one ExpressionDag per function body and per
+// top-level statement. Each unique subexpression is computed at most once per
+// invocation; ternary arms stay lazy, so sharing never evaluates an arm the
+// tree evaluator would have skipped.
+class CseInterpreter {
+public:
+    explicit CseInterpreter(const Program& program);
+
+    std::optional<Integer> Run();
+
+    Integer GetGlobal(const std::string& name) const;
+    const CseStats& Stats() const { return stats_; }
+
+private:
+    struct Function {
+        std::string name;
+        size_t arity;
+        ExpressionDag dag;
+        std::optional<uint32_t> root;  // empty when the body does not yield a value
+    };
+
+    enum class StepKind { DEFINE, ASSIGN, RETURN };
+
+    struct Step {
+        StepKind kind;
+        std::string name;
+        size_t function;    // DEFINE: index into functions_
+        ExpressionDag dag;  // ASSIGN / RETURN
+        uint32_t root = 0;
+    };
+
+    std::vector<Function> functions_;
+    std::vector<Step> steps_;
+    CseStats stats_;
+
+    std::unordered_map<std::string, Integer> globals_;
+    std::unordered_map<std::string, const Function*> bound_;
+
+    // Memo slots of all active invocations; each frame owns dag.Size() slots.
+    std::vector<Integer> values_;
+    std::vector<uint8_t> ready_;
+    std::vector<Integer> args_;
+
+    Integer evaluate(const ExpressionDag& dag, uint32_t root, size_t args_base);
+    Integer eval(const ExpressionDag& dag, uint32_t id, size_t base, size_t args_base);
+    Integer call(const DagNode& node, const ExpressionDag& dag, size_t base, size_t args_base);
+};
+
+#endif // TOY_LANG_CSE
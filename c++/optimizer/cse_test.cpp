@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "cse.h"
+#include "fusion.h"
+#include "../interpreter/interpreter.h"
+#include "../parser/parser.h"
+
+class CseTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Program> parse(const std::string& source) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        return parser.Parse();
+    }
+
+    std::unique_ptr<Expression> parseExpr(const std::string& source) {
+        auto program = parse("x = " + source + "\n");
+        return std::move(dynamic_cast<Assignment*>(program->statements[0].get())->value);
+    }
+};
+
+TEST_F(CseTest, SharesIdenticalSubtrees) {
+    auto expr = parseExpr("(a + b) * (a + b)");
+    ExpressionDag dag;
+    uint32_t root = dag.Add(*expr);
+    EXPECT_EQ(dag.Size(), 4);
+    const DagNode& product = dag.Node(root);
+    ASSERT_EQ(product.operands.size(), 2);
+    EXPECT_EQ(product.operands[0], product.operands[1]);
+}
+
+TEST_F(CseTest, DistinguishesOperatorsAndOperandOrder) {
+    ExpressionDag dag;
+    uint32_t sum = dag.Add(*parseExpr("a + b"));
+    EXPECT_NE(dag.Add(*parseExpr("b + a")), sum);
+    EXPECT_NE(dag.Add(*parseExpr("a - b")), sum);
+    EXPECT_EQ(dag.Add(*parseExpr("a + b")), sum);
+}
+
+TEST_F(CseTest, ResolvesParametersToSlots) {
+    ExpressionDag dag({"x"});
+    const DagNode& node = dag.Node(dag.Add(*parseExpr("x + y")));
+    EXPECT_EQ(dag.Node(node.operands[0]).kind, DagKind::PARAM);
+    EXPECT_EQ(dag.Node(node.operands[1]).kind, DagKind::GLOBAL);
+}
+
+TEST_F(CseTest, SharesCallsAcrossTernaryArms) {
+    auto program = parse(
+        "def f(n) return n * 2\n"
+        "def g(n) return if n < 0 then f(n + 1) - 1 else f(n + 1) + 1\n");
+    CseInterpreter interpreter(*program);
+    EXPECT_EQ(interpreter.Stats().tree_nodes, 3 + 16);
+    EXPECT_EQ(interpreter.Stats().dag_nodes, 3 + 9);
+    EXPECT_GT(interpreter.Stats().DedupRatio(), 1.0);
+}
+
+TEST_F(CseTest, MatchesTreeInterpreter) {
+    const char* source =
+        "k = 3\n"
+        "def sq(x) return x * x\n"
+        "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\n"
+        "def h(a, b) return (a + b) * (a + b) - sq(a + b) + k * sq(a - b)\n"
+        "def add(x, y)\n    x = x + y\n"
+        "y = h(2, 5) + add(fib(15), 1)\n"
+        "return y + (y - 1) / (y - 1)\n";
+    auto program = parse(source);
+    Interpreter reference;
+    CseInterpreter interpreter(*program);
+    EXPECT_EQ(interpreter.Run(), reference.Run(*program));
+    EXPECT_EQ(interpreter.GetGlobal("y"), reference.GetGlobal("y"));
+}
+
+TEST_F(CseTest, ReportsErrorsLikeTreeInterpreter) {
+    EXPECT_THROW(CseInterpreter(*parse("x = y\n")).Run(), NameError);
+    EXPECT_THROW(CseInterpreter(*parse("x = f(1)\n")).Run(), NameError);
+    EXPECT_THROW(CseInterpreter(*parse("x = 1 / (2 - 2)\n")).Run(), RuntimeError);
+    EXPECT_THROW(CseInterpreter(*parse("def f(a) return a\nx = f(1, 2)\n")).Run(), RuntimeError);
+    EXPECT_NO_THROW(CseInterpreter(*parse("x = if 1 then 2 else 1 / 0\n")).Run());
+}
+
+TEST_F(CseTest, AddsFusedNodesInCoreShape) {
+    auto expr = parseExpr("if n == 0 then f(n - 1) else (n - 1) + (n < 2)");
+    ExpressionDag plain({"n"});
+    plain.Add(*expr);
+    ASSERT_EQ(FuseExpressions(expr), 4u);
+    ExpressionDag fused({"n"});
+    fused.Add(*expr);
+    EXPECT_EQ(fused.Size(), plain.Size());
+
+    auto program = parse(
+        "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\n"
+        "def sum(n) return if n == 0 then 0 else n + sum(n - 1)\n"
+        "return fib(12) + sum(20)\n");
+    auto expected = Interpreter().Run(*program);
+    ASSERT_GT(FuseExpressions(*program), 0u);
+    EXPECT_EQ(CseInterpreter(*program).Run(), expected);
+}
@@ -0,0 +1,152 @@
+#include "dead_code.h"
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
+#include <utility>
+#include "../analysis/dependencies.h"
+
+namespace {
+
+constexpr size_t kUnbound = static_cast<size_t>(-1);
+
+// The latest binding of `name` strictly before `position`.
+size_t latestBefore(const std::unordered_map<std::string, std::vector<size_t>>& bindings,
+                    const std::string& name, size_t position) {
+    auto it = bindings.find(name);
+    if (it == bindings.end()) {
+        return kUnbound;
+    }
+    auto next = std::lower_bound(it->second.begin(), it->second.end(), position);
+    return next == it->second.begin() ? kUnbound : *std::prev(next);
+}
+
+}  // namespace
+
+DeadCodeEliminator::DeadCodeEliminator(DeadCodeOptions options) : options_(std::move(options)) {}
+
+DeadCodeReport DeadCodeEliminator::Run(Program& program) {
+    program_ = &program;
+    globals_.clear();
+    functions_.clear();
+    summaries_.clear();
+
+    auto& statements = program.statements;
+    size_t end = statements.size();
+    for (size_t i = 0; i < statements.size(); ++i) {
+        if (dynamic_cast<const Return*>(statements[i].get())) {
+            end = i + 1;
+            break;
+        }
+    }
+    live_.assign(end, false);
+    collectBindings(end);
+    for (const auto& root : options_.roots) {
+        markGlobal(root, end);
+        markFunctions({root}, end);
+    }
+    // Reads resolve to earlier statements only, so one backward sweep reaches
+    // every live statement.
+    for (size_t i = end; i-- > 0;) {
+        if (!live_[i]) {
+            continue;
+        }
+        if (auto assignment = dynamic_cast<const Assignment*>(statements[i].get())) {
+            markReads(*assignment->value, i);
+        } else if (auto ret = dynamic_cast<const Return*>(statements[i].get())) {
+            markReads(*ret->value, i);
+        }
+    }
+
+    DeadCodeReport report;
+    std::vector<std::unique_ptr<Statement>> kept;
+    for (size_t i = 0; i < statements.size(); ++i) {
+        if (i >= end) {
+            ++report.unreachable;
+        } else if (live_[i]) {
+            kept.push_back(std::move(statements[i]));
+        } else if (auto func = dynamic_cast<const FunctionDef*>(statements[i].get())) {
+            report.functions.push_back(func->name);
+        } else {
+            report.assignments.push_back(static_cast<const Assignment&>(*statements[i]).name);
+        }
+    }
+    statements = std::move(kept);
+    program_ = nullptr;
+    return report;
+}
+
+void DeadCodeEliminator::collectBindings(size_t end) {
+    const auto& statements = program_->statements;
+    for (size_t i = 0; i < end; ++i) {
+        if (auto func = dynamic_cast<const FunctionDef*>(statements[i].get())) {
+            functions_[func->name].push_back(i);
+        } else if (auto assignment = dynamic_cast<const Assignment*>(statements[i].get())) {
+            globals_[assignment->name].push_back(i);
+        } else {
+            live_[i] = true;
+        }
+    }
+}
+
+void DeadCodeEliminator::markReads(const Expression& expr, size_t position) {
+    static const std::vector<std::string> no_params;
+    std::unordered_set<std::string> globals;
+    std::unordered_set<std::string> callees;
+    CollectNames(expr, no_params, globals, callees);
+    for (const auto& global : globals) {
+        markGlobal(global, position);
+    }
+    markFunctions({callees.begin(), callees.end()}, position);
+}
+
+void DeadCodeEliminator::markGlobal(const std::string& name, size_t position) {
+    size_t source = latestBefore(globals_, name, position);
+    if (source != kUnbound) {
+        live_[source] = true;
+    }
+}
+
+// Function bodies resolve names when called, so everything a callee reads,
+// directly or through its own callees, is read at `position`.
+void DeadCodeEliminator::markFunctions(std::vector<std::string> pending, size_t position) {
+    std::unordered_set<std::string> seen(pending.begin(), pending.end());
+    while (!pending.empty()) {
+        std::string callee = std::move(pending.back());
+        pending.pop_back();
+        size_t def = latestBefore(functions_, callee, position);
+        if (def == kUnbound) {
+            continue;  // a native, or a NameError at run time
+        }
+        live_[def] = true;
+        const Summary& summary = summarize(def);
+        for (const auto& global : summary.globals) {
+            markGlobal(global, position);
+        }
+        for (const auto& next : summary.callees) {
+            if (seen.insert(next).second) {
+                pending.push_back(next);
+            }
+        }
+    }
+}
+
+const DeadCodeEliminator::Summary& DeadCodeEliminator::summarize(size_t def) {
+    auto it = summaries_.find(def);
+    if (it != summaries_.end()) {
+        return it->second;
+    }
+    const auto& func = static_cast<const FunctionDef&>(*program_->statements[def]);
+    std::unordered_set<std::string> globals;
+    std::unordered_set<std::string> callees;
+    const Expression* body = nullptr;
+    if (auto ret = dynamic_cast<const Return*>(func.Body())) {
+        body = ret->value.get();
+    } else if (auto assignment = dynamic_cast<const Assignment*>(func.Body())) {
+        body = assignment->value.get();
+    }
+    if (body) {
+        CollectNames(*body, func.params, globals, callees);
+    }
+    Summary summary{{globals.begin(), globals.end()}, {callees.begin(), callees.end()}};
+    return summaries_.emplace(def, std::move(summary)).first->second;
+}
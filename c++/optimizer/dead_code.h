@@ -0,0 +1,55 @@
+#ifndef TOY_LANG_DEAD_CODE
+#define TOY_LANG_DEAD_CODE
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../ast/ast.h"
+
+struct DeadCodeOptions {
+    // Globals and functions the host reads or calls once the program has run.
+    std::vector<std::string> roots;
+};
+
+struct DeadCodeReport {
+    std::vector<std::string> functions;    // pruned defs, in program order
+    std::vector<std::string> assignments;  // pruned top-level assignments, in program order
+    size_t unreachable = 0;                // statements after the first top-level return
+};
+
+// Removes the top-level statements nothing live can observe.
+//
+// The first top-level return and the final bindings of the roots are live. A
+// live statement keeps alive the assignments and defs its reads resolve to at
+// its position, as sequential execution would see them: function bodies look
+// up globals when called, so the globals and callees of a called body resolve
+// at the call site too. Bodies of functions that are never reached are not
+// parsed. Pruning an assignment also drops any error its value would raise.
+class DeadCodeEliminator {
+public:
+    explicit DeadCodeEliminator(DeadCodeOptions options = {});
+
+    DeadCodeReport Run(Program& program);
+
+private:
+    struct Summary {
+        std::vector<std::string> globals;
+        std::vector<std::string> callees;
+    };
+
+    DeadCodeOptions options_;
+    const Program* program_ = nullptr;
+    // Positions of the statements binding each name, in program order.
+    std::unordered_map<std::string, std::vector<size_t>> globals_;
+    std::unordered_map<std::string, std::vector<size_t>> functions_;
+    std::unordered_map<size_t, Summary> summaries_;
+    std::vector<bool> live_;
+
+    void collectBindings(size_t end);
+    void markReads(const Expression& expr, size_t position);
+    void markGlobal(const std::string& name, size_t position);
+    void markFunctions(std::vector<std::string> pending, size_t position);
+    const Summary& summarize(size_t def);
+};
+
+#endif // TOY_LANG_DEAD_CODE
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "dead_code.h"
+#include "fusion.h"
+#include "../interpreter/interpreter.h"
+#include "../parser/parser.h"
+
+class DeadCodeTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Program> parse(const std::string& source, ParserOptions options = {}) {
+        std::stringstream ss(source);
+        Parser parser(&ss, options);
+        return parser.Parse();
+    }
+
+    static std::vector<std::string> names(const Program& program) {
+        std::vector<std::string> result;
+        for (const auto& stmt : program.statements) {
+            if (auto func = dynamic_cast<const FunctionDef*>(stmt.get())) {
+                result.push_back("def " + func->name);
+            } else if (auto assignment = dynamic_cast<const Assignment*>(stmt.get())) {
+                result.push_back(assignment->name);
+            } else {
+                result.push_back("return");
+            }
+        }
+        return result;
+    }
+};
+
+TEST_F(DeadCodeTest, KeepsWhatTheReturnReaches) {
+    const char* source =
+        "def square(x) return x * x\n"
+        "def cube(x) return x * square(x)\n"
+        "def unused(x) return cube(x) + 1\n"
+        "base = 3\n"
+        "spare = base * 2\n"
+        "return cube(base)\n"
+        "after = 1\n";
+    auto program = parse(source);
+    auto report = DeadCodeEliminator().Run(*program);
+    using Names = std::vector<std::string>;
+    EXPECT_EQ(names(*program), (Names{"def square", "def cube", "base", "return"}));
+    EXPECT_EQ(report.functions, Names{"unused"});
+    EXPECT_EQ(report.assignments, Names{"spare"});
+    EXPECT_EQ(report.unreachable, 1u);
+    EXPECT_EQ(Interpreter().Run(*program), 27);
+}
+
+TEST_F(DeadCodeTest, DropsOverwrittenAssignments) {
+    auto program = parse("x = 1\ny = x + 1\nx = 10\nx = x + y\nz = x\n");
+    auto report = DeadCodeEliminator({{"x"}}).Run(*program);
+    using Names = std::vector<std::string>;
+    EXPECT_EQ(names(*program), (Names{"x", "y", "x", "x"}));
+    EXPECT_EQ(report.assignments, Names{"z"});
+    Interpreter interpreter;
+    interpreter.Run(*program);
+    EXPECT_EQ(interpreter.GetGlobal("x"), 12);
+}
+
+TEST_F(DeadCodeTest, ResolvesBodiesAtTheCallSite) {
+    // `get` reads `scale` when it is called, so the first binding is dead and
+    // the redefinition of `get` after the last call is what the root sees.
+    const char* source =
+        "scale = 2\n"
+        "def get(x) return x * scale\n"
+        "scale = 3\n"
+        "a = get(1)\n"
+        "scale = 4\n"
+        "def get(x) return x\n";
+    auto program = parse(source);
+    auto report = DeadCodeEliminator({{"a", "get"}}).Run(*program);
+    using Names = std::vector<std::string>;
+    EXPECT_EQ(names(*program), (Names{"def get", "scale", "a", "def get"}));
+    EXPECT_EQ(report.assignments, (Names{"scale", "scale"}));
+    Interpreter interpreter;
+    interpreter.Run(*program);
+    EXPECT_EQ(interpreter.GetGlobal("a"), 3);
+}
+
+TEST_F(DeadCodeTest, FollowsFusedNodesAndRecursion) {
+    const char* source =
+        "def fact(n) return if n == 0 then 1 else n * fact(n - 1)\n"
+        "def count(n) return if n < limit then count(n + 1) else n\n"
+        "limit = 5\n"
+        "return fact(count(0))\n";
+    auto program = parse(source);
+    ASSERT_GT(FuseExpressions(*program), 0u);
+    auto report = DeadCodeEliminator().Run(*program);
+    EXPECT_TRUE(report.functions.empty());
+    EXPECT_TRUE(report.assignments.empty());
+    EXPECT_EQ(Interpreter().Run(*program), 120);
+}
+
+TEST_F(DeadCodeTest, LeavesUnreachedBodiesUnparsed) {
+    auto program = parse("def used(x) return x + 1\ndef unused(x) return x +\nreturn used(1)\n",
+                         ParserOptions{true});
+    auto report = DeadCodeEliminator().Run(*program);
+    EXPECT_EQ(report.functions, std::vector<std::string>{"unused"});
+    ASSERT_EQ(program->statements.size(), 2u);
+    EXPECT_TRUE(dynamic_cast<const FunctionDef*>(program->statements[0].get())->IsBodyParsed());
+    EXPECT_EQ(Interpreter().Run(*program), 2);
+}
@@ -0,0 +1,98 @@
+#include "fusion.h"
+
+namespace {
+
+bool isVarConst(const BinaryExpr& binary, OperatorToken op) {
+    return binary.op == op && binary.left->kind == ExprKind::VARIABLE &&
+           binary.right->kind == ExprKind::NUMBER;
+}
+
+const std::string& varName(const BinaryExpr& binary) {
+    return static_cast<const VariableExpr&>(*binary.left).name;
+}
+
+const Integer& constant(const BinaryExpr& binary) {
+    return static_cast<const NumberExpr&>(*binary.right).value;
+}
+
+size_t fuseStatement(Statement& stmt) {
+    if (auto ret = dynamic_cast<Return*>(&stmt)) {
+        return FuseExpressions(ret->value);
+    }
+    if (auto assignment = dynamic_cast<Assignment*>(&stmt)) {
+        return FuseExpressions(assignment->value);
+    }
+    if (auto func = dynamic_cast<FunctionDef*>(&stmt)) {
+        return fuseStatement(*func->Body());
+    }
+    return 0;
+}
+
+}  // namespace
+
+size_t FuseExpressions(std::unique_ptr<Expression>& expr) {
+    switch (expr->kind) {
+        case ExprKind::BINARY: {
+            auto& binary = static_cast<BinaryExpr&>(*expr);
+            size_t fused = FuseExpressions(binary.left) + FuseExpressions(binary.right);
+            if (isVarConst(binary, OperatorToken::LESS)) {
+                expr = std::make_unique<VarLessConstExpr>(varName(binary), constant(binary));
+                return fused + 1;
+            }
+            if (isVarConst(binary, OperatorToken::MINUS)) {
+                expr = std::make_unique<VarSubConstExpr>(varName(binary), constant(binary));
+                return fused + 1;
+            }
+            return fused;
+        }
+        case ExprKind::CALL: {
+            // The argument is matched before it is fused itself, so no
+            // VarSubConstExpr is created only to be absorbed by the call.
+            auto& call = static_cast<CallExpr&>(*expr);
+            if (call.args.size() == 1 && call.args[0]->kind == ExprKind::BINARY &&
+                isVarConst(static_cast<BinaryExpr&>(*call.args[0]), OperatorToken::MINUS)) {
+                auto& arg = static_cast<BinaryExpr&>(*call.args[0]);
+                expr = std::make_unique<CallVarSubConstExpr>(call.callee, varName(arg), constant(arg));
+                return 1;
+            }
+            size_t fused = 0;
+            for (auto& arg : call.args) {
+                fused += FuseExpressions(arg);
+            }
+            if (call.args.size() == 1 && call.args[0]->kind == ExprKind::VAR_SUB_CONST) {
+                // Fused by an earlier run.
+                auto& arg = static_cast<VarSubConstExpr&>(*call.args[0]);
+                expr = std::make_unique<CallVarSubConstExpr>(call.callee, arg.name, arg.constant);
+                return fused + 1;
+            }
+            return fused;
+        }
+        case ExprKind::TERNARY: {
+            auto& ternary = static_cast<TernaryExpr&>(*expr);
+            size_t fused = FuseExpressions(ternary.then_expr) + FuseExpressions(ternary.else_expr);
+            if (ternary.cond->kind == ExprKind::BINARY &&
+                isVarConst(static_cast<BinaryExpr&>(*ternary.cond), OperatorToken::EQ_EQ)) {
+                auto& cond = static_cast<BinaryExpr&>(*ternary.cond);
+                expr = std::make_unique<IfVarEqConstExpr>(varName(cond), constant(cond),
+                                                          std::move(ternary.then_expr),
+                                                          std::move(ternary.else_expr));
+                return fused + 1;
+            }
+            return fused + FuseExpressions(ternary.cond);
+        }
+        case ExprKind::IF_VAR_EQ_CONST: {
+            auto& fused = static_cast<IfVarEqConstExpr&>(*expr);
+            return FuseExpressions(fused.then_expr) + FuseExpressions(fused.else_expr);
+        }
+        default:
+            return 0;
+    }
+}
+
+size_t FuseExpressions(Program& program) {
+    size_t fused = 0;
+    for (auto& stmt : program.statements) {
+        fused += fuseStatement(*stmt);
+    }
+    return fused;
+}
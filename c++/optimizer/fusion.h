@@ -0,0 +1,16 @@
+#ifndef TOY_LANG_FUSION
+#define TOY_LANG_FUSION
+
+#include <memory>
+#include "../ast/ast.h"
+
+// Rewrites frequent expression shapes into the fused nodes declared in
+// ast.h: `v < c`, `v - c`, `f(v - c)` and `if v == c then a else b`, where v
+// is a variable and c a literal. The inliner and CSE accept fused nodes, but
+// the constant folder sees through none of them, so this is best run last,
+// right before execution.
+// Returns the number of fused nodes created.
+size_t FuseExpressions(std::unique_ptr<Expression>& expr);
+size_t FuseExpressions(Program& program);
+
+#endif // TOY_LANG_FUSION
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "fusion.h"
+#include "../interpreter/interpreter.h"
+#include "../parser/parser.h"
+
+class FusionTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Program> parse(const std::string& source) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        return parser.Parse();
+    }
+
+    std::unique_ptr<Expression> parseExpr(const std::string& source) {
+        auto program = parse("x = " + source + "\n");
+        return std::move(dynamic_cast<Assignment*>(program->statements[0].get())->value);
+    }
+};
+
+TEST_F(FusionTest, FusesComparisonAndSubtraction) {
+    auto less = parseExpr("n < 2");
+    EXPECT_EQ(FuseExpressions(less), 1);
+    ASSERT_EQ(less->kind, ExprKind::VAR_LESS_CONST);
+    EXPECT_EQ(static_cast<VarLessConstExpr&>(*less).name, "n");
+    EXPECT_EQ(static_cast<VarLessConstExpr&>(*less).constant, 2);
+
+    auto sub = parseExpr("n - 1");
+    FuseExpressions(sub);
+    EXPECT_EQ(sub->kind, ExprKind::VAR_SUB_CONST);
+}
+
+TEST_F(FusionTest, FusesCallOnDecrement) {
+    auto expr = parseExpr("fib(n - 1) + fib(n - 2)");
+    EXPECT_EQ(FuseExpressions(expr), 2);
+    auto& sum = static_cast<BinaryExpr&>(*expr);
+    ASSERT_EQ(sum.left->kind, ExprKind::CALL_VAR_SUB_CONST);
+    auto& call = static_cast<CallVarSubConstExpr&>(*sum.right);
+    EXPECT_EQ(call.callee, "fib");
+    EXPECT_EQ(call.name, "n");
+    EXPECT_EQ(call.constant, 2);
+
+    std::vector<std::unique_ptr<Expression>> args;
+    args.push_back(parseExpr("n - 1"));
+    ASSERT_EQ(FuseExpressions(args[0]), 1);
+    std::unique_ptr<Expression> refused = std::make_unique<CallExpr>("f", std::move(args));
+    EXPECT_EQ(FuseExpressions(refused), 1);
+    EXPECT_EQ(refused->kind, ExprKind::CALL_VAR_SUB_CONST);
+}
+
+TEST_F(FusionTest, FusesTernaryOnEquality) {
+    auto expr = parseExpr("if n == 0 then 1 else n * f(n - 1)");
+    EXPECT_EQ(FuseExpressions(expr), 2);
+    ASSERT_EQ(expr->kind, ExprKind::IF_VAR_EQ_CONST);
+    auto& fused = static_cast<IfVarEqConstExpr&>(*expr);
+    EXPECT_EQ(fused.then_expr->kind, ExprKind::NUMBER);
+    EXPECT_EQ(static_cast<BinaryExpr&>(*fused.else_expr).right->kind, ExprKind::CALL_VAR_SUB_CONST);
+}
+
+TEST_F(FusionTest, LeavesOtherShapesAlone) {
+    auto expr = parseExpr("if 0 == n then 2 - n else f(n - 1, 2) < m");
+    EXPECT_EQ(FuseExpressions(expr), 1);
+    auto& ternary = static_cast<TernaryExpr&>(*expr);
+    EXPECT_EQ(ternary.cond->kind, ExprKind::BINARY);
+    EXPECT_EQ(ternary.then_expr->kind, ExprKind::BINARY);
+    EXPECT_EQ(ternary.else_expr->kind, ExprKind::BINARY);
+}
+
+TEST_F(FusionTest, PreservesResults) {
+    const char* source =
+        "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\n"
+        "def sum(n) return if n == 0 then 0 else n + sum(n - 1)\n"
+        "def down(n) return if n == 3 then n - 100 else down(n - 1)\n"
+        "return fib(15) * 1000000 + sum(100) * 100 + down(10)\n";
+    auto program = parse(source);
+    auto expected = Interpreter().Run(*program);
+    EXPECT_EQ(FuseExpressions(*program), 8);
+    EXPECT_EQ(Interpreter().Run(*program), expected);
+}
+
+TEST_F(FusionTest, ClonesFusedNodes) {
+    auto expr = parseExpr("if n == 0 then f(n - 1) else n < 3");
+    FuseExpressions(expr);
+    auto copy = CloneExpression(*expr);
+    EXPECT_EQ(copy->kind, ExprKind::IF_VAR_EQ_CONST);
+    EXPECT_EQ(CountNodes(*copy), CountNodes(*expr));
+    EXPECT_EQ(CountNodes(*copy), 3);
+}
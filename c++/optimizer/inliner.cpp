@@ -0,0 +1,448 @@
+#include "inliner.h"
+#include "constant_folder.h"
+#include <algorithm>
+#include <functional>
+#include "../analysis/dependencies.h"
+
+namespace {
+
+const Expression* bodyExpression(const Statement& body) {
+    if (auto ret = dynamic_cast<const Return*>(&body)) {
+        return ret->value.get();
+    }
+    if (auto assignment = dynamic_cast<const Assignment*>(&body)) {
+        return assignment->value.get();
+    }
+    return nullptr;
+}
+
+void collectCalls(const Expression& expr, std::vector<std::string>& callees) {
+    if (auto binary = dynamic_cast<const BinaryExpr*>(&expr)) {
+        collectCalls(*binary->left, callees);
+        collectCalls(*binary->right, callees);
+    } else if (auto ternary = dynamic_cast<const TernaryExpr*>(&expr)) {
+        collectCalls(*ternary->cond, callees);
+        collectCalls(*ternary->then_expr, callees);
+        collectCalls(*ternary->else_expr, callees);
+    } else if (auto call = dynamic_cast<const CallExpr*>(&expr)) {
+        callees.push_back(call->callee);
+        for (const auto& arg : call->args) {
+            collectCalls(*arg, callees);
+        }
+    } else if (auto fused = dynamic_cast<const CallVarSubConstExpr*>(&expr)) {
+        callees.push_back(fused->callee);
+    } else if (auto fused = dynamic_cast<const IfVarEqConstExpr*>(&expr)) {
+        collectCalls(*fused->then_expr, callees);
+        collectCalls(*fused->else_expr, callees);
+    }
+}
+
+void collectCalls(const Statement& stmt, std::vector<std::string>& callees) {
+    if (auto func = dynamic_cast<const FunctionDef*>(&stmt)) {
+        collectCalls(*func->Body(), callees);
+    } else if (auto expr = bodyExpression(stmt)) {
+        collectCalls(*expr, callees);
+    }
+}
+
+void collectVariables(const Expression& expr, std::unordered_map<std::string, size_t>& uses) {
+    if (auto variable = dynamic_cast<const VariableExpr*>(&expr)) {
+        ++uses[variable->name];
+    } else if (auto binary = dynamic_cast<const BinaryExpr*>(&expr)) {
+        collectVariables(*binary->left, uses);
+        collectVariables(*binary->right, uses);
+    } else if (auto ternary = dynamic_cast<const TernaryExpr*>(&expr)) {
+        collectVariables(*ternary->cond, uses);
+        collectVariables(*ternary->then_expr, uses);
+        collectVariables(*ternary->else_expr, uses);
+    } else if (auto call = dynamic_cast<const CallExpr*>(&expr)) {
+        for (const auto& arg : call->args) {
+            collectVariables(*arg, uses);
+        }
+    } else if (auto fused = dynamic_cast<const VarLessConstExpr*>(&expr)) {
+        ++uses[fused->name];
+    } else if (auto fused = dynamic_cast<const VarSubConstExpr*>(&expr)) {
+        ++uses[fused->name];
+    } else if (auto fused = dynamic_cast<const CallVarSubConstExpr*>(&expr)) {
+        ++uses[fused->name];
+    } else if (auto fused = dynamic_cast<const IfVarEqConstExpr*>(&expr)) {
+        ++uses[fused->name];
+        collectVariables(*fused->then_expr, uses);
+        collectVariables(*fused->else_expr, uses);
+    }
+}
+
+std::unique_ptr<Expression> substitute(
+    const Expression& expr, const std::unordered_map<std::string, const Expression*>& args) {
+    if (auto variable = dynamic_cast<const VariableExpr*>(&expr)) {
+        auto it = args.find(variable->name);
+        if (it != args.end()) {
+            return CloneExpression(*it->second);
+        }
+        return CloneExpression(expr);
+    }
+    if (auto binary = dynamic_cast<const BinaryExpr*>(&expr)) {
+        return std::make_unique<BinaryExpr>(binary->op, substitute(*binary->left, args),
+                                            substitute(*binary->right, args));
+    }
+    if (auto ternary = dynamic_cast<const TernaryExpr*>(&expr)) {
+        return std::make_unique<TernaryExpr>(substitute(*ternary->cond, args),
+                                             substitute(*ternary->then_expr, args),
+                                             substitute(*ternary->else_expr, args));
+    }
+    if (auto call = dynamic_cast<const CallExpr*>(&expr)) {
+        std::vector<std::unique_ptr<Expression>> call_args;
+        call_args.reserve(call->args.size());
+        for (const auto& arg : call->args) {
+            call_args.push_back(substitute(*arg, args));
+        }
+        return std::make_unique<CallExpr>(call->callee, std::move(call_args));
+    }
+    // A fused node whose variable is substituted is expanded back into the
+    // core shape it stands for, with the argument in the variable's place.
+    auto operand = [&](const std::string& name) -> std::unique_ptr<Expression> {
+        auto it = args.find(name);
+        return it == args.end() ? nullptr : CloneExpression(*it->second);
+    };
+    if (auto fused = dynamic_cast<const VarLessConstExpr*>(&expr)) {
+        if (auto arg = operand(fused->name)) {
+            return std::make_unique<BinaryExpr>(OperatorToken::LESS, std::move(arg),
+                                                std::make_unique<NumberExpr>(fused->constant));
+        }
+    } else if (auto fused = dynamic_cast<const VarSubConstExpr*>(&expr)) {
+        if (auto arg = operand(fused->name)) {
+            return std::make_unique<BinaryExpr>(OperatorToken::MINUS, std::move(arg),
+                                                std::make_unique<NumberExpr>(fused->constant));
+        }
+    } else if (auto fused = dynamic_cast<const CallVarSubConstExpr*>(&expr)) {
+        if (auto arg = operand(fused->name)) {
+            std::vector<std::unique_ptr<Expression>> call_args;
+            call_args.push_back(std::make_unique<BinaryExpr>(OperatorToken::MINUS, std::move(arg),
+                                                             std::make_unique<NumberExpr>(fused->constant)));
+            return std::make_unique<CallExpr>(fused->callee, std::move(call_args));
+        }
+    } else if (auto fused = dynamic_cast<const IfVarEqConstExpr*>(&expr)) {
+        if (auto arg = operand(fused->name)) {
+            auto cond = std::make_unique<BinaryExpr>(OperatorToken::EQ_EQ, std::move(arg),
+                                                     std::make_unique<NumberExpr>(fused->constant));
+            return std::make_unique<TernaryExpr>(std::move(cond), substitute(*fused->then_expr, args),
+                                                 substitute(*fused->else_expr, args));
+        }
+        return std::make_unique<IfVarEqConstExpr>(fused->name, fused->constant,
+                                                  substitute(*fused->then_expr, args),
+                                                  substitute(*fused->else_expr, args));
+    }
+    return CloneExpression(expr);
+}
+
+bool isLeaf(const Expression& expr) {
+    return dynamic_cast<const NumberExpr*>(&expr) || dynamic_cast<const VariableExpr*>(&expr);
+}
+
+bool isLocal(const std::string& name, const std::vector<std::string>& locals) {
+    return std::find(locals.begin(), locals.end(), name) != locals.end();
+}
+
+// One step of a callee body in evaluation order: a read of a parameter, or
+// (with a null param) an operation that can raise.
+struct BodyEvent {
+    const std::string* param;
+    bool conditional;  // under a ternary arm
+};
+
+void traceBody(const Expression& expr, const std::vector<std::string>& params, bool conditional,
+               const std::function<bool(const std::string&, size_t)>& resolves,
+               std::vector<BodyEvent>& events) {
+    auto read = [&](const std::string& name) {
+        events.push_back(BodyEvent{isLocal(name, params) ? &name : nullptr, conditional});
+    };
+    auto fallible = [&] { events.push_back(BodyEvent{nullptr, conditional}); };
+    switch (expr.kind) {
+        case ExprKind::NUMBER:
+            break;
+        case ExprKind::VARIABLE:
+            read(static_cast<const VariableExpr&>(expr).name);
+            break;
+        case ExprKind::BINARY: {
+            const auto& binary = static_cast<const BinaryExpr&>(expr);
+            traceBody(*binary.left, params, conditional, resolves, events);
+            traceBody(*binary.right, params, conditional, resolves, events);
+            if (binary.op == OperatorToken::DIVIDE) {
+                fallible();
+            }
+            break;
+        }
+        case ExprKind::TERNARY: {
+            const auto& ternary = static_cast<const TernaryExpr&>(expr);
+            traceBody(*ternary.cond, params, conditional, resolves, events);
+            traceBody(*ternary.then_expr, params, true, resolves, events);
+            traceBody(*ternary.else_expr, params, true, resolves, events);
+            break;
+        }
+        case ExprKind::CALL: {
+            // The callee is resolved before its arguments are evaluated.
+            const auto& call = static_cast<const CallExpr&>(expr);
+            if (!resolves(call.callee, call.args.size())) {
+                fallible();
+            }
+            for (const auto& arg : call.args) {
+                traceBody(*arg, params, conditional, resolves, events);
+            }
+            fallible();
+            break;
+        }
+        case ExprKind::VAR_LESS_CONST:
+            read(static_cast<const VarLessConstExpr&>(expr).name);
+            break;
+        case ExprKind::VAR_SUB_CONST:
+            read(static_cast<const VarSubConstExpr&>(expr).name);
+            break;
+        case ExprKind::CALL_VAR_SUB_CONST: {
+            const auto& fused = static_cast<const CallVarSubConstExpr&>(expr);
+            if (!resolves(fused.callee, 1)) {
+                fallible();
+            }
+            read(fused.name);
+            fallible();
+            break;
+        }
+        case ExprKind::IF_VAR_EQ_CONST: {
+            const auto& fused = static_cast<const IfVarEqConstExpr&>(expr);
+            read(fused.name);
+            traceBody(*fused.then_expr, params, true, resolves, events);
+            traceBody(*fused.else_expr, params, true, resolves, events);
+            break;
+        }
+    }
+}
+
+}  // namespace
+
+Inliner::Inliner(InlineOptions options) : options_(options) {}
+
+InlineReport Inliner::Run(Program& program) {
+    callees_.clear();
+    report_ = InlineReport{};
+    collectCallees(program);
+    analyzeCallGraph();
+
+    // A body may run as soon as its def has executed, so only the defs
+    // before it are sure to exist when it does.
+    for (const auto& [func, position] : calleesFirst(program)) {
+        if (auto root = RootExpression(*func->Body())) {
+            rewriteRoot(*root, func->name, func->params, position);
+        }
+    }
+
+    static const std::vector<std::string> no_locals;
+    for (size_t i = 0; i < program.statements.size(); ++i) {
+        if (auto root = RootExpression(*program.statements[i])) {
+            rewriteRoot(*root, "", no_locals, i);
+        }
+    }
+    return std::move(report_);
+}
+
+void Inliner::rewriteRoot(std::unique_ptr<Expression>& root, const std::string& caller,
+                          const std::vector<std::string>& locals, size_t position) {
+    size_t inlined_before = report_.inlined.size();
+    rewrite(root, caller, locals, position);
+    if (options_.fold_constants && report_.inlined.size() != inlined_before) {
+        FoldConstants(root);
+    }
+}
+
+void Inliner::collectCallees(Program& program) {
+    std::unordered_set<std::string> ambiguous;
+    for (size_t i = 0; i < program.statements.size(); ++i) {
+        auto func = dynamic_cast<FunctionDef*>(program.statements[i].get());
+        if (!func) {
+            continue;
+        }
+        CollectNestedDefs(*func, ambiguous);
+        if (!callees_.emplace(func->name, Callee{func, RootExpression(*func->Body()), i}).second) {
+            ambiguous.insert(func->name);
+        }
+    }
+    for (const auto& name : ambiguous) {
+        callees_.erase(name);
+    }
+}
+
+void Inliner::analyzeCallGraph() {
+    std::unordered_map<std::string, size_t> index;
+    std::unordered_map<std::string, size_t> lowlink;
+    std::unordered_set<std::string> on_stack;
+    std::vector<std::string> stack;
+    size_t next_index = 0;
+    order_.clear();
+
+    std::function<void(const std::string&)> connect = [&](const std::string& name) {
+        index[name] = lowlink[name] = next_index++;
+        stack.push_back(name);
+        on_stack.insert(name);
+
+        std::vector<std::string> calls;
+        collectCalls(*callees_.at(name).def, calls);
+        bool self_call = false;
+        for (const auto& next : calls) {
+            if (!callees_.count(next)) {
+                continue;
+            }
+            self_call = self_call || next == name;
+            if (!index.count(next)) {
+                connect(next);
+                lowlink[name] = std::min(lowlink[name], lowlink[next]);
+            } else if (on_stack.count(next)) {
+                lowlink[name] = std::min(lowlink[name], index[next]);
+            }
+        }
+
+        if (lowlink[name] != index[name]) {
+            return;
+        }
+        auto first = std::find(stack.begin(), stack.end(), name);
+        bool recursive = self_call || stack.end() - first > 1;
+        for (auto it = first; it != stack.end(); ++it) {
+            callees_.at(*it).recursive = recursive;
+            on_stack.erase(*it);
+            order_.push_back(*it);
+        }
+        stack.erase(first, stack.end());
+    };
+
+    std::vector<std::string> names;
+    for (const auto& entry : callees_) {
+        names.push_back(entry.first);
+    }
+    std::sort(names.begin(), names.end(), [&](const std::string& a, const std::string& b) {
+        return callees_.at(a).position < callees_.at(b).position;
+    });
+    for (const auto& name : names) {
+        if (!index.count(name)) {
+            connect(name);
+        }
+    }
+}
+
+std::vector<std::pair<FunctionDef*, size_t>> Inliner::calleesFirst(Program& program) {
+    std::vector<std::pair<FunctionDef*, size_t>> functions;
+    for (const auto& name : order_) {
+        const Callee& callee = callees_.at(name);
+        functions.emplace_back(callee.def, callee.position);
+    }
+    for (size_t i = 0; i < program.statements.size(); ++i) {
+        auto func = dynamic_cast<FunctionDef*>(program.statements[i].get());
+        if (func && !callees_.count(func->name)) {
+            functions.emplace_back(func, i);
+        }
+    }
+    return functions;
+}
+
+void Inliner::rewrite(std::unique_ptr<Expression>& expr, const std::string& caller,
+                      const std::vector<std::string>& locals, size_t position) {
+    if (auto binary = dynamic_cast<BinaryExpr*>(expr.get())) {
+        rewrite(binary->left, caller, locals, position);
+        rewrite(binary->right, caller, locals, position);
+    } else if (auto ternary = dynamic_cast<TernaryExpr*>(expr.get())) {
+        rewrite(ternary->cond, caller, locals, position);
+        rewrite(ternary->then_expr, caller, locals, position);
+        rewrite(ternary->else_expr, caller, locals, position);
+    } else if (auto call = dynamic_cast<CallExpr*>(expr.get())) {
+        for (auto& arg : call->args) {
+            rewrite(arg, caller, locals, position);
+        }
+        tryInline(expr, caller, locals, position);
+    } else if (auto fused = dynamic_cast<IfVarEqConstExpr*>(expr.get())) {
+        rewrite(fused->then_expr, caller, locals, position);
+        rewrite(fused->else_expr, caller, locals, position);
+    }
+}
+
+bool Inliner::tryInline(std::unique_ptr<Expression>& expr, const std::string& caller,
+                        const std::vector<std::string>& locals, size_t position) {
+    auto& call = static_cast<CallExpr&>(*expr);
+    auto it = callees_.find(call.callee);
+    if (it == callees_.end() || call.callee == caller) {
+        return false;
+    }
+    const Callee& callee = it->second;
+    if (callee.recursive || !callee.body || callee.position >= position ||
+        callee.def->params.size() != call.args.size() ||
+        CountNodes(**callee.body) > options_.max_body_nodes) {
+        return false;
+    }
+    const Expression& body = **callee.body;
+
+    const auto& params = callee.def->params;
+    std::unordered_map<std::string, size_t> uses;
+    collectVariables(body, uses);
+    for (const auto& local : locals) {
+        bool is_param = std::find(params.begin(), params.end(), local) != params.end();
+        if (!is_param && uses.count(local)) {
+            return false;
+        }
+    }
+
+    std::unordered_map<std::string, const Expression*> args;
+    for (size_t i = 0; i < params.size(); ++i) {
+        auto use = uses.find(params[i]);
+        if (use != uses.end() && use->second > 1 && !isLeaf(*call.args[i])) {
+            return false;
+        }
+        args[params[i]] = call.args[i].get();
+    }
+    if (!keepsEvaluationOrder(callee, call, locals, position)) {
+        return false;
+    }
+
+    auto inlined = substitute(body, args);
+    report_.inlined.push_back(InlinedCall{caller, call.callee});
+    expr = std::move(inlined);
+    return true;
+}
+
+// The call evaluates every argument, in order, before the body runs. After
+// inlining, each argument is evaluated where the body reads its parameter,
+// so an argument that can raise must be read unconditionally, in argument
+// order, and before anything in the body that can raise itself.
+bool Inliner::keepsEvaluationOrder(const Callee& callee, const CallExpr& call,
+                                   const std::vector<std::string>& locals, size_t position) const {
+    const auto& params = callee.def->params;
+    std::unordered_map<std::string, size_t> fallible;  // param -> rank among fallible arguments
+    for (size_t i = 0; i < params.size(); ++i) {
+        if (MayFail(*call.args[i], locals)) {
+            fallible.emplace(params[i], fallible.size());
+        }
+    }
+    if (fallible.empty()) {
+        return true;
+    }
+
+    auto resolves = [&](const std::string& name, size_t arity) {
+        auto it = callees_.find(name);
+        return it != callees_.end() && it->second.position < position &&
+               it->second.def->params.size() == arity;
+    };
+    std::vector<BodyEvent> events;
+    traceBody(**callee.body, params, false, resolves, events);
+
+    size_t next = 0;
+    bool raised = false;
+    for (const auto& event : events) {
+        if (!event.param) {
+            raised = true;
+            continue;
+        }
+        auto it = fallible.find(*event.param);
+        if (it == fallible.end() || it->second < next) {
+            continue;
+        }
+        if (event.conditional || raised || it->second != next) {
+            return false;
+        }
+        ++next;
+    }
+    return next == fallible.size();
+}
@@ -0,0 +1,71 @@
+#ifndef TOY_LANG_INLINER
+#define TOY_LANG_INLINER
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "../ast/ast.h"
+
+struct InlineOptions {
+    // Largest callee body, in expression nodes, that may be copied into a call site.
+    size_t max_body_nodes = 16;
+    // Fold the substituted body, so literal arguments collapse into constants.
+    bool fold_constants = true;
+};
+
+struct InlinedCall {
+    std::string caller;  // empty for a top-level statement
+    std::string callee;
+};
+
+struct InlineReport {
+    std::vector<InlinedCall> inlined;
+};
+
+// Replaces calls to small non-recursive top-level functions with their bodies.
+//
+// Arguments are substituted for parameters simultaneously, so an argument that
+// mentions one of the callee's parameter names is never rewritten again. A site
+// is skipped when a global read by the callee would be captured by a parameter
+// of the caller, when a non-trivial argument would have to be duplicated, or
+// when an argument that can raise would be dropped, evaluated conditionally or
+// evaluated out of order. A body only inlines functions defined before its own
+// def, since it may run before any later def executes. Fused nodes are
+// understood, so the pass may run before or after FuseExpressions.
+class Inliner {
+public:
+    explicit Inliner(InlineOptions options = {});
+
+    InlineReport Run(Program& program);
+
+private:
+    struct Callee {
+        FunctionDef* def;
+        std::unique_ptr<Expression>* body;
+        size_t position;
+        bool recursive = false;
+    };
+
+    InlineOptions options_;
+    std::unordered_map<std::string, Callee> callees_;
+    std::vector<std::string> order_;
+    InlineReport report_;
+
+    void collectCallees(Program& program);
+    void analyzeCallGraph();
+    std::vector<std::pair<FunctionDef*, size_t>> calleesFirst(Program& program);
+
+    void rewriteRoot(std::unique_ptr<Expression>& root, const std::string& caller,
+                     const std::vector<std::string>& locals, size_t position);
+    void rewrite(std::unique_ptr<Expression>& expr, const std::string& caller,
+                 const std::vector<std::string>& locals, size_t position);
+    bool tryInline(std::unique_ptr<Expression>& expr, const std::string& caller,
+                   const std::vector<std::string>& locals, size_t position);
+    bool keepsEvaluationOrder(const Callee& callee, const CallExpr& call,
+                              const std::vector<std::string>& locals, size_t position) const;
+};
+
+#endif // TOY_LANG_INLINER
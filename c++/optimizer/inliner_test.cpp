@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "inliner.h"
+#include "fusion.h"
+#include "../interpreter/interpreter.h"
+#include "../parser/parser.h"
+
+class InlinerTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Program> parse(const std::string& source) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        return parser.Parse();
+    }
+
+    const Expression* returned(const Program& program) {
+        auto ret = dynamic_cast<Return*>(program.statements.back().get());
+        return ret ? ret->value.get() : nullptr;
+    }
+};
+
+TEST_F(InlinerTest, InlinesSmallFunction) {
+    auto program = parse("def sq(x) return x * x\ndef score(a) return sq(a) + 1\nreturn score(7)\n");
+    auto report = Inliner().Run(*program);
+
+    auto score = dynamic_cast<FunctionDef*>(program->statements[1].get());
+    auto body = dynamic_cast<BinaryExpr*>(dynamic_cast<Return*>(score->Body())->value.get());
+    ASSERT_NE(body, nullptr);
+    auto product = dynamic_cast<BinaryExpr*>(body->left.get());
+    ASSERT_NE(product, nullptr);
+    EXPECT_EQ(product->op, OperatorToken::MULTIPLY);
+    EXPECT_EQ(dynamic_cast<VariableExpr*>(product->left.get())->name, "a");
+
+    ASSERT_EQ(report.inlined.size(), 2);
+    EXPECT_EQ(report.inlined[0].caller, "score");
+    EXPECT_EQ(report.inlined[0].callee, "sq");
+    EXPECT_EQ(report.inlined[1].caller, "");
+    EXPECT_EQ(report.inlined[1].callee, "score");
+    EXPECT_EQ(Interpreter().Run(*program), 50);
+}
+
+TEST_F(InlinerTest, FoldsConstantArguments) {
+    auto program = parse("def sq(x) return x * x\ny = sq(12) - 4\n");
+    Inliner().Run(*program);
+    auto assignment = dynamic_cast<Assignment*>(program->statements[1].get());
+    auto value = dynamic_cast<NumberExpr*>(assignment->value.get());
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(value->value, 140);
+}
+
+TEST_F(InlinerTest, SubstitutesParametersSimultaneously) {
+    auto program = parse("def sub(x, y) return x - y\ndef f(x, y) return sub(y, x)\nreturn f(10, 3)\n");
+    Interpreter before;
+    auto expected = before.Run(*parse("def sub(x, y) return x - y\ndef f(x, y) return sub(y, x)\nreturn f(10, 3)\n"));
+    Inliner(InlineOptions{16, false}).Run(*program);
+    EXPECT_EQ(Interpreter().Run(*program), expected);
+    EXPECT_EQ(expected, -7);
+}
+
+TEST_F(InlinerTest, SkipsRecursiveFunctions) {
+    auto program = parse(
+        "def even(n) return if n == 0 then 1 else odd(n - 1)\n"
+        "def odd(n) return if n == 0 then 0 else even(n - 1)\n"
+        "def fact(n) return if n < 2 then 1 else n * fact(n - 1)\n"
+        "return fact(5) + even(4)\n");
+    auto report = Inliner().Run(*program);
+    EXPECT_TRUE(report.inlined.empty());
+    EXPECT_EQ(Interpreter().Run(*program), 121);
+}
+
+TEST_F(InlinerTest, RespectsBudget) {
+    auto program = parse("def f(x) return x * x + x * 2 + 1\nreturn f(3)\n");
+    InlineOptions options;
+    options.max_body_nodes = 4;
+    EXPECT_TRUE(Inliner(options).Run(*program).inlined.empty());
+    options.max_body_nodes = 16;
+    EXPECT_EQ(Inliner(options).Run(*program).inlined.size(), 1);
+    EXPECT_NE(dynamic_cast<const NumberExpr*>(returned(*program)), nullptr);
+}
+
+TEST_F(InlinerTest, AvoidsCapturingGlobals) {
+    auto program = parse(
+        "scale = 10\n"
+        "def f(x) return x * scale\n"
+        "def g(scale) return f(scale + 1)\n"
+        "return g(2)\n");
+    auto report = Inliner().Run(*program);
+    ASSERT_EQ(report.inlined.size(), 1);
+    EXPECT_EQ(report.inlined[0].callee, "g");
+    EXPECT_EQ(Interpreter().Run(*program), 30);
+}
+
+TEST_F(InlinerTest, DoesNotDuplicateCalls) {
+    auto program = parse(
+        "def sq(x) return x * x\n"
+        "def fact(n) return if n < 2 then 1 else n * fact(n - 1)\n"
+        "return sq(fact(4))\n");
+    EXPECT_TRUE(Inliner().Run(*program).inlined.empty());
+}
+
+TEST_F(InlinerTest, SkipsCallsBeforeDefinition) {
+    auto program = parse("y = f(1)\ndef f(x) return x\n");
+    EXPECT_TRUE(Inliner().Run(*program).inlined.empty());
+}
+
+TEST_F(InlinerTest, SkipsBodyCallsToLaterDefinitions) {
+    const char* source = "def a() return b()\nx = a()\ndef b() return 1\nreturn x\n";
+    auto program = parse(source);
+    for (const auto& inlined : Inliner().Run(*program).inlined) {
+        EXPECT_NE(inlined.callee, "b");
+    }
+    try {
+        Interpreter().Run(*program);
+        FAIL() << "expected b to be undefined when a runs";
+    } catch (const NameError& error) {
+        EXPECT_STREQ(error.what(), "Undefined function: b");
+    }
+}
+
+TEST_F(InlinerTest, KeepsArgumentErrors) {
+    const char* sources[] = {
+        "def k(x) return 1\nreturn k(1 / 0)\n",
+        "def pick(c, x) return if c then x else 0\nreturn pick(0, 1 / 0)\n",
+        "def swap(a, b) return b - a\nreturn swap(1 / 0, missing)\n",
+        "def late(x) return 1 / 0 + x\nreturn late(missing)\n",
+    };
+    for (const char* source : sources) {
+        auto program = parse(source);
+        EXPECT_TRUE(Inliner().Run(*program).inlined.empty()) << source;
+        EXPECT_ANY_THROW(Interpreter().Run(*program)) << source;
+    }
+    auto program = parse("def k(x) return 1\nreturn k(1 / 0)\n");
+    Inliner().Run(*program);
+    EXPECT_THROW(Interpreter().Run(*program), RuntimeError);
+
+    // A fallible argument read first and unconditionally is still inlined.
+    program = parse("def inc(x) return x + 1\nn = 4\nreturn inc(n / 2)\n");
+    EXPECT_EQ(Inliner().Run(*program).inlined.size(), 1);
+    EXPECT_EQ(Interpreter().Run(*program), 3);
+}
+
+TEST_F(InlinerTest, HandlesFusedNodes) {
+    auto program = parse(
+        "def down(n) return if n == 0 then 0 else down(n - 1)\n"
+        "def below(x) return x < 10\n"
+        "def check(a) return below(a + 1) + down(a)\n"
+        "return check(9)\n");
+    ASSERT_GT(FuseExpressions(*program), 0u);
+    auto report = Inliner().Run(*program);
+    for (const auto& inlined : report.inlined) {
+        EXPECT_NE(inlined.callee, "down");
+    }
+    ASSERT_EQ(report.inlined.size(), 2);
+    EXPECT_EQ(report.inlined[0].callee, "below");
+    EXPECT_EQ(report.inlined[1].callee, "check");
+    EXPECT_EQ(Interpreter().Run(*program), 0);
+}
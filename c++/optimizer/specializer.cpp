@@ -0,0 +1,237 @@
+#include "specializer.h"
+#include "constant_folder.h"
+#include <unordered_set>
+#include "../analysis/dependencies.h"
+
+namespace {
+
+using Bindings = std::unordered_map<std::string, const Integer*>;
+
+// Copies `expr` with bound parameters replaced by their literals. Returns
+// null when a fused node reads a bound parameter, as it has no literal form.
+std::unique_ptr<Expression> bindLiterals(const Expression& expr, const Bindings& bound) {
+    switch (expr.kind) {
+        case ExprKind::VARIABLE: {
+            auto it = bound.find(static_cast<const VariableExpr&>(expr).name);
+            if (it != bound.end()) {
+                return std::make_unique<NumberExpr>(*it->second);
+            }
+            return CloneExpression(expr);
+        }
+        case ExprKind::BINARY: {
+            const auto& binary = static_cast<const BinaryExpr&>(expr);
+            auto left = bindLiterals(*binary.left, bound);
+            auto right = left ? bindLiterals(*binary.right, bound) : nullptr;
+            if (!right) {
+                return nullptr;
+            }
+            return std::make_unique<BinaryExpr>(binary.op, std::move(left), std::move(right));
+        }
+        case ExprKind::CALL: {
+            const auto& call = static_cast<const CallExpr&>(expr);
+            std::vector<std::unique_ptr<Expression>> args;
+            args.reserve(call.args.size());
+            for (const auto& arg : call.args) {
+                args.push_back(bindLiterals(*arg, bound));
+                if (!args.back()) {
+                    return nullptr;
+                }
+            }
+            return std::make_unique<CallExpr>(call.callee, std::move(args));
+        }
+        case ExprKind::TERNARY: {
+            const auto& ternary = static_cast<const TernaryExpr&>(expr);
+            auto cond = bindLiterals(*ternary.cond, bound);
+            auto then_expr = cond ? bindLiterals(*ternary.then_expr, bound) : nullptr;
+            auto else_expr = then_expr ? bindLiterals(*ternary.else_expr, bound) : nullptr;
+            if (!else_expr) {
+                return nullptr;
+            }
+            return std::make_unique<TernaryExpr>(std::move(cond), std::move(then_expr), std::move(else_expr));
+        }
+        case ExprKind::VAR_LESS_CONST:
+            return bound.count(static_cast<const VarLessConstExpr&>(expr).name) ? nullptr : CloneExpression(expr);
+        case ExprKind::VAR_SUB_CONST:
+            return bound.count(static_cast<const VarSubConstExpr&>(expr).name) ? nullptr : CloneExpression(expr);
+        case ExprKind::CALL_VAR_SUB_CONST:
+            return bound.count(static_cast<const CallVarSubConstExpr&>(expr).name) ? nullptr : CloneExpression(expr);
+        case ExprKind::IF_VAR_EQ_CONST: {
+            const auto& fused = static_cast<const IfVarEqConstExpr&>(expr);
+            if (bound.count(fused.name)) {
+                return nullptr;
+            }
+            auto then_expr = bindLiterals(*fused.then_expr, bound);
+            auto else_expr = then_expr ? bindLiterals(*fused.else_expr, bound) : nullptr;
+            if (!else_expr) {
+                return nullptr;
+            }
+            return std::make_unique<IfVarEqConstExpr>(fused.name, fused.constant, std::move(then_expr),
+                                                      std::move(else_expr));
+        }
+        case ExprKind::NUMBER:
+            break;
+    }
+    return CloneExpression(expr);
+}
+
+bool distinct(const std::vector<std::string>& params) {
+    std::unordered_set<std::string> seen(params.begin(), params.end());
+    return seen.size() == params.size();
+}
+
+}  // namespace
+
+Specializer::Specializer(SpecializeOptions options) : options_(options) {}
+
+SpecializeReport Specializer::Run(Program& program) {
+    callees_.clear();
+    added_.clear();
+    clone_index_.clear();
+    pending_.clear();
+    report_ = SpecializeReport{};
+    collectCallees(program);
+
+    // A body may run as soon as its def has executed, so it sees that def
+    // and the ones before it, but none after.
+    for (size_t i = 0; i < program.statements.size(); ++i) {
+        auto func = dynamic_cast<FunctionDef*>(program.statements[i].get());
+        if (!func) {
+            if (auto root = RootExpression(*program.statements[i])) {
+                rewrite(*root, "", i);
+            }
+        } else if (auto root = RootExpression(*func->Body())) {
+            rewrite(*root, func->name, i + 1);
+        }
+    }
+    // Breadth first, so one deep chain of clones does not starve the others.
+    for (size_t i = 0; i < pending_.size(); ++i) {
+        FunctionDef* clone = pending_[i].first;
+        rewrite(*RootExpression(*clone->Body()), clone->name, pending_[i].second);
+    }
+
+    std::vector<std::unique_ptr<Statement>> statements;
+    statements.reserve(program.statements.size() + report_.clones.size());
+    for (auto& stmt : program.statements) {
+        auto func = dynamic_cast<FunctionDef*>(stmt.get());
+        statements.push_back(std::move(stmt));
+        auto it = func ? added_.find(func->name) : added_.end();
+        if (it != added_.end()) {
+            for (auto& clone : it->second) {
+                statements.push_back(std::move(clone));
+            }
+            added_.erase(it);
+        }
+    }
+    program.statements = std::move(statements);
+    return std::move(report_);
+}
+
+void Specializer::collectCallees(Program& program) {
+    std::unordered_set<std::string> ambiguous;
+    for (size_t i = 0; i < program.statements.size(); ++i) {
+        auto func = dynamic_cast<FunctionDef*>(program.statements[i].get());
+        if (!func) {
+            continue;
+        }
+        CollectNestedDefs(*func, ambiguous);
+        if (!callees_.emplace(func->name, Callee{func, RootExpression(*func->Body()), i}).second) {
+            ambiguous.insert(func->name);
+        }
+    }
+    for (const auto& name : ambiguous) {
+        callees_.erase(name);
+    }
+}
+
+void Specializer::rewrite(std::unique_ptr<Expression>& expr, const std::string& caller, size_t position) {
+    if (auto binary = dynamic_cast<BinaryExpr*>(expr.get())) {
+        rewrite(binary->left, caller, position);
+        rewrite(binary->right, caller, position);
+    } else if (auto ternary = dynamic_cast<TernaryExpr*>(expr.get())) {
+        rewrite(ternary->cond, caller, position);
+        rewrite(ternary->then_expr, caller, position);
+        rewrite(ternary->else_expr, caller, position);
+    } else if (auto fused = dynamic_cast<IfVarEqConstExpr*>(expr.get())) {
+        rewrite(fused->then_expr, caller, position);
+        rewrite(fused->else_expr, caller, position);
+    } else if (auto call = dynamic_cast<CallExpr*>(expr.get())) {
+        for (auto& arg : call->args) {
+            rewrite(arg, caller, position);
+        }
+        trySpecialize(expr, caller, position);
+    }
+}
+
+void Specializer::trySpecialize(std::unique_ptr<Expression>& expr, const std::string& caller, size_t position) {
+    auto& call = static_cast<CallExpr&>(*expr);
+    auto it = callees_.find(call.callee);
+    if (it == callees_.end()) {
+        return;
+    }
+    const Callee& callee = it->second;
+    bool literal = false;
+    for (const auto& arg : call.args) {
+        literal = literal || arg->kind == ExprKind::NUMBER;
+    }
+    if (!literal || !callee.body || callee.position >= position ||
+        callee.def->params.size() != call.args.size() || !distinct(callee.def->params) ||
+        CountNodes(**callee.body) > options_.max_body_nodes) {
+        return;
+    }
+
+    FunctionDef* clone = cloneFor(call.callee, callee, call);
+    if (!clone) {
+        return;
+    }
+    std::vector<std::unique_ptr<Expression>> args;
+    for (auto& arg : call.args) {
+        if (arg->kind != ExprKind::NUMBER) {
+            args.push_back(std::move(arg));
+        }
+    }
+    report_.specialized.push_back(SpecializedCall{caller, call.callee, clone->name});
+    expr = std::make_unique<CallExpr>(clone->name, std::move(args));
+}
+
+// Clones are named after the callee and the literals, "scale@_,1000"; the
+// '@' keeps them apart from any name a script can spell.
+FunctionDef* Specializer::cloneFor(const std::string& name, const Callee& callee, const CallExpr& call) {
+    std::string clone_name = name + "@";
+    for (size_t i = 0; i < call.args.size(); ++i) {
+        if (i > 0) {
+            clone_name += ',';
+        }
+        const Expression& arg = *call.args[i];
+        clone_name += arg.kind == ExprKind::NUMBER ? static_cast<const NumberExpr&>(arg).value.ToString() : "_";
+    }
+    auto existing = clone_index_.find(clone_name);
+    if (existing != clone_index_.end()) {
+        return existing->second;
+    }
+    if (report_.clones.size() >= options_.max_clones) {
+        return nullptr;
+    }
+
+    Bindings bound;
+    std::vector<std::string> params;
+    for (size_t i = 0; i < call.args.size(); ++i) {
+        if (call.args[i]->kind == ExprKind::NUMBER) {
+            bound.emplace(callee.def->params[i], &static_cast<const NumberExpr&>(*call.args[i]).value);
+        } else {
+            params.push_back(callee.def->params[i]);
+        }
+    }
+    auto body = bindLiterals(**callee.body, bound);
+    if (!body) {
+        return nullptr;
+    }
+    FoldConstants(body);
+
+    auto clone = std::make_unique<FunctionDef>(clone_name, std::move(params), std::make_unique<Return>(std::move(body)));
+    FunctionDef* result = clone.get();
+    clone_index_.emplace(clone_name, result);
+    pending_.emplace_back(result, callee.position + 1);  // defined right after the original
+    report_.clones.push_back(clone_name);
+    added_[name].push_back(std::move(clone));
+    return result;
+}
@@ -0,0 +1,67 @@
+#ifndef TOY_LANG_SPECIALIZER
+#define TOY_LANG_SPECIALIZER
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../ast/ast.h"
+
+struct SpecializeOptions {
+    // Most clones added to one program.
+    size_t max_clones = 64;
+    // Largest callee body, in expression nodes, that may be cloned.
+    size_t max_body_nodes = 256;
+};
+
+struct SpecializedCall {
+    std::string caller;  // empty for a top-level statement
+    std::string callee;
+    std::string clone;
+};
+
+struct SpecializeReport {
+    std::vector<SpecializedCall> specialized;
+    std::vector<std::string> clones;
+};
+
+// Clones top-level functions for the literal arguments of their call sites.
+//
+// A clone drops the parameters bound to literals, has them substituted into
+// its body, which is then folded, and is defined right after the original.
+// The call site calls the clone with the remaining arguments. Sites with the
+// same callee and literals share one clone. Call sites inside clones are
+// specialized in turn, so recursion on a literal argument unrolls until the
+// clone budget runs out.
+//
+// Like the Inliner, only functions defined once at top level are cloned, and
+// a statement or body is rewritten only after the definition it calls.
+class Specializer {
+public:
+    explicit Specializer(SpecializeOptions options = {});
+
+    SpecializeReport Run(Program& program);
+
+private:
+    struct Callee {
+        FunctionDef* def;
+        std::unique_ptr<Expression>* body;
+        size_t position;
+    };
+
+    SpecializeOptions options_;
+    std::unordered_map<std::string, Callee> callees_;
+    std::unordered_map<std::string, std::vector<std::unique_ptr<FunctionDef>>> added_;  // by original
+    std::unordered_map<std::string, FunctionDef*> clone_index_;
+    // Clones in creation order, with the position their bodies see; these are rewritten last.
+    std::vector<std::pair<FunctionDef*, size_t>> pending_;
+    SpecializeReport report_;
+
+    void collectCallees(Program& program);
+    void rewrite(std::unique_ptr<Expression>& expr, const std::string& caller, size_t position);
+    void trySpecialize(std::unique_ptr<Expression>& expr, const std::string& caller, size_t position);
+    FunctionDef* cloneFor(const std::string& name, const Callee& callee, const CallExpr& call);
+};
+
+#endif // TOY_LANG_SPECIALIZER
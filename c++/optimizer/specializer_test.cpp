@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "specializer.h"
+#include "../interpreter/interpreter.h"
+#include "../parser/parser.h"
+
+class SpecializerTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Program> parse(const std::string& source) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        return parser.Parse();
+    }
+
+    const FunctionDef* function(const Program& program, const std::string& name) {
+        for (const auto& stmt : program.statements) {
+            auto func = dynamic_cast<const FunctionDef*>(stmt.get());
+            if (func && func->name == name) {
+                return func;
+            }
+        }
+        return nullptr;
+    }
+
+    const Expression* returned(const FunctionDef& func) {
+        auto ret = dynamic_cast<const Return*>(func.Body());
+        return ret ? ret->value.get() : nullptr;
+    }
+};
+
+TEST_F(SpecializerTest, ClonesForLiteralArguments) {
+    const char* source =
+        "def scale(x, k) return x * k / 1000\n"
+        "def price(q) return scale(q, 1000) + scale(q + 1, 1000)\n"
+        "n = 7\n"
+        "return price(n) + scale(3, 2000)\n";
+    auto program = parse(source);
+    auto report = Specializer().Run(*program);
+
+    ASSERT_EQ(report.clones, (std::vector<std::string>{"scale@_,1000", "scale@3,2000"}));
+    ASSERT_EQ(report.specialized.size(), 3);
+    EXPECT_EQ(report.specialized[0].caller, "price");
+    EXPECT_EQ(report.specialized[0].clone, "scale@_,1000");
+    EXPECT_EQ(report.specialized[1].clone, "scale@_,1000");
+    EXPECT_EQ(report.specialized[2].caller, "");
+
+    // Clones follow the original definition.
+    ASSERT_EQ(program->statements.size(), 6);
+    auto clone = dynamic_cast<const FunctionDef*>(program->statements[1].get());
+    ASSERT_NE(clone, nullptr);
+    EXPECT_EQ(clone->name, "scale@_,1000");
+    EXPECT_EQ(clone->params, (std::vector<std::string>{"x"}));
+    auto constant = dynamic_cast<const NumberExpr*>(returned(*function(*program, "scale@3,2000")));
+    ASSERT_NE(constant, nullptr);
+    EXPECT_EQ(constant->value, 6);
+
+    EXPECT_EQ(Interpreter().Run(*program), Interpreter().Run(*parse(source)));
+}
+
+TEST_F(SpecializerTest, FoldsTernariesOnLiterals) {
+    auto program = parse("def pick(flag, a, b) return if flag then a * 2 else b + 1\nreturn pick(0, 4, 9) + pick(1, 4, 9)\n");
+    auto report = Specializer().Run(*program);
+    ASSERT_EQ(report.clones.size(), 2);
+    EXPECT_EQ(report.clones[0], "pick@0,4,9");
+    auto folded = dynamic_cast<const NumberExpr*>(returned(*function(*program, "pick@0,4,9")));
+    ASSERT_NE(folded, nullptr);
+    EXPECT_EQ(folded->value, 10);
+    EXPECT_EQ(Interpreter().Run(*program), 18);
+
+    auto partial = parse("def pick(flag, a, b) return if flag then a * 2 else b + 1\ndef f(x) return pick(1, x, 0)\nreturn f(5)\n");
+    Specializer().Run(*partial);
+    auto product = dynamic_cast<const BinaryExpr*>(returned(*function(*partial, "pick@1,_,0")));
+    ASSERT_NE(product, nullptr);
+    EXPECT_EQ(product->op, OperatorToken::MULTIPLY);
+    EXPECT_EQ(Interpreter().Run(*partial), 10);
+}
+
+TEST_F(SpecializerTest, UnrollsRecursionWithinBudget) {
+    const char* source =
+        "def pow(x, n) return if n == 0 then 1 else x * pow(x, n - 1)\n"
+        "def cube(y) return pow(y, 3)\n"
+        "y = 5\n"
+        "return cube(y)\n";
+    auto program = parse(source);
+    auto report = Specializer().Run(*program);
+    EXPECT_EQ(report.clones, (std::vector<std::string>{"pow@_,3", "pow@_,2", "pow@_,1", "pow@_,0"}));
+    EXPECT_NE(dynamic_cast<const NumberExpr*>(returned(*function(*program, "pow@_,0"))), nullptr);
+    EXPECT_EQ(Interpreter().Run(*program), 125);
+
+    SpecializeOptions options;
+    options.max_clones = 2;
+    auto capped = parse(source);
+    EXPECT_EQ(Specializer(options).Run(*capped).clones.size(), 2);
+    EXPECT_EQ(Interpreter().Run(*capped), 125);
+}
+
+TEST_F(SpecializerTest, KeepsUnsafeSites) {
+    const char* sources[] = {
+        // Called before its definition.
+        "x = f(1)\ndef f(a) return a\n",
+        // Redefined.
+        "def f(a) return a\nx = f(1)\ndef f(a) return a + 1\ny = f(1)\n",
+        // Arity mismatch.
+        "def f(a) return a\nx = f(1, 2)\n",
+        // No value.
+        "def f(a) def g(b) return b\nx = f(1)\n",
+    };
+    for (const char* source : sources) {
+        auto program = parse(source);
+        auto report = Specializer().Run(*program);
+        EXPECT_TRUE(report.clones.empty()) << source;
+        EXPECT_EQ(program->statements.size(), parse(source)->statements.size()) << source;
+    }
+}
+
+TEST_F(SpecializerTest, KeepsBodyCallsToLaterDefinitions) {
+    auto program = parse("def a() return g(1, 2)\nx = a()\ndef g(p, q) return p + q\nreturn x\n");
+    EXPECT_TRUE(Specializer().Run(*program).specialized.empty());
+    try {
+        Interpreter().Run(*program);
+        FAIL() << "expected g to be undefined when a runs";
+    } catch (const NameError& error) {
+        EXPECT_STREQ(error.what(), "Undefined function: g");
+    }
+}
@@ -0,0 +1,106 @@
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include "../analysis/dependencies.h"
+
+ParallelEvaluator::ParallelEvaluator(size_t threads)
+    : pool_(std::max<size_t>(threads, 1)), interpreters_(pool_.Size()) {}
+
+std::optional<Integer> ParallelEvaluator::Run(const Program& program) {
+    std::vector<DependencyNode> graph = BuildDependencyGraph(program);
+    size_t count = graph.size();
+    std::vector<Integer> values(count);
+    std::vector<std::exception_ptr> errors(count);
+    std::unique_ptr<std::atomic<size_t>[]> waiting(new std::atomic<size_t>[count]);
+    std::atomic<size_t> first_error{count};
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t finished = 0;
+
+    std::function<void(size_t)> schedule;
+    auto execute = [&](size_t id, size_t worker) {
+        // A node past a known error would never run sequentially; its
+        // dependents come later still and are skipped the same way.
+        if (id < first_error.load(std::memory_order_acquire)) {
+            try {
+                Interpreter& interpreter = interpreters_[worker];
+                for (const auto& [name, source] : graph[id].globals) {
+                    if (source == DependencyNode::kUnbound) {
+                        interpreter.SetGlobal(name, std::nullopt);
+                    } else {
+                        interpreter.SetGlobal(name, values[source]);
+                    }
+                }
+                for (const auto& [name, func] : graph[id].functions) {
+                    interpreter.SetFunction(name, func);
+                }
+                values[id] = interpreter.Evaluate(*graph[id].expr);
+            } catch (...) {
+                errors[id] = std::current_exception();
+                size_t current = first_error.load();
+                while (id < current && !first_error.compare_exchange_weak(current, id)) {
+                }
+            }
+        }
+        for (size_t dependent : graph[id].dependents) {
+            if (waiting[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                schedule(dependent);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (++finished == count) {
+            done.notify_one();
+        }
+    };
+    schedule = [&](size_t id) {
+        pool_.Submit([&execute, id](size_t worker) { execute(id, worker); });
+    };
+
+    // Collect the roots before submitting any: once workers start, counters
+    // of later nodes may drop to zero and those get scheduled by the workers.
+    std::vector<size_t> roots;
+    for (size_t id = 0; id < count; ++id) {
+        waiting[id] = std::count_if(graph[id].globals.begin(), graph[id].globals.end(), [](const auto& global) {
+            return global.second != DependencyNode::kUnbound;
+        });
+        if (waiting[id] == 0) {
+            roots.push_back(id);
+        }
+    }
+    for (size_t id : roots) {
+        schedule(id);
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return finished == count; });
+    }
+
+    globals_.clear();
+    size_t stop = first_error.load();
+    for (size_t id = 0; id < stop; ++id) {
+        if (graph[id].name) {
+            globals_[*graph[id].name] = values[id];
+        }
+    }
+    if (stop < count) {
+        std::rethrow_exception(errors[stop]);
+    }
+    if (count != 0 && !graph.back().name) {
+        return values.back();
+    }
+    return std::nullopt;
+}
+
+bool ParallelEvaluator::HasGlobal(const std::string& name) const {
+    return globals_.count(name) != 0;
+}
+
+Integer ParallelEvaluator::GetGlobal(const std::string& name) const {
+    auto it = globals_.find(name);
+    if (it == globals_.end()) {
+        throw NameError("Undefined variable: " + name);
+    }
+    return it->second;
+}
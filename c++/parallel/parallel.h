@@ -0,0 +1,36 @@
+#ifndef TOY_LANG_PARALLEL
+#define TOY_LANG_PARALLEL
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "thread_pool.h"
+#include "../ast/ast.h"
+#include "../error.h"
+#include "../interpreter/interpreter.h"
+
+// Runs the top-level assignments of a Program on a thread pool, starting each
+// one as soon as the assignments it depends on have finished.
+//
+// Observable behaviour matches Interpreter::Run: the same globals are bound
+// and, when statements fail, the error of the earliest failing statement is
+// thrown with only the globals assigned before it bound. Once an error is
+// known, statements after it are no longer started. Each Run starts from
+// empty globals.
+class ParallelEvaluator {
+public:
+    explicit ParallelEvaluator(size_t threads = std::thread::hardware_concurrency());
+
+    std::optional<Integer> Run(const Program& program);
+
+    bool HasGlobal(const std::string& name) const;
+    Integer GetGlobal(const std::string& name) const;
+
+private:
+    ThreadPool pool_;
+    std::vector<Interpreter> interpreters_;  // one per worker
+    std::unordered_map<std::string, Integer> globals_;
+};
+
+#endif // TOY_LANG_PARALLEL
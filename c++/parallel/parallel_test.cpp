@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "parallel.h"
+#include "../parser/parser.h"
+
+class ParallelTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Program> parse(const std::string& source) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        return parser.Parse();
+    }
+};
+
+TEST_F(ParallelTest, MatchesInterpreter) {
+    const char* sources[] = {
+        "x = 1 + 2 * 3\ny = (x - 1) / 2\nz = x * y\n",
+        "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\na = fib(15)\nb = fib(16)\nreturn a + b\n",
+        "x = 1\ny = x + 1\nx = 10\nz = x + y\n",
+        "scale = 10\ndef f(x) return x * scale\nscale = 20\nreturn f(4)\n",
+    };
+    ParallelEvaluator evaluator(4);
+    for (const char* source : sources) {
+        auto program = parse(source);
+        Interpreter interpreter;
+        EXPECT_EQ(evaluator.Run(*program), interpreter.Run(*program)) << source;
+        for (const char* name : {"x", "y", "z", "a", "b"}) {
+            EXPECT_EQ(evaluator.HasGlobal(name), interpreter.HasGlobal(name)) << source << name;
+            if (interpreter.HasGlobal(name)) {
+                EXPECT_EQ(evaluator.GetGlobal(name), interpreter.GetGlobal(name)) << source << name;
+            }
+        }
+    }
+}
+
+TEST_F(ParallelTest, RunsManyIndependentAssignments) {
+    std::string source = "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\n";
+    for (int i = 0; i < 100; ++i) {
+        source += "v" + std::to_string(i) + " = fib(" + std::to_string(i % 12) + ")\n";
+    }
+    ParallelEvaluator evaluator(4);
+    evaluator.Run(*parse(source));
+    EXPECT_EQ(evaluator.GetGlobal("v11"), 89);
+    EXPECT_EQ(evaluator.GetGlobal("v10"), 55);
+}
+
+TEST_F(ParallelTest, ReportsEarliestError) {
+    ParallelEvaluator evaluator(4);
+    EXPECT_THROW(evaluator.Run(*parse("a = 1\nb = 1 / 0\nc = missing\n")), RuntimeError);
+    EXPECT_EQ(evaluator.GetGlobal("a"), 1);
+    EXPECT_FALSE(evaluator.HasGlobal("c"));
+    EXPECT_THROW(evaluator.Run(*parse("a = missing\nb = 1 / 0\n")), NameError);
+    EXPECT_FALSE(evaluator.HasGlobal("a"));
+    EXPECT_THROW(evaluator.Run(*parse("def f(a) return a\nx = 1\ny = f(x, x)\n")), RuntimeError);
+    EXPECT_EQ(evaluator.GetGlobal("x"), 1);
+}
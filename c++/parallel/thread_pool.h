@@ -0,0 +1,36 @@
+#ifndef TOY_LANG_THREAD_POOL
+#define TOY_LANG_THREAD_POOL
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads draining a FIFO of tasks. A task receives the
+// index of the worker running it, so callers can keep per-worker state.
+class ThreadPool {
+public:
+    using Task = std::function<void(size_t worker)>;
+
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Submit(Task task);
+    size_t Size() const;
+
+private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<Task> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+    void work(size_t worker);
+};
+
+#endif // TOY_LANG_THREAD_POOL
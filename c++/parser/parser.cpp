@@ -1,21 +1,76 @@
 #include "parser.h"
 #include "../error.h"
 #include "../tokenizer/tokenizer.h"
+#include <cctype>
 #include <stdexcept>
 #include <sstream>
 #include <variant>
 #include <type_traits>
 #include <utility>
 
-Parser::Parser(std::istream* in) : tokenizer_(in) {
-    Next();
+namespace {
+
+const char* const kBlanks = " \t\n\v\f\r";
+
+// Whether `text` holds no statement yet: nothing but blanks and def headers
+// whose bodies start on a later line.
+bool needsBodyLine(const std::string& text) {
+    size_t pos = 0;
+    while ((pos = text.find_first_not_of(kBlanks, pos)) != std::string::npos) {
+        bool def = text.compare(pos, 3, "def") == 0 &&
+                   (pos + 3 == text.size() || !(std::isalnum(text[pos + 3]) || text[pos + 3] == '_'));
+        if (!def || (pos = text.find(')', pos)) == std::string::npos) {
+            return false;
+        }
+        ++pos;
+    }
+    return true;
+}
+
+std::unique_ptr<Statement> parseDeferredBody(const std::string& source) {
+    std::stringstream ss(source);
+    Parser parser(&ss, ParserOptions{true});
+    auto program = parser.Parse();
+    if (program->statements.size() != 1) {
+        throw SyntaxError("Expected a single statement as function body");
+    }
+    return std::move(program->statements.front());
+}
+
+}  // namespace
+
+Parser::Parser(std::istream* in, ParserOptions options) : options_(options) {
+    Reset(in);
+}
+
+void Parser::Reset(std::istream* in) {
+    pipeline_.reset();
+    tokenizer_.reset();
+    if (options_.pipelined && !options_.lazy_bodies) {
+        pipeline_ = std::make_unique<TokenPipeline>(in);
+        current_token_ = pipeline_->GetToken();
+    } else {
+        tokenizer_.emplace(in);
+        current_token_ = tokenizer_->GetToken();
+    }
 }
 
 void Parser::Next() {
-    if (!tokenizer_.IsEnd()) {
-        tokenizer_.Next();
-        current_token_ = tokenizer_.GetToken();
+    if (atEnd()) {
+        return;
     }
+    if (pipeline_) {
+        pipeline_->Next();
+        current_token_ = pipeline_->GetToken();
+    } else {
+        tokenizer_->Next();
+        current_token_ = tokenizer_->GetToken();
+    }
+}
+
+bool Parser::atEnd() const {
+    return std::holds_alternative<UtilityTokens>(current_token_) &&
+           std::get<UtilityTokens>(current_token_) == UtilityTokens::EOFT;
 }
 
 bool Parser::match(const Token& expected) {
@@ -43,17 +98,32 @@ bool Parser::match(const Token& expected) {
 
 std::unique_ptr<Program> Parser::Parse() {
     auto program = std::make_unique<Program>();
-    while (!tokenizer_.IsEnd()) {
-        if (std::holds_alternative<UtilityTokens>(current_token_) && 
-            std::get<UtilityTokens>(current_token_) == UtilityTokens::NEWLINE) {
-            Next();
-            continue;
-        }
-        program->statements.push_back(parseStatement());
+    while (auto stmt = NextStatement()) {
+        program->statements.push_back(std::move(stmt));
     }
     return program;
 }
 
+std::unique_ptr<Statement> Parser::NextStatement() {
+    while (std::holds_alternative<UtilityTokens>(current_token_) &&
+           std::get<UtilityTokens>(current_token_) == UtilityTokens::NEWLINE) {
+        Next();
+    }
+    if (atEnd()) {
+        return nullptr;
+    }
+    try {
+        return parseStatement();
+    } catch (...) {
+        // Drop a partial expression now rather than on the next parse, so no
+        // node outlives the arena it may have been allocated from.
+        operands_.clear();
+        operators_.clear();
+        frames_.clear();
+        throw;
+    }
+}
+
 std::unique_ptr<Statement> Parser::parseStatement() {
     if (std::holds_alternative<UtilityTokens>(current_token_) && 
         std::get<UtilityTokens>(current_token_) == UtilityTokens::DEF) {
@@ -112,6 +182,26 @@ std::unique_ptr<FunctionDef> Parser::parseFunctionDef() {
         std::get<EmbracingToken>(current_token_) != EmbracingToken::RPAREN) {
         throw SyntaxError("Expected ')' after parameters");
     }
+    if (options_.lazy_bodies) {
+        std::string source;
+        std::string line;
+        while (tokenizer_->ReadLine(&line)) {
+            // As in eager parsing, a body may start on the line after its
+            // header but not after a blank one.
+            if (!source.empty() && line.find_first_not_of(kBlanks) == std::string::npos) {
+                throw SyntaxError("Expected function body");
+            }
+            source += line;
+            if (!needsBodyLine(source)) {
+                break;
+            }
+            source += '\n';
+        }
+        // The scan consumed the line's newline; stand in for it rather than
+        // lexing the next line.
+        current_token_ = UtilityTokens::NEWLINE;
+        return std::make_unique<FunctionDef>(name, std::move(params), std::move(source), parseDeferredBody);
+    }
     Next();
     
     if (std::holds_alternative<UtilityTokens>(current_token_) && 
@@ -138,11 +228,7 @@ std::unique_ptr<Assignment> Parser::parseAssignment() {
     Next();
     
     auto value = parseExpression();
-    
-    if (std::holds_alternative<UtilityTokens>(current_token_) && 
-        std::get<UtilityTokens>(current_token_) == UtilityTokens::NEWLINE) {
-        Next();
-    }
+    endStatement();
     
     return std::make_unique<Assignment>(name, std::move(value));
 }
@@ -155,155 +241,202 @@ std::unique_ptr<Return> Parser::parseReturn() {
     Next();
     
     auto value = parseExpression();
-    
-    if (std::holds_alternative<UtilityTokens>(current_token_) && 
-        std::get<UtilityTokens>(current_token_) == UtilityTokens::NEWLINE) {
-        Next();
-    }
+    endStatement();
     
     return std::make_unique<Return>(std::move(value));
 }
 
-std::unique_ptr<Expression> Parser::parseExpression() {
-    return parseTernaryExpr();
+// With lazy bodies a statement ends with its line, as a deferred body is cut
+// at the end of its line; otherwise `def f(x) return x y = 2` would define f
+// and then run `y = 2` at top level. The eager grammar lets the next
+// statement follow on the same line. Either way a newline stays current: the
+// next statement is not lexed until asked for.
+void Parser::endStatement() {
+    if (options_.lazy_bodies && !match(UtilityTokens::NEWLINE) && !atEnd()) {
+        throw SyntaxError("Expected end of line after statement");
+    }
 }
 
-std::unique_ptr<Expression> Parser::parseTernaryExpr() {
-    if (std::holds_alternative<EmbracingToken>(current_token_) && 
-        std::get<EmbracingToken>(current_token_) == EmbracingToken::IF) {
-        Next();
-        
-        auto cond = parseLogicalExpr();
-        
-        if (!std::holds_alternative<EmbracingToken>(current_token_) || 
-            std::get<EmbracingToken>(current_token_) != EmbracingToken::THEN) {
-            throw SyntaxError("Expected 'then' after condition");
-        }
-        Next();
-        
-        auto then_expr = parseExpression();
-        
-        if (!std::holds_alternative<EmbracingToken>(current_token_) || 
-            std::get<EmbracingToken>(current_token_) != EmbracingToken::ELSE) {
-            throw SyntaxError("Expected 'else' after then expression");
-        }
-        Next();
-        
-        auto else_expr = parseExpression();
-        
-        return std::make_unique<TernaryExpr>(std::move(cond), std::move(then_expr), std::move(else_expr));
+namespace {
+
+// Binding strength of binary operators; 0 for tokens that end an expression.
+int precedence(OperatorToken op) {
+    switch (op) {
+        case OperatorToken::MULTIPLY:
+        case OperatorToken::DIVIDE:
+            return 3;
+        case OperatorToken::PLUS:
+        case OperatorToken::MINUS:
+            return 2;
+        case OperatorToken::EQ_EQ:
+        case OperatorToken::NOT_EQ:
+        case OperatorToken::LESS:
+            return 1;
+        default:
+            return 0;
     }
-    
-    return parseLogicalExpr();
 }
 
-std::unique_ptr<Expression> Parser::parseLogicalExpr() {
-    auto expr = parseAddExpr();
-    
-    while (std::holds_alternative<OperatorToken>(current_token_)) {
-        auto op = std::get<OperatorToken>(current_token_);
-        if (op != OperatorToken::EQ_EQ && op != OperatorToken::NOT_EQ && op != OperatorToken::LESS) {
-            break;
+}  // namespace
+
+// Operator-precedence parsing over explicit stacks, so nesting depth is
+// bounded by memory rather than by the native stack. Parentheses, call
+// arguments and the parts of `if/then/else` each open a frame; all binary
+// operators are left-associative.
+std::unique_ptr<Expression> Parser::parseExpression() {
+    operands_.clear();
+    operators_.clear();
+    frames_.clear();
+    frames_.push_back(ExpressionFrame{ExpressionFrame::Kind::ROOT, 0, 0});
+
+    bool expect_operand = true;
+    while (true) {
+        if (expect_operand) {
+            expect_operand = parseOperand();
+            continue;
         }
-        Next();
-        
-        auto right = parseAddExpr();
-        expr = std::make_unique<BinaryExpr>(op, std::move(expr), std::move(right));
+        auto op = std::get_if<OperatorToken>(&current_token_);
+        int binding = op ? precedence(*op) : 0;
+        if (binding != 0) {
+            size_t base = frames_.back().operators_base;
+            while (operators_.size() > base && precedence(operators_.back()) >= binding) {
+                reduce(operators_.size() - 1);
+            }
+            operators_.push_back(*op);
+            Next();
+            expect_operand = true;
+            continue;
+        }
+        reduce(frames_.back().operators_base);
+        if (frames_.back().kind == ExpressionFrame::Kind::ROOT) {
+            auto expr = std::move(operands_.back());
+            operands_.clear();
+            frames_.clear();
+            return expr;
+        }
+        expect_operand = finishFrame();
     }
-    
-    return expr;
 }
 
-std::unique_ptr<Expression> Parser::parseAddExpr() {
-    auto expr = parseMulExpr();
-    
-    while (std::holds_alternative<OperatorToken>(current_token_)) {
-        auto op = std::get<OperatorToken>(current_token_);
-        if (op != OperatorToken::PLUS && op != OperatorToken::MINUS) {
-            break;
-        }
+// Consumes one primary, or the token opening a nested frame. Returns whether
+// an operand is still expected.
+bool Parser::parseOperand() {
+    if (auto constant = std::get_if<ConstantToken>(&current_token_)) {
+        operands_.push_back(std::make_unique<NumberExpr>(constant->value));
         Next();
-        
-        auto right = parseMulExpr();
-        expr = std::make_unique<BinaryExpr>(op, std::move(expr), std::move(right));
+        return false;
     }
-    
-    return expr;
-}
 
-std::unique_ptr<Expression> Parser::parseMulExpr() {
-    auto expr = parsePrimary();
-    
-    while (std::holds_alternative<OperatorToken>(current_token_)) {
-        auto op = std::get<OperatorToken>(current_token_);
-        if (op != OperatorToken::MULTIPLY && op != OperatorToken::DIVIDE) {
-            break;
+    if (auto symbol = std::get_if<SymbolToken>(&current_token_)) {
+        auto name = std::move(symbol->name);
+        Next();
+        if (!match(EmbracingToken::LPAREN)) {
+            operands_.push_back(std::make_unique<VariableExpr>(std::move(name)));
+            return false;
         }
         Next();
-        
-        auto right = parsePrimary();
-        expr = std::make_unique<BinaryExpr>(op, std::move(expr), std::move(right));
+        if (match(EmbracingToken::RPAREN)) {
+            Next();
+            operands_.push_back(std::make_unique<CallExpr>(std::move(name), std::vector<std::unique_ptr<Expression>>{}));
+            return false;
+        }
+        frames_.push_back(ExpressionFrame{ExpressionFrame::Kind::CALL_ARGS, operands_.size(), operators_.size(),
+                                          operands_.size(), std::move(name)});
+        return true;
     }
-    
-    return expr;
-}
 
-std::unique_ptr<Expression> Parser::parsePrimary() {
-    if (std::holds_alternative<ConstantToken>(current_token_)) {
-        auto value = std::get<ConstantToken>(current_token_).value;
+    if (match(EmbracingToken::LPAREN)) {
         Next();
-        return std::make_unique<NumberExpr>(value);
+        frames_.push_back(ExpressionFrame{ExpressionFrame::Kind::PAREN, operands_.size(), operators_.size()});
+        return true;
     }
-    
-    if (std::holds_alternative<SymbolToken>(current_token_)) {
-        auto name = std::get<SymbolToken>(current_token_).name;
+
+    // A conditional spans a whole expression, so it may only open one, and
+    // a condition is itself a comparison rather than a full expression.
+    const ExpressionFrame& frame = frames_.back();
+    bool at_start = operands_.size() == frame.operands_base && operators_.size() == frame.operators_base;
+    if (match(EmbracingToken::IF) && at_start && frame.kind != ExpressionFrame::Kind::IF_COND) {
         Next();
-        
-        if (std::holds_alternative<EmbracingToken>(current_token_) && 
-            std::get<EmbracingToken>(current_token_) == EmbracingToken::LPAREN) {
+        frames_.push_back(ExpressionFrame{ExpressionFrame::Kind::IF_COND, operands_.size(), operators_.size()});
+        return true;
+    }
+
+    throw SyntaxError("Unexpected token in primary expression");
+}
+
+// Closes the innermost non-root frame once its expression is complete. The
+// frame's value is the single operand above its base. Returns whether an
+// operand is expected next.
+bool Parser::finishFrame() {
+    ExpressionFrame& frame = frames_.back();
+    switch (frame.kind) {
+        case ExpressionFrame::Kind::PAREN:
+            if (!match(EmbracingToken::RPAREN)) {
+                throw SyntaxError("Expected ')' after expression");
+            }
             Next();
-            std::vector<std::unique_ptr<Expression>> args;
-            if (!std::holds_alternative<EmbracingToken>(current_token_) || 
-                std::get<EmbracingToken>(current_token_) != EmbracingToken::RPAREN) {
-                do {
-                    args.push_back(parseExpression());
-                    
-                    if (std::holds_alternative<EmbracingToken>(current_token_) && 
-                        std::get<EmbracingToken>(current_token_) == EmbracingToken::RPAREN) {
-                        break;
-                    }
-                    
-                    if (!std::holds_alternative<EmbracingToken>(current_token_) || 
-                        std::get<EmbracingToken>(current_token_) != EmbracingToken::COMMA) {
-                        throw SyntaxError("Expected ',' or ')' after argument");
-                    }
-                    Next();
-                } while (true);
+            frames_.pop_back();
+            return false;
+        case ExpressionFrame::Kind::CALL_ARGS: {
+            if (match(EmbracingToken::COMMA)) {
+                Next();
+                frame.operands_base = operands_.size();
+                return true;
             }
-            
-            if (!std::holds_alternative<EmbracingToken>(current_token_) || 
-                std::get<EmbracingToken>(current_token_) != EmbracingToken::RPAREN) {
-                throw SyntaxError("Expected ')' after arguments");
+            if (!match(EmbracingToken::RPAREN)) {
+                throw SyntaxError("Expected ',' or ')' after argument");
             }
             Next();
-            
-            return std::make_unique<CallExpr>(name, std::move(args));
+            std::vector<std::unique_ptr<Expression>> args(std::make_move_iterator(operands_.begin() + frame.args_base),
+                                                          std::make_move_iterator(operands_.end()));
+            operands_.resize(frame.args_base);
+            operands_.push_back(std::make_unique<CallExpr>(std::move(frame.callee), std::move(args)));
+            frames_.pop_back();
+            return false;
         }
-        
-        return std::make_unique<VariableExpr>(name);
-    }
-    
-    if (std::holds_alternative<EmbracingToken>(current_token_) && 
-        std::get<EmbracingToken>(current_token_) == EmbracingToken::LPAREN) {
-        Next();
-        auto expr = parseExpression();
-        if (!std::holds_alternative<EmbracingToken>(current_token_) || 
-            std::get<EmbracingToken>(current_token_) != EmbracingToken::RPAREN) {
-            throw SyntaxError("Expected ')' after expression");
+        case ExpressionFrame::Kind::IF_COND:
+            if (!match(EmbracingToken::THEN)) {
+                throw SyntaxError("Expected 'then' after condition");
+            }
+            Next();
+            frame.kind = ExpressionFrame::Kind::IF_THEN;
+            frame.operands_base = operands_.size();
+            return true;
+        case ExpressionFrame::Kind::IF_THEN:
+            if (!match(EmbracingToken::ELSE)) {
+                throw SyntaxError("Expected 'else' after then expression");
+            }
+            Next();
+            frame.kind = ExpressionFrame::Kind::IF_ELSE;
+            frame.operands_base = operands_.size();
+            return true;
+        case ExpressionFrame::Kind::IF_ELSE: {
+            auto else_expr = std::move(operands_.back());
+            operands_.pop_back();
+            auto then_expr = std::move(operands_.back());
+            operands_.pop_back();
+            auto cond = std::move(operands_.back());
+            operands_.pop_back();
+            operands_.push_back(std::make_unique<TernaryExpr>(std::move(cond), std::move(then_expr), std::move(else_expr)));
+            frames_.pop_back();
+            // The else branch took every operator that followed, so the
+            // conditional is the whole expression of the enclosing frame.
+            return false;
         }
-        Next();
-        return expr;
+        case ExpressionFrame::Kind::ROOT:
+            break;
     }
-    
-    throw SyntaxError("Unexpected token in primary expression");
-} 
\ No newline at end of file
+    throw SyntaxError("Unexpected end of expression");
+}
+
+// Folds pending operators above `operators_base` into BinaryExprs, innermost
+// first.
+void Parser::reduce(size_t operators_base) {
+    while (operators_.size() > operators_base) {
+        auto right = std::move(operands_.back());
+        operands_.pop_back();
+        auto left = std::move(operands_.back());
+        operands_.back() = std::make_unique<BinaryExpr>(operators_.back(), std::move(left), std::move(right));
+        operators_.pop_back();
+    }
+}
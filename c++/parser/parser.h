@@ -2,6 +2,7 @@
 #define TOY_LANG_PARSER
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include <variant>
@@ -11,6 +12,7 @@
 #include <type_traits>
 #include <utility>
 #include "../tokenizer/tokenizer.h"
+#include "../tokenizer/token_pipeline.h"
 #include "../ast/ast.h"
 
 class ExprAST;
@@ -148,17 +150,44 @@ public:
     ExprAST* getReturnExpr() const { return return_expr.get(); }
 };
 
+struct ParserOptions {
+    // Keep each function body as source text and parse it on first use, so
+    // loading a library costs a scan per def. A deferred body ends with its
+    // line (or, after a bare def header, with the next one), and its syntax
+    // errors surface when it is first used. Every statement must then end
+    // with its line, where eager parsing lets the next one follow on it.
+    bool lazy_bodies = false;
+    // Tokenize on a separate thread through a TokenPipeline, overlapping
+    // lexing with parsing on large inputs. Ignored with lazy_bodies, whose
+    // scan reads the input directly.
+    bool pipelined = false;
+};
+
 class Parser {
 public:
-    explicit Parser(std::istream* in);
+    explicit Parser(std::istream* in, ParserOptions options = {});
+
+    // Points the parser at new input. The expression stacks keep their
+    // capacity, so a reused parser does not allocate for them again.
+    void Reset(std::istream* in);
 
     std::unique_ptr<Program> Parse();
 
+    // Parses the next top-level statement, or returns null at the end of
+    // input. A statement is returned as soon as the newline ending it is
+    // read, and nothing after that newline is lexed before the next call, so
+    // a caller that handles and drops each one parses any input in constant
+    // memory. A pipelined parser's tokenizer thread still reads ahead.
+    std::unique_ptr<Statement> NextStatement();
+
 private:
-    Tokenizer tokenizer_;
+    ParserOptions options_;
+    std::optional<Tokenizer> tokenizer_;
+    std::unique_ptr<TokenPipeline> pipeline_;
     Token current_token_;
 
     void Next();
+    bool atEnd() const;
 
     bool match(const Token& expected);
 
@@ -193,13 +222,28 @@ private:
     std::unique_ptr<FunctionDef> parseFunctionDef();
     std::unique_ptr<Assignment> parseAssignment();
     std::unique_ptr<Return> parseReturn();
+    void endStatement();
     std::unique_ptr<Expression> parseExpression();
-    std::unique_ptr<Expression> parseTernaryExpr();
-    std::unique_ptr<Expression> parseLogicalExpr();
-    std::unique_ptr<Expression> parseAddExpr();
-    std::unique_ptr<Expression> parseMulExpr();
-    std::unique_ptr<Expression> parsePrimary();
-    std::unique_ptr<Expression> parseFunctionCall();
+    bool parseOperand();
+    bool finishFrame();
+    void reduce(size_t operators_base);
+
+    // One (sub)expression on the explicit expression stack: its operands and
+    // pending operators live above the recorded bases of operands_ and
+    // operators_, and `kind` says what closes it.
+    struct ExpressionFrame {
+        enum class Kind { ROOT, PAREN, CALL_ARGS, IF_COND, IF_THEN, IF_ELSE };
+
+        Kind kind = Kind::ROOT;
+        size_t operands_base = 0;
+        size_t operators_base = 0;
+        size_t args_base = 0;  // CALL_ARGS: first finished argument
+        std::string callee{};
+    };
+
+    std::vector<std::unique_ptr<Expression>> operands_;
+    std::vector<OperatorToken> operators_;
+    std::vector<ExpressionFrame> frames_;
 };
 
 #endif
\ No newline at end of file
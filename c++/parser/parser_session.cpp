@@ -0,0 +1,31 @@
+#include "parser_session.h"
+
+void ParserSession::ViewBuffer::Reset(std::string_view source) {
+    // The get area is only read, never written through.
+    char* begin = const_cast<char*>(source.data());
+    setg(begin, begin, begin + source.size());
+}
+
+ParserSession::ParserSession(ParserOptions options) : in_(&buffer_), parser_(&in_, options) {}
+
+std::unique_ptr<Program> ParserSession::Parse(std::string_view source) {
+    buffer_.Reset(source);
+    in_.clear();
+    parser_.Reset(&in_);
+    return parser_.Parse();
+}
+
+std::vector<ParseResult> ParserSession::ParseBatch(const std::vector<std::string_view>& sources) {
+    std::vector<ParseResult> results(sources.size());
+    auto arena = std::make_shared<NodeArena>();
+    NodeArena::Scope scope(arena.get());
+    for (size_t i = 0; i < sources.size(); ++i) {
+        try {
+            results[i].program = Parse(sources[i]);
+            results[i].program->arena = arena;
+        } catch (const SyntaxError& error) {
+            results[i].error = error;
+        }
+    }
+    return results;
+}
@@ -0,0 +1,50 @@
+#ifndef TOY_LANG_PARSER_SESSION
+#define TOY_LANG_PARSER_SESSION
+
+#include <istream>
+#include <memory>
+#include <optional>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+#include "parser.h"
+
+struct ParseResult {
+    std::unique_ptr<Program> program;  // null when the script has a syntax error
+    std::optional<SyntaxError> error;
+};
+
+// Parses many small scripts through one Parser and one input stream. The
+// stream reads each script in place rather than copying it into a
+// stringstream, and the parser keeps its stack buffers between scripts, so
+// a script costs little beyond its own lexing and parsing. A session is used
+// by one thread at a time.
+class ParserSession {
+public:
+    explicit ParserSession(ParserOptions options = {});
+
+    ParserSession(const ParserSession&) = delete;
+    ParserSession& operator=(const ParserSession&) = delete;
+
+    // Throws SyntaxError like Parser::Parse.
+    std::unique_ptr<Program> Parse(std::string_view source);
+
+    // Parses every script, recording a syntax error in its own result
+    // instead of stopping the batch. The nodes of all scripts share one
+    // NodeArena, freed with the last of the returned programs. Identifiers
+    // stay per node: names are std::strings held by value throughout the
+    // passes and engines, so a shared table would save no copies.
+    std::vector<ParseResult> ParseBatch(const std::vector<std::string_view>& sources);
+
+private:
+    class ViewBuffer : public std::streambuf {
+    public:
+        void Reset(std::string_view source);
+    };
+
+    ViewBuffer buffer_;
+    std::istream in_;
+    Parser parser_;
+};
+
+#endif // TOY_LANG_PARSER_SESSION
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include <sstream>
+#include <thread>
+#include <vector>
 #include "parser.h"
+#include "parser_session.h"
 
 class ParserTest : public ::testing::Test {
 protected:
@@ -85,7 +88,7 @@ TEST_F(ParserTest, ParseFunctionDefinition) {
     ASSERT_EQ(func->params.size(), 2);
     EXPECT_EQ(func->params[0], "x");
     EXPECT_EQ(func->params[1], "y");
-    auto body = dynamic_cast<Assignment*>(func->body.get());
+    auto body = dynamic_cast<Assignment*>(func->Body());
     ASSERT_NE(body, nullptr);
     EXPECT_EQ(body->name, "x");
     auto expr = dynamic_cast<BinaryExpr*>(body->value.get());
@@ -163,12 +166,12 @@ TEST_F(ParserTest, ParseNestedFunction) {
     EXPECT_EQ(outer->name, "outer");
     ASSERT_EQ(outer->params.size(), 1);
     EXPECT_EQ(outer->params[0], "x");
-    auto inner = dynamic_cast<FunctionDef*>(outer->body.get());
+    auto inner = dynamic_cast<FunctionDef*>(outer->Body());
     ASSERT_NE(inner, nullptr);
     EXPECT_EQ(inner->name, "inner");
     ASSERT_EQ(inner->params.size(), 1);
     EXPECT_EQ(inner->params[0], "y");
-    auto body = dynamic_cast<Assignment*>(inner->body.get());
+    auto body = dynamic_cast<Assignment*>(inner->Body());
     ASSERT_NE(body, nullptr);
     EXPECT_EQ(body->name, "x");
     auto expr = dynamic_cast<BinaryExpr*>(body->value.get());
@@ -180,4 +183,325 @@ TEST_F(ParserTest, ParseNestedFunction) {
     auto right = dynamic_cast<VariableExpr*>(expr->right.get());
     ASSERT_NE(right, nullptr);
     EXPECT_EQ(right->name, "y");
-} 
\ No newline at end of file
+}
+
+TEST_F(ParserTest, ParsePrecedenceAndAssociativity) {
+    std::stringstream ss("x = 1 - 2 - 3 * 4 < 5 == 6\n");
+    Parser parser(&ss);
+    auto program = parser.Parse();
+    auto stmt = dynamic_cast<Assignment*>(program->statements[0].get());
+    ASSERT_NE(stmt, nullptr);
+    // ((((1 - 2) - (3 * 4)) < 5) == 6)
+    auto eq = dynamic_cast<BinaryExpr*>(stmt->value.get());
+    ASSERT_NE(eq, nullptr);
+    EXPECT_EQ(eq->op, OperatorToken::EQ_EQ);
+    auto less = dynamic_cast<BinaryExpr*>(eq->left.get());
+    ASSERT_NE(less, nullptr);
+    EXPECT_EQ(less->op, OperatorToken::LESS);
+    auto outer_sub = dynamic_cast<BinaryExpr*>(less->left.get());
+    ASSERT_NE(outer_sub, nullptr);
+    EXPECT_EQ(outer_sub->op, OperatorToken::MINUS);
+    auto inner_sub = dynamic_cast<BinaryExpr*>(outer_sub->left.get());
+    ASSERT_NE(inner_sub, nullptr);
+    EXPECT_EQ(inner_sub->op, OperatorToken::MINUS);
+    auto mul = dynamic_cast<BinaryExpr*>(outer_sub->right.get());
+    ASSERT_NE(mul, nullptr);
+    EXPECT_EQ(mul->op, OperatorToken::MULTIPLY);
+}
+
+TEST_F(ParserTest, ParseNestedCallsAndConditionals) {
+    std::stringstream ss("x = f(g(1, 2) * 3, if a then if b then 1 else 2 else (if c then 3 else 4) + 5)\n");
+    Parser parser(&ss);
+    auto program = parser.Parse();
+    auto stmt = dynamic_cast<Assignment*>(program->statements[0].get());
+    ASSERT_NE(stmt, nullptr);
+    auto call = dynamic_cast<CallExpr*>(stmt->value.get());
+    ASSERT_NE(call, nullptr);
+    ASSERT_EQ(call->args.size(), 2);
+    auto mul = dynamic_cast<BinaryExpr*>(call->args[0].get());
+    ASSERT_NE(mul, nullptr);
+    auto inner = dynamic_cast<CallExpr*>(mul->left.get());
+    ASSERT_NE(inner, nullptr);
+    EXPECT_EQ(inner->args.size(), 2);
+    auto outer_if = dynamic_cast<TernaryExpr*>(call->args[1].get());
+    ASSERT_NE(outer_if, nullptr);
+    EXPECT_NE(dynamic_cast<TernaryExpr*>(outer_if->then_expr.get()), nullptr);
+    auto plus = dynamic_cast<BinaryExpr*>(outer_if->else_expr.get());
+    ASSERT_NE(plus, nullptr);
+    EXPECT_NE(dynamic_cast<TernaryExpr*>(plus->left.get()), nullptr);
+}
+
+TEST_F(ParserTest, RejectsMalformedExpressions) {
+    for (const char* source : {"x = 1 + if a then 1 else 2\n", "x = if if a then 1 else 2 then 3 else 4\n",
+                               "x = (1 + 2\n", "x = f(1 2)\n", "x = if a 1 else 2\n", "x = 1 +\n"}) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        EXPECT_THROW(parser.Parse(), SyntaxError) << source;
+    }
+}
+
+TEST_F(ParserTest, ParseDeepNesting) {
+    const size_t depth = 1000000;
+    std::string parens = "x = " + std::string(depth, '(') + "1" + std::string(depth, ')') + "\n";
+    std::string sums = "x = ";
+    for (size_t i = 0; i < depth; ++i) {
+        sums += "1 + (";
+    }
+    sums += "1" + std::string(depth, ')') + "\n";
+    for (const auto& source : {parens, sums}) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        auto program = parser.Parse();
+        ASSERT_EQ(program->statements.size(), 1);
+    }
+}
+
+TEST_F(ParserTest, DefersFunctionBodies) {
+    std::stringstream ss("def f(a, b) return a +  b\ndef g()\n    x = f(1, 2)\ny = 3\ndef h(a) def k(b)\n  return b\n");
+    Parser parser(&ss, ParserOptions{true});
+    auto program = parser.Parse();
+    ASSERT_EQ(program->statements.size(), 4);
+    auto f = dynamic_cast<FunctionDef*>(program->statements[0].get());
+    auto g = dynamic_cast<FunctionDef*>(program->statements[1].get());
+    auto h = dynamic_cast<FunctionDef*>(program->statements[3].get());
+    ASSERT_NE(f, nullptr);
+    ASSERT_NE(g, nullptr);
+    ASSERT_NE(h, nullptr);
+    EXPECT_NE(dynamic_cast<Assignment*>(program->statements[2].get()), nullptr);
+    EXPECT_EQ(f->params, (std::vector<std::string>{"a", "b"}));
+    EXPECT_FALSE(f->IsBodyParsed());
+    EXPECT_FALSE(g->IsBodyParsed());
+
+    auto ret = dynamic_cast<Return*>(f->Body());
+    ASSERT_NE(ret, nullptr);
+    EXPECT_NE(dynamic_cast<BinaryExpr*>(ret->value.get()), nullptr);
+    EXPECT_TRUE(f->IsBodyParsed());
+    EXPECT_EQ(f->Body(), ret);
+    EXPECT_FALSE(g->IsBodyParsed());
+    EXPECT_NE(dynamic_cast<Assignment*>(g->Body()), nullptr);
+
+    auto k = dynamic_cast<FunctionDef*>(h->Body());
+    ASSERT_NE(k, nullptr);
+    EXPECT_EQ(k->name, "k");
+    EXPECT_NE(dynamic_cast<Return*>(k->Body()), nullptr);
+}
+
+TEST_F(ParserTest, ReportsDeferredSyntaxErrorsOnUse) {
+    std::stringstream ss("def f(a) return a +\ndef g(a) return a b = 1\nx = 1\n");
+    Parser parser(&ss, ParserOptions{true});
+    auto program = parser.Parse();
+    ASSERT_EQ(program->statements.size(), 3);
+    for (size_t i = 0; i < 2; ++i) {
+        auto func = dynamic_cast<FunctionDef*>(program->statements[i].get());
+        ASSERT_NE(func, nullptr);
+        EXPECT_THROW(func->Body(), SyntaxError);
+        EXPECT_THROW(func->Body(), SyntaxError);
+        EXPECT_FALSE(func->IsBodyParsed());
+    }
+}
+
+TEST_F(ParserTest, EndsLazyStatementsWithTheirLine) {
+    // Eager parsing lets statements share a line; lazy parsing, whose
+    // deferred bodies end with their line, does not.
+    std::stringstream eager("x = 1 y = 2\ndef g(a) return a b = 1\n");
+    auto program = Parser(&eager).Parse();
+    ASSERT_EQ(program->statements.size(), 4);
+    EXPECT_NE(dynamic_cast<Assignment*>(program->statements[3].get()), nullptr);
+
+    for (const char* source : {"x = 1 y = 2\n", "return 1 2\n", "x = (1))\n"}) {
+        std::stringstream ss(source);
+        Parser parser(&ss, ParserOptions{true});
+        EXPECT_THROW(parser.Parse(), SyntaxError) << source;
+    }
+    std::stringstream ss("def g(a) return a\ny = 2");
+    EXPECT_EQ(Parser(&ss, ParserOptions{true}).Parse()->statements.size(), 2);
+}
+
+TEST_F(ParserTest, RejectsBlankLineBeforeBody) {
+    for (const char* source : {"def f(x)\n\nreturn x\n", "def f(x)\n  \n  return x\n", "def f(a) def g(b)\n\nreturn b\n"}) {
+        for (bool lazy : {false, true}) {
+            std::stringstream ss(source);
+            Parser parser(&ss, ParserOptions{lazy});
+            EXPECT_THROW(parser.Parse(), SyntaxError) << source << " lazy " << lazy;
+        }
+    }
+    for (bool lazy : {false, true}) {
+        std::stringstream ss("def f(x)  \n  return x\n");
+        Parser parser(&ss, ParserOptions{lazy});
+        auto program = parser.Parse();
+        ASSERT_EQ(program->statements.size(), 1) << "lazy " << lazy;
+        EXPECT_NE(dynamic_cast<Return*>(static_cast<FunctionDef&>(*program->statements[0]).Body()), nullptr);
+    }
+}
+
+TEST_F(ParserTest, ParsesDeferredBodyOnceAcrossThreads) {
+    std::stringstream ss("def f(n) return if n < 2 then n else f(n - 1) + f(n - 2)\n");
+    Parser parser(&ss, ParserOptions{true});
+    auto program = parser.Parse();
+    auto func = dynamic_cast<FunctionDef*>(program->statements[0].get());
+    ASSERT_NE(func, nullptr);
+    std::vector<Statement*> seen(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < seen.size(); ++i) {
+        threads.emplace_back([&, i] { seen[i] = func->Body(); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_NE(seen[0], nullptr);
+    for (auto body : seen) {
+        EXPECT_EQ(body, seen[0]);
+    }
+}
+
+TEST_F(ParserTest, PipelinedParseMatchesDirectParse) {
+    std::string source;
+    for (int i = 0; i < 2000; ++i) {
+        source += "def f" + std::to_string(i) + "(a, b)\n    return if a < b then a * (b - 1) else f(b, a)\n";
+        source += "x" + std::to_string(i) + " = f" + std::to_string(i) + "(1, 2) + 3\n";
+    }
+    source += "return x1999";
+    std::stringstream ss(source);
+    Parser parser(&ss, ParserOptions{false, true});
+    auto program = parser.Parse();
+    ASSERT_EQ(program->statements.size(), 4001);
+    auto func = dynamic_cast<FunctionDef*>(program->statements[3998].get());
+    ASSERT_NE(func, nullptr);
+    EXPECT_EQ(func->name, "f1999");
+    auto ret = dynamic_cast<Return*>(func->Body());
+    ASSERT_NE(ret, nullptr);
+    EXPECT_NE(dynamic_cast<TernaryExpr*>(ret->value.get()), nullptr);
+    EXPECT_NE(dynamic_cast<Return*>(program->statements[4000].get()), nullptr);
+
+    for (const char* bad : {"x = (1 + 2\n", "x = 1 @ 2\n", "!"}) {
+        std::stringstream in(bad);
+        EXPECT_THROW(Parser(&in, ParserOptions{false, true}).Parse(), SyntaxError) << bad;
+    }
+}
+
+TEST_F(ParserTest, SessionParsesScriptsInPlace) {
+    ParserSession session;
+    std::string first = "x = 1 + 2\ny = x * (3 - 4)\n";
+    auto program = session.Parse(first);
+    ASSERT_EQ(program->statements.size(), 2);
+    EXPECT_EQ(dynamic_cast<Assignment*>(program->statements[1].get())->name, "y");
+
+    EXPECT_THROW(session.Parse("x = (1\n"), SyntaxError);
+    EXPECT_THROW(session.Parse("@"), SyntaxError);
+
+    program = session.Parse("def f(a) return a < 10\nreturn f(12345678901234567890)");
+    ASSERT_EQ(program->statements.size(), 2);
+    auto ret = dynamic_cast<Return*>(program->statements[1].get());
+    ASSERT_NE(ret, nullptr);
+    auto call = dynamic_cast<CallExpr*>(ret->value.get());
+    ASSERT_NE(call, nullptr);
+    EXPECT_EQ(dynamic_cast<NumberExpr*>(call->args[0].get())->value.ToString(), "12345678901234567890");
+    EXPECT_TRUE(session.Parse("")->statements.empty());
+}
+
+TEST_F(ParserTest, SessionParsesBatchWithErrors) {
+    std::vector<std::string> scripts;
+    for (int i = 0; i < 100; ++i) {
+        scripts.push_back(i % 10 == 3 ? "x = " + std::to_string(i) + " +\n" : "x = " + std::to_string(i) + "\n");
+    }
+    std::vector<std::string_view> views(scripts.begin(), scripts.end());
+    ParserSession session(ParserOptions{true});
+    auto results = session.ParseBatch(views);
+    ASSERT_EQ(results.size(), 100);
+    for (int i = 0; i < 100; ++i) {
+        if (i % 10 == 3) {
+            EXPECT_EQ(results[i].program, nullptr);
+            EXPECT_TRUE(results[i].error.has_value());
+            continue;
+        }
+        ASSERT_NE(results[i].program, nullptr) << i;
+        EXPECT_FALSE(results[i].error.has_value());
+        auto assignment = dynamic_cast<Assignment*>(results[i].program->statements[0].get());
+        EXPECT_EQ(dynamic_cast<NumberExpr*>(assignment->value.get())->value, i);
+    }
+}
+
+TEST_F(ParserTest, SessionBatchSharesOneArena) {
+    ParserSession session;
+    std::unique_ptr<Program> kept;
+    {
+        auto results = session.ParseBatch({"x = 1 + 2\n", "y = f(3) * 4\n", "z = (1 +\n"});
+        ASSERT_NE(results[0].program->arena, nullptr);
+        EXPECT_EQ(results[0].program->arena, results[1].program->arena);
+        EXPECT_TRUE(results[2].error.has_value());
+        kept = std::move(results[1].program);
+    }
+    // The kept program holds the arena; heap nodes can join its tree.
+    auto& assignment = dynamic_cast<Assignment&>(*kept->statements[0]);
+    assignment.value = std::make_unique<BinaryExpr>(OperatorToken::PLUS, std::move(assignment.value),
+                                                    std::make_unique<NumberExpr>(Integer(1)));
+    EXPECT_EQ(CountNodes(*assignment.value), 6u);
+    EXPECT_EQ(session.Parse("w = 5\n")->arena, nullptr);
+}
+
+TEST_F(ParserTest, StreamsStatementsFromUnboundedInput) {
+    // Yields "x<i> = <i> * 2" lines forever, one line per refill.
+    class EndlessScript : public std::streambuf {
+    protected:
+        int_type underflow() override {
+            line_ = "x" + std::to_string(next_) + " = " + std::to_string(next_) + " * 2\n";
+            ++next_;
+            setg(line_.data(), line_.data(), line_.data() + line_.size());
+            return traits_type::to_int_type(line_[0]);
+        }
+
+    private:
+        std::string line_;
+        size_t next_ = 0;
+    };
+
+    EndlessScript script;
+    std::istream in(&script);
+    Parser parser(&in);
+    for (size_t i = 0; i < 10000; ++i) {
+        auto stmt = parser.NextStatement();
+        auto assignment = dynamic_cast<Assignment*>(stmt.get());
+        ASSERT_NE(assignment, nullptr);
+        EXPECT_EQ(assignment->name, "x" + std::to_string(i));
+    }
+
+    std::stringstream ss("\n\nx = 1\n\ndef f() return 2\n\n");
+    Parser finite(&ss);
+    EXPECT_NE(dynamic_cast<Assignment*>(finite.NextStatement().get()), nullptr);
+    EXPECT_NE(dynamic_cast<FunctionDef*>(finite.NextStatement().get()), nullptr);
+    EXPECT_EQ(finite.NextStatement(), nullptr);
+    EXPECT_EQ(finite.NextStatement(), nullptr);
+}
+
+TEST_F(ParserTest, StopsAtTheNewlineEndingAStatement) {
+    // Serves one line per refill and counts the refills.
+    class LineSource : public std::streambuf {
+    public:
+        explicit LineSource(std::vector<std::string> lines) : lines_(std::move(lines)) {}
+        size_t refills = 0;
+
+    protected:
+        int_type underflow() override {
+            if (refills == lines_.size()) {
+                return traits_type::eof();
+            }
+            std::string& line = lines_[refills++];
+            setg(line.data(), line.data(), line.data() + line.size());
+            return traits_type::to_int_type(line[0]);
+        }
+
+    private:
+        std::vector<std::string> lines_;
+    };
+
+    for (bool lazy : {false, true}) {
+        LineSource source({"x = 1\n", "def f(a) return a\n", "return f(x)\n"});
+        std::istream in(&source);
+        Parser parser(&in, ParserOptions{lazy});
+        for (size_t i = 1; i <= 3; ++i) {
+            ASSERT_NE(parser.NextStatement(), nullptr);
+            EXPECT_EQ(source.refills, i) << "lazy " << lazy;
+        }
+        EXPECT_EQ(parser.NextStatement(), nullptr);
+    }
+}
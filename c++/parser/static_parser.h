@@ -0,0 +1,498 @@
+#ifndef TOY_LANG_STATIC_PARSER
+#define TOY_LANG_STATIC_PARSER
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../ast/ast.h"
+#include "../error.h"
+
+// Compile-time front end for scripts embedded as string literals.
+//
+//     constexpr auto kScript = ParseStatic("def sq(x) return x * x\n");
+//
+// accepts the same grammar as an eager Parser, where statements may share a
+// line (lazy_bodies forbids that), but tokenizes and parses in a constant
+// expression into fixed-capacity arrays, so a syntax error in the literal is a
+// compile error pointing at the SyntaxError it would throw. The same call
+// outside a constant expression throws at runtime. Literals are limited to
+// int64_t; ToProgram turns the result into an ordinary Program.
+
+enum class StaticNodeKind {
+    NUMBER,
+    VARIABLE,
+    BINARY,
+    CALL,
+    TERNARY
+};
+
+struct StaticNode {
+    StaticNodeKind kind = StaticNodeKind::NUMBER;
+    OperatorToken op = OperatorToken::PLUS;
+    int64_t value = 0;
+    std::string_view name{};
+    // BINARY: left, right. TERNARY: cond, then, else.
+    // CALL: first index into StaticProgram::args, argument count.
+    std::array<size_t, 3> operands{};
+};
+
+enum class StaticStatementKind {
+    ASSIGNMENT,
+    RETURN,
+    FUNCTION_DEF
+};
+
+struct StaticStatement {
+    StaticStatementKind kind = StaticStatementKind::ASSIGNMENT;
+    std::string_view name{};
+    // Root node for ASSIGNMENT and RETURN, body statement for FUNCTION_DEF.
+    size_t value = 0;
+    size_t first_param = 0;
+    size_t param_count = 0;
+};
+
+template <size_t MaxNodes = 256, size_t MaxStatements = 64, size_t MaxParams = 64>
+struct StaticProgram {
+    std::array<StaticNode, MaxNodes> nodes{};
+    std::array<size_t, MaxNodes> args{};
+    std::array<StaticStatement, MaxStatements> statements{};
+    std::array<std::string_view, MaxParams> params{};
+    std::array<size_t, MaxStatements> top_level{};
+    size_t node_count = 0;
+    size_t arg_count = 0;
+    size_t statement_count = 0;
+    size_t param_count = 0;
+    size_t top_level_count = 0;
+};
+
+namespace static_parser_detail {
+
+constexpr size_t kMaxCallArgs = 16;
+
+enum class TokenKind {
+    SYMBOL,
+    CONSTANT,
+    LPAREN,
+    RPAREN,
+    COMMA,
+    IF,
+    THEN,
+    ELSE,
+    OPERATOR,
+    DEF,
+    RETURN,
+    NEWLINE,
+    END
+};
+
+struct Token {
+    TokenKind kind = TokenKind::END;
+    OperatorToken op = OperatorToken::PLUS;
+    int64_t value = 0;
+    std::string_view text{};
+};
+
+constexpr bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+constexpr bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+constexpr bool isAlpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+template <size_t MaxNodes, size_t MaxStatements, size_t MaxParams>
+class StaticParser {
+public:
+    using Program = StaticProgram<MaxNodes, MaxStatements, MaxParams>;
+
+    constexpr explicit StaticParser(std::string_view source) : source_(source) {
+        next();
+    }
+
+    constexpr Program Parse() {
+        while (token_.kind != TokenKind::END) {
+            if (token_.kind == TokenKind::NEWLINE) {
+                next();
+                continue;
+            }
+            size_t stmt = parseStatement();
+            if (program_.top_level_count == MaxStatements) {
+                throw SyntaxError("Static script exceeds statement capacity");
+            }
+            program_.top_level[program_.top_level_count++] = stmt;
+        }
+        return program_;
+    }
+
+private:
+    std::string_view source_;
+    size_t pos_ = 0;
+    Token token_;
+    Program program_;
+
+    constexpr bool is(TokenKind kind) const {
+        return token_.kind == kind;
+    }
+
+    constexpr bool isOperator(OperatorToken op) const {
+        return token_.kind == TokenKind::OPERATOR && token_.op == op;
+    }
+
+    constexpr void skipNewline() {
+        if (is(TokenKind::NEWLINE)) {
+            next();
+        }
+    }
+
+    constexpr void next() {
+        while (pos_ < source_.size() && isSpace(source_[pos_])) {
+            if (source_[pos_++] == '\n') {
+                token_ = Token{TokenKind::NEWLINE};
+                return;
+            }
+        }
+        if (pos_ == source_.size()) {
+            token_ = Token{TokenKind::END};
+            return;
+        }
+
+        size_t start = pos_;
+        char c = source_[pos_++];
+        if (isDigit(c)) {
+            int64_t value = c - '0';
+            while (pos_ < source_.size() && isDigit(source_[pos_])) {
+                int64_t digit = source_[pos_++] - '0';
+                if (value > (INT64_MAX - digit) / 10) {
+                    throw SyntaxError("Integer literal too large for a static script");
+                }
+                value = value * 10 + digit;
+            }
+            token_ = Token{TokenKind::CONSTANT, OperatorToken::PLUS, value};
+            return;
+        }
+        if (isAlpha(c)) {
+            while (pos_ < source_.size() &&
+                   (isAlpha(source_[pos_]) || isDigit(source_[pos_]) || source_[pos_] == '_')) {
+                ++pos_;
+            }
+            std::string_view name = source_.substr(start, pos_ - start);
+            TokenKind kind = TokenKind::SYMBOL;
+            if (name == "def") {
+                kind = TokenKind::DEF;
+            } else if (name == "return") {
+                kind = TokenKind::RETURN;
+            } else if (name == "if") {
+                kind = TokenKind::IF;
+            } else if (name == "then") {
+                kind = TokenKind::THEN;
+            } else if (name == "else") {
+                kind = TokenKind::ELSE;
+            }
+            token_ = Token{kind, OperatorToken::PLUS, 0, name};
+            return;
+        }
+
+        switch (c) {
+            case '(':
+                token_ = Token{TokenKind::LPAREN};
+                return;
+            case ')':
+                token_ = Token{TokenKind::RPAREN};
+                return;
+            case ',':
+                token_ = Token{TokenKind::COMMA};
+                return;
+            case '+':
+                token_ = Token{TokenKind::OPERATOR, OperatorToken::PLUS};
+                return;
+            case '-':
+                token_ = Token{TokenKind::OPERATOR, OperatorToken::MINUS};
+                return;
+            case '*':
+                token_ = Token{TokenKind::OPERATOR, OperatorToken::MULTIPLY};
+                return;
+            case '/':
+                token_ = Token{TokenKind::OPERATOR, OperatorToken::DIVIDE};
+                return;
+            case '<':
+                token_ = Token{TokenKind::OPERATOR, OperatorToken::LESS};
+                return;
+            case '=':
+                if (pos_ < source_.size() && source_[pos_] == '=') {
+                    ++pos_;
+                    token_ = Token{TokenKind::OPERATOR, OperatorToken::EQ_EQ};
+                } else {
+                    token_ = Token{TokenKind::OPERATOR, OperatorToken::EQ};
+                }
+                return;
+            case '!':
+                if (pos_ < source_.size() && source_[pos_] == '=') {
+                    ++pos_;
+                    token_ = Token{TokenKind::OPERATOR, OperatorToken::NOT_EQ};
+                    return;
+                }
+                throw SyntaxError("Unexpected character after '!'");
+            default:
+                throw SyntaxError("Unexpected character in static script");
+        }
+    }
+
+    constexpr size_t addStatement(const StaticStatement& stmt) {
+        if (program_.statement_count == MaxStatements) {
+            throw SyntaxError("Static script exceeds statement capacity");
+        }
+        program_.statements[program_.statement_count] = stmt;
+        return program_.statement_count++;
+    }
+
+    constexpr size_t addNode(const StaticNode& node) {
+        if (program_.node_count == MaxNodes) {
+            throw SyntaxError("Static script exceeds node capacity");
+        }
+        program_.nodes[program_.node_count] = node;
+        return program_.node_count++;
+    }
+
+    constexpr size_t parseStatement() {
+        if (is(TokenKind::DEF)) {
+            return parseFunctionDef();
+        }
+        if (is(TokenKind::RETURN)) {
+            next();
+            StaticStatement stmt{StaticStatementKind::RETURN};
+            stmt.value = parseExpression();
+            skipNewline();
+            return addStatement(stmt);
+        }
+        if (!is(TokenKind::SYMBOL)) {
+            throw SyntaxError("Expected variable name");
+        }
+        StaticStatement stmt{StaticStatementKind::ASSIGNMENT, token_.text};
+        next();
+        if (!isOperator(OperatorToken::EQ)) {
+            throw SyntaxError("Expected '=' after variable name");
+        }
+        next();
+        stmt.value = parseExpression();
+        skipNewline();
+        return addStatement(stmt);
+    }
+
+    constexpr size_t parseFunctionDef() {
+        next();
+        if (!is(TokenKind::SYMBOL)) {
+            throw SyntaxError("Expected function name");
+        }
+        StaticStatement stmt{StaticStatementKind::FUNCTION_DEF, token_.text};
+        next();
+        if (!is(TokenKind::LPAREN)) {
+            throw SyntaxError("Expected '(' after function name");
+        }
+        next();
+        stmt.first_param = program_.param_count;
+        if (!is(TokenKind::RPAREN)) {
+            while (true) {
+                if (!is(TokenKind::SYMBOL)) {
+                    throw SyntaxError("Expected parameter name");
+                }
+                if (program_.param_count == MaxParams) {
+                    throw SyntaxError("Static script exceeds parameter capacity");
+                }
+                program_.params[program_.param_count++] = token_.text;
+                ++stmt.param_count;
+                next();
+                if (is(TokenKind::RPAREN)) {
+                    break;
+                }
+                if (!is(TokenKind::COMMA)) {
+                    throw SyntaxError("Expected ',' or ')' after parameter");
+                }
+                next();
+            }
+        }
+        next();
+        skipNewline();
+        stmt.value = parseStatement();
+        return addStatement(stmt);
+    }
+
+    constexpr size_t parseExpression() {
+        if (!is(TokenKind::IF)) {
+            return parseLogicalExpr();
+        }
+        next();
+        StaticNode node{StaticNodeKind::TERNARY};
+        node.operands[0] = parseLogicalExpr();
+        if (!is(TokenKind::THEN)) {
+            throw SyntaxError("Expected 'then' after condition");
+        }
+        next();
+        node.operands[1] = parseExpression();
+        if (!is(TokenKind::ELSE)) {
+            throw SyntaxError("Expected 'else' after then expression");
+        }
+        next();
+        node.operands[2] = parseExpression();
+        return addNode(node);
+    }
+
+    constexpr size_t parseLogicalExpr() {
+        size_t expr = parseAddExpr();
+        while (isOperator(OperatorToken::EQ_EQ) || isOperator(OperatorToken::NOT_EQ) ||
+               isOperator(OperatorToken::LESS)) {
+            expr = parseBinaryTail(expr, &StaticParser::parseAddExpr);
+        }
+        return expr;
+    }
+
+    constexpr size_t parseAddExpr() {
+        size_t expr = parseMulExpr();
+        while (isOperator(OperatorToken::PLUS) || isOperator(OperatorToken::MINUS)) {
+            expr = parseBinaryTail(expr, &StaticParser::parseMulExpr);
+        }
+        return expr;
+    }
+
+    constexpr size_t parseMulExpr() {
+        size_t expr = parsePrimary();
+        while (isOperator(OperatorToken::MULTIPLY) || isOperator(OperatorToken::DIVIDE)) {
+            expr = parseBinaryTail(expr, &StaticParser::parsePrimary);
+        }
+        return expr;
+    }
+
+    constexpr size_t parseBinaryTail(size_t left, size_t (StaticParser::*operand)()) {
+        StaticNode node{StaticNodeKind::BINARY, token_.op};
+        next();
+        node.operands[0] = left;
+        node.operands[1] = (this->*operand)();
+        return addNode(node);
+    }
+
+    constexpr size_t parsePrimary() {
+        if (is(TokenKind::CONSTANT)) {
+            StaticNode node{StaticNodeKind::NUMBER, OperatorToken::PLUS, token_.value};
+            next();
+            return addNode(node);
+        }
+        if (is(TokenKind::SYMBOL)) {
+            std::string_view name = token_.text;
+            next();
+            if (!is(TokenKind::LPAREN)) {
+                return addNode(StaticNode{StaticNodeKind::VARIABLE, OperatorToken::PLUS, 0, name});
+            }
+            next();
+            size_t args[kMaxCallArgs] = {};
+            size_t count = 0;
+            if (!is(TokenKind::RPAREN)) {
+                while (true) {
+                    if (count == kMaxCallArgs) {
+                        throw SyntaxError("Too many arguments in static script call");
+                    }
+                    args[count++] = parseExpression();
+                    if (is(TokenKind::RPAREN)) {
+                        break;
+                    }
+                    if (!is(TokenKind::COMMA)) {
+                        throw SyntaxError("Expected ',' or ')' after argument");
+                    }
+                    next();
+                }
+            }
+            next();
+            if (program_.arg_count + count > MaxNodes) {
+                throw SyntaxError("Static script exceeds node capacity");
+            }
+            StaticNode node{StaticNodeKind::CALL, OperatorToken::PLUS, 0, name};
+            node.operands[0] = program_.arg_count;
+            node.operands[1] = count;
+            for (size_t i = 0; i < count; ++i) {
+                program_.args[program_.arg_count++] = args[i];
+            }
+            return addNode(node);
+        }
+        if (is(TokenKind::LPAREN)) {
+            next();
+            size_t expr = parseExpression();
+            if (!is(TokenKind::RPAREN)) {
+                throw SyntaxError("Expected ')' after expression");
+            }
+            next();
+            return expr;
+        }
+        throw SyntaxError("Unexpected token in primary expression");
+    }
+};
+
+template <typename StaticProgramT>
+std::unique_ptr<Expression> toExpression(const StaticProgramT& program, size_t index) {
+    const StaticNode& node = program.nodes[index];
+    switch (node.kind) {
+        case StaticNodeKind::NUMBER:
+            return std::make_unique<NumberExpr>(Integer(node.value));
+        case StaticNodeKind::VARIABLE:
+            return std::make_unique<VariableExpr>(std::string(node.name));
+        case StaticNodeKind::BINARY:
+            return std::make_unique<BinaryExpr>(node.op, toExpression(program, node.operands[0]),
+                                                toExpression(program, node.operands[1]));
+        case StaticNodeKind::TERNARY:
+            return std::make_unique<TernaryExpr>(toExpression(program, node.operands[0]),
+                                                 toExpression(program, node.operands[1]),
+                                                 toExpression(program, node.operands[2]));
+        case StaticNodeKind::CALL: {
+            std::vector<std::unique_ptr<Expression>> args;
+            args.reserve(node.operands[1]);
+            for (size_t i = 0; i < node.operands[1]; ++i) {
+                args.push_back(toExpression(program, program.args[node.operands[0] + i]));
+            }
+            return std::make_unique<CallExpr>(std::string(node.name), std::move(args));
+        }
+    }
+    throw RuntimeError("Unknown static node");
+}
+
+template <typename StaticProgramT>
+std::unique_ptr<Statement> toStatement(const StaticProgramT& program, size_t index) {
+    const StaticStatement& stmt = program.statements[index];
+    switch (stmt.kind) {
+        case StaticStatementKind::ASSIGNMENT:
+            return std::make_unique<Assignment>(std::string(stmt.name), toExpression(program, stmt.value));
+        case StaticStatementKind::RETURN:
+            return std::make_unique<Return>(toExpression(program, stmt.value));
+        case StaticStatementKind::FUNCTION_DEF: {
+            std::vector<std::string> params;
+            for (size_t i = 0; i < stmt.param_count; ++i) {
+                params.emplace_back(program.params[stmt.first_param + i]);
+            }
+            return std::make_unique<FunctionDef>(std::string(stmt.name), std::move(params),
+                                                 toStatement(program, stmt.value));
+        }
+    }
+    throw RuntimeError("Unknown static statement");
+}
+
+}  // namespace static_parser_detail
+
+template <size_t MaxNodes = 256, size_t MaxStatements = 64, size_t MaxParams = 64>
+constexpr StaticProgram<MaxNodes, MaxStatements, MaxParams> ParseStatic(std::string_view source) {
+    return static_parser_detail::StaticParser<MaxNodes, MaxStatements, MaxParams>(source).Parse();
+}
+
+template <size_t MaxNodes, size_t MaxStatements, size_t MaxParams>
+std::unique_ptr<Program> ToProgram(const StaticProgram<MaxNodes, MaxStatements, MaxParams>& program) {
+    auto result = std::make_unique<Program>();
+    result->statements.reserve(program.top_level_count);
+    for (size_t i = 0; i < program.top_level_count; ++i) {
+        result->statements.push_back(static_parser_detail::toStatement(program, program.top_level[i]));
+    }
+    return result;
+}
+
+#endif // TOY_LANG_STATIC_PARSER
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "static_parser.h"
+#include "parser.h"
+#include "../interpreter/interpreter.h"
+
+namespace {
+
+constexpr auto kFib = ParseStatic(
+    "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\n"
+    "return fib(15)\n");
+
+static_assert(kFib.top_level_count == 2);
+static_assert(kFib.statements[kFib.top_level[0]].kind == StaticStatementKind::FUNCTION_DEF);
+static_assert(kFib.statements[kFib.top_level[0]].name == "fib");
+static_assert(kFib.statements[kFib.top_level[1]].kind == StaticStatementKind::RETURN);
+
+constexpr auto kArithmetic = ParseStatic<8, 2, 1>("x = 1 + 2 * 3\n");
+static_assert(kArithmetic.node_count == 5);
+static_assert(kArithmetic.nodes[kArithmetic.statements[0].value].op == OperatorToken::PLUS);
+
+// Uncommenting any of these fails to compile with the SyntaxError message:
+// constexpr auto kBad = ParseStatic("x = (1 + 2\n");
+// constexpr auto kTooBig = ParseStatic<2>("x = 1 + 2\n");
+
+}  // namespace
+
+class StaticParserTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Program> parse(const std::string& source) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        return parser.Parse();
+    }
+};
+
+TEST_F(StaticParserTest, MatchesRuntimeParser) {
+    auto program = ToProgram(kFib);
+    ASSERT_EQ(program->statements.size(), 2);
+    auto func = dynamic_cast<FunctionDef*>(program->statements[0].get());
+    ASSERT_NE(func, nullptr);
+    EXPECT_EQ(func->name, "fib");
+    ASSERT_EQ(func->params.size(), 1);
+    EXPECT_EQ(func->params[0], "n");
+    auto ternary = dynamic_cast<TernaryExpr*>(dynamic_cast<Return*>(func->Body())->value.get());
+    ASSERT_NE(ternary, nullptr);
+    EXPECT_EQ(static_cast<BinaryExpr&>(*ternary->cond).op, OperatorToken::LESS);
+    EXPECT_EQ(Interpreter().Run(*program), 610);
+}
+
+TEST_F(StaticParserTest, ParsesAllConstructs) {
+    constexpr const char* source =
+        "k = 7\n"
+        "def add(x, y)\n    x = x + y\n"
+        "def outer(a)\n    def inner(b)\n        b = b\n"
+        "def pick(a, b, c) return if a == b then (a - c) / 2 else if a != c then a < c else f()\n"
+        "return add(k, pick(1, 2, 3)) * 2\n";
+    constexpr auto program = ParseStatic(source);
+    auto converted = ToProgram(program);
+    auto expected = parse(source);
+    ASSERT_EQ(converted->statements.size(), expected->statements.size());
+    auto nested = dynamic_cast<FunctionDef*>(converted->statements[2].get());
+    ASSERT_NE(nested, nullptr);
+    EXPECT_NE(dynamic_cast<FunctionDef*>(nested->Body()), nullptr);
+    EXPECT_EQ(Interpreter().Run(*converted), Interpreter().Run(*expected));
+}
+
+TEST_F(StaticParserTest, AgreesWithEagerParserOnLineBreaks) {
+    constexpr const char* source = "x = 1 y = 2\ndef g(a) return a b = g(y)\nreturn b + x\n";
+    auto converted = ToProgram(ParseStatic(source));
+    auto expected = parse(source);
+    ASSERT_EQ(converted->statements.size(), 5);
+    ASSERT_EQ(expected->statements.size(), 5);
+    EXPECT_EQ(Interpreter().Run(*converted), Interpreter().Run(*expected));
+
+    // Both reject a blank line between a def header and its body.
+    EXPECT_THROW(ParseStatic("def f(x)\n\nreturn x\n"), SyntaxError);
+    EXPECT_THROW(parse("def f(x)\n\nreturn x\n"), SyntaxError);
+}
+
+TEST_F(StaticParserTest, ThrowsAtRuntimeOutsideConstantExpressions) {
+    std::string source = "x = (1 + 2\n";
+    EXPECT_THROW(ParseStatic(source), SyntaxError);
+    EXPECT_THROW(ParseStatic("x = 1 @ 2\n"), SyntaxError);
+    EXPECT_THROW(ParseStatic("x = 99999999999999999999\n"), SyntaxError);
+    EXPECT_THROW((ParseStatic<2>("x = 1 + 2\n")), SyntaxError);
+}
@@ -0,0 +1,104 @@
+#include "reactive.h"
+#include <functional>
+#include <queue>
+
+ReactiveProgram::ReactiveProgram(const Program& program)
+    : graph_(BuildDependencyGraph(program)), nodes_(graph_.size()) {
+    for (size_t id = 0; id < graph_.size(); ++id) {
+        nodes_[id].expr = graph_[id].expr;
+        evaluate(id);
+        if (graph_[id].name) {
+            last_assignment_[*graph_[id].name] = id;
+        } else {
+            result_ = id;
+        }
+    }
+}
+
+Integer ReactiveProgram::GetGlobal(const std::string& name) const {
+    auto it = last_assignment_.find(name);
+    if (it == last_assignment_.end()) {
+        throw NameError("Undefined variable: " + name);
+    }
+    return valueOf(nodes_[it->second]);
+}
+
+std::optional<Integer> ReactiveProgram::Result() const {
+    if (!result_) {
+        return std::nullopt;
+    }
+    return valueOf(nodes_[*result_]);
+}
+
+size_t ReactiveProgram::SetInput(const std::string& name, Integer value) {
+    auto it = last_assignment_.find(name);
+    if (it == last_assignment_.end()) {
+        throw NameError("Undefined variable: " + name);
+    }
+    Node& node = nodes_[it->second];
+    bool changed = node.error || node.value != value;
+    node.expr = nullptr;
+    node.error = nullptr;
+    node.value = std::move(value);
+    return 1 + (changed ? propagate(it->second) : 0);
+}
+
+void ReactiveProgram::evaluate(size_t id) {
+    Node& node = nodes_[id];
+    if (!node.expr) {
+        return;
+    }
+    node.error = nullptr;
+    try {
+        for (const auto& [name, source] : graph_[id].globals) {
+            if (source == DependencyNode::kUnbound) {
+                interpreter_.SetGlobal(name, std::nullopt);
+            } else {
+                interpreter_.SetGlobal(name, valueOf(nodes_[source]));
+            }
+        }
+        for (const auto& [name, func] : graph_[id].functions) {
+            interpreter_.SetFunction(name, func);
+        }
+        node.value = interpreter_.Evaluate(*node.expr);
+    } catch (const std::runtime_error&) {
+        node.error = std::current_exception();
+    }
+}
+
+size_t ReactiveProgram::propagate(size_t changed) {
+    // Dependencies always point backwards, so program order is a topological
+    // order: popping the smallest index evaluates each node after its inputs.
+    std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> pending;
+    ++generation_;
+    auto enqueueDependents = [&](size_t id) {
+        for (size_t dependent : graph_[id].dependents) {
+            if (nodes_[dependent].queued != generation_) {
+                nodes_[dependent].queued = generation_;
+                pending.push(dependent);
+            }
+        }
+    };
+    enqueueDependents(changed);
+    size_t recomputed = 0;
+    while (!pending.empty()) {
+        size_t id = pending.top();
+        pending.pop();
+        Node& node = nodes_[id];
+        Integer old_value = node.value;
+        bool had_error = static_cast<bool>(node.error);
+        evaluate(id);
+        ++recomputed;
+        if (had_error || node.error || node.value != old_value) {
+            enqueueDependents(id);
+        }
+    }
+    return recomputed;
+}
+
+const Integer& ReactiveProgram::valueOf(const Node& node) const {
+    if (node.error) {
+        std::rethrow_exception(node.error);
+    }
+    return node.value;
+}
@@ -0,0 +1,55 @@
+#ifndef TOY_LANG_REACTIVE
+#define TOY_LANG_REACTIVE
+
+#include <exception>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../analysis/dependencies.h"
+#include "../ast/ast.h"
+#include "../error.h"
+#include "../interpreter/interpreter.h"
+
+// Incremental evaluator for the top-level assignments of a Program.
+//
+// Every assignment (and the first top-level return) becomes a node that
+// depends on the assignments its expression reads, directly or through the
+// functions it calls. Values are cached; SetInput replaces one assignment
+// with a constant and recomputes only its transitive dependents, in program
+// order, stopping along paths where a value did not change.
+//
+// An assignment that fails keeps its error, and GetGlobal rethrows it; its
+// dependents fail with the same error. The Program must outlive this object.
+class ReactiveProgram {
+public:
+    explicit ReactiveProgram(const Program& program);
+
+    Integer GetGlobal(const std::string& name) const;
+    std::optional<Integer> Result() const;
+
+    // Pins the last assignment of `name` to `value`. Returns the number of
+    // assignments recomputed, including that one.
+    size_t SetInput(const std::string& name, Integer value);
+
+private:
+    struct Node {
+        const Expression* expr = nullptr;  // null once pinned by SetInput
+        Integer value;
+        std::exception_ptr error;
+        size_t queued = 0;
+    };
+
+    Interpreter interpreter_;
+    std::vector<DependencyNode> graph_;
+    std::vector<Node> nodes_;
+    std::unordered_map<std::string, size_t> last_assignment_;
+    std::optional<size_t> result_;
+    size_t generation_ = 0;
+
+    void evaluate(size_t id);
+    size_t propagate(size_t changed);
+    const Integer& valueOf(const Node& node) const;
+};
+
+#endif // TOY_LANG_REACTIVE
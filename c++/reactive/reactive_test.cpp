@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "reactive.h"
+#include "../parser/parser.h"
+
+class ReactiveTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Program> parse(const std::string& source) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        return parser.Parse();
+    }
+};
+
+TEST_F(ReactiveTest, EvaluatesLikeInterpreter) {
+    auto program = parse("x = 2\nscale = 10\ndef f(a) return a * scale\ny = f(x) + 1\nreturn y - x\n");
+    ReactiveProgram reactive(*program);
+    EXPECT_EQ(reactive.GetGlobal("y"), 21);
+    EXPECT_EQ(reactive.Result(), 19);
+}
+
+TEST_F(ReactiveTest, RecomputesOnlyDependents) {
+    auto program = parse("a = 1\nb = 2\nc = a + 1\nd = b + 1\ne = c * d\n");
+    ReactiveProgram reactive(*program);
+    EXPECT_EQ(reactive.GetGlobal("e"), 6);
+    EXPECT_EQ(reactive.SetInput("a", 4), 3u);
+    EXPECT_EQ(reactive.GetGlobal("c"), 5);
+    EXPECT_EQ(reactive.GetGlobal("d"), 3);
+    EXPECT_EQ(reactive.GetGlobal("e"), 15);
+}
+
+TEST_F(ReactiveTest, StopsWhenValueIsUnchanged) {
+    auto program = parse("a = 1\nb = a < 10\nc = b + 1\nd = c + 1\n");
+    ReactiveProgram reactive(*program);
+    EXPECT_EQ(reactive.SetInput("a", 5), 2u);
+    EXPECT_EQ(reactive.SetInput("a", 5), 1u);
+    EXPECT_EQ(reactive.SetInput("a", 50), 4u);
+    EXPECT_EQ(reactive.GetGlobal("d"), 2);
+}
+
+TEST_F(ReactiveTest, TracksGlobalsReadByFunctions) {
+    auto program = parse(
+        "rate = 3\n"
+        "def g(x) return x * rate\n"
+        "def f(x) return g(x) + 1\n"
+        "y = f(2)\n"
+        "z = 5\n");
+    ReactiveProgram reactive(*program);
+    EXPECT_EQ(reactive.GetGlobal("y"), 7);
+    EXPECT_EQ(reactive.SetInput("rate", 4), 2u);
+    EXPECT_EQ(reactive.GetGlobal("y"), 9);
+}
+
+TEST_F(ReactiveTest, ReadsAssignmentVisibleAtItsPosition) {
+    auto program = parse("x = 1\ny = x + 1\nx = 10\nz = x + 1\n");
+    ReactiveProgram reactive(*program);
+    EXPECT_EQ(reactive.GetGlobal("y"), 2);
+    EXPECT_EQ(reactive.GetGlobal("z"), 11);
+    EXPECT_EQ(reactive.SetInput("x", 20), 2u);
+    EXPECT_EQ(reactive.GetGlobal("y"), 2);
+    EXPECT_EQ(reactive.GetGlobal("z"), 21);
+}
+
+TEST_F(ReactiveTest, PropagatesErrors) {
+    auto program = parse("d = 0\nq = 10 / d\nr = q + 1\ns = later\nlater = 1\n");
+    ReactiveProgram reactive(*program);
+    EXPECT_THROW(reactive.GetGlobal("q"), RuntimeError);
+    EXPECT_THROW(reactive.GetGlobal("r"), RuntimeError);
+    EXPECT_THROW(reactive.GetGlobal("s"), NameError);
+    EXPECT_THROW(reactive.GetGlobal("missing"), NameError);
+    reactive.SetInput("d", 5);
+    EXPECT_EQ(reactive.GetGlobal("r"), 3);
+    EXPECT_THROW(reactive.SetInput("missing", 1), NameError);
+}
@@ -0,0 +1,128 @@
+#include "token_pipeline.h"
+#include <optional>
+#include <utility>
+
+namespace {
+
+// Polls before sleeping; a batch is usually ready within a few yields.
+constexpr int kSpinLimit = 64;
+
+}  // namespace
+
+TokenPipeline::TokenPipeline(std::istream* in, size_t batch_size, size_t capacity)
+    : batch_size_(batch_size == 0 ? 1 : batch_size), ring_(capacity == 0 ? 1 : capacity) {
+    for (auto& batch : ring_) {
+        batch.tokens.reserve(batch_size_);
+    }
+    producer_ = std::thread([this, in] { produce(in); });
+    try {
+        nextBatch();
+        settle();
+    } catch (...) {
+        stop_.store(true, std::memory_order_relaxed);
+        signal();
+        producer_.join();
+        throw;
+    }
+}
+
+TokenPipeline::~TokenPipeline() {
+    stop_.store(true, std::memory_order_relaxed);
+    signal();
+    producer_.join();
+}
+
+bool TokenPipeline::IsEnd() const {
+    return std::holds_alternative<UtilityTokens>(current_) && std::get<UtilityTokens>(current_) == UtilityTokens::EOFT;
+}
+
+void TokenPipeline::Next() {
+    if (IsEnd()) {
+        return;
+    }
+    ++position_;
+    settle();
+}
+
+template <typename Ready>
+void TokenPipeline::await(Ready ready) {
+    for (int spin = 0; spin < kSpinLimit; ++spin) {
+        if (ready()) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    progress_.wait(lock, ready);
+}
+
+// Wakes the other side if it sleeps. Passing through the mutex orders the
+// counter update before its next check of `ready`, so no wakeup is lost.
+void TokenPipeline::signal() {
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    progress_.notify_one();
+}
+
+// Fills batches until the end of input or the first error. A slot is
+// reused only after the consumer has released it.
+void TokenPipeline::produce(std::istream* in) {
+    std::optional<Tokenizer> tokenizer;
+    std::exception_ptr error;
+    try {
+        tokenizer.emplace(in);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    for (size_t index = 0;; ++index) {
+        await([&] {
+            return index - released_.load(std::memory_order_acquire) != ring_.size() ||
+                   stop_.load(std::memory_order_relaxed);
+        });
+        if (stop_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        Batch& batch = ring_[index % ring_.size()];
+        batch.tokens.clear();
+        batch.error = error;
+        bool done = error != nullptr;
+        try {
+            while (!done && batch.tokens.size() < batch_size_) {
+                batch.tokens.push_back(tokenizer->GetToken());
+                if (tokenizer->IsEnd()) {
+                    done = true;
+                } else {
+                    tokenizer->Next();
+                }
+            }
+        } catch (...) {
+            batch.error = std::current_exception();
+            done = true;
+        }
+        published_.store(index + 1, std::memory_order_release);
+        signal();
+        if (done) {
+            return;
+        }
+    }
+}
+
+void TokenPipeline::nextBatch() {
+    size_t index = released_.load(std::memory_order_relaxed);
+    await([&] { return published_.load(std::memory_order_acquire) != index; });
+    batch_ = &ring_[index % ring_.size()];
+    position_ = 0;
+}
+
+// Moves the token at position_ into current_, releasing drained batches
+// and waiting for the next one as needed.
+void TokenPipeline::settle() {
+    while (position_ == batch_->tokens.size()) {
+        if (batch_->error) {
+            std::rethrow_exception(batch_->error);
+        }
+        released_.store(released_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        signal();
+        nextBatch();
+    }
+    current_ = std::move(batch_->tokens[position_]);
+}
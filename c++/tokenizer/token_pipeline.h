@@ -0,0 +1,65 @@
+#ifndef TOY_LANG_TOKEN_PIPELINE
+#define TOY_LANG_TOKEN_PIPELINE
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <istream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "tokenizer.h"
+
+// Runs a Tokenizer on its own thread and hands its tokens over in batches
+// through a bounded single-producer/single-consumer ring, so lexing overlaps
+// with whatever consumes the tokens. The producer waits while `capacity`
+// batches are pending, which bounds memory on any input. Either side that has
+// to wait polls briefly and then sleeps until the other makes progress. An
+// error thrown by the tokenizer is rethrown by Next() when the consumer
+// reaches it. Destruction stops the producer and joins it, so it waits for a
+// read from `in` already in progress to return.
+class TokenPipeline {
+public:
+    explicit TokenPipeline(std::istream* in, size_t batch_size = 512, size_t capacity = 16);
+    ~TokenPipeline();
+
+    TokenPipeline(const TokenPipeline&) = delete;
+    TokenPipeline& operator=(const TokenPipeline&) = delete;
+
+    bool IsEnd() const;
+
+    void Next();
+
+    const Token& GetToken() const { return current_; }
+
+private:
+    struct Batch {
+        std::vector<Token> tokens;
+        std::exception_ptr error;  // thrown after the last token
+    };
+
+    void produce(std::istream* in);
+    void nextBatch();
+    void settle();
+    template <typename Ready>
+    void await(Ready ready);
+    void signal();
+
+    const size_t batch_size_;
+    std::vector<Batch> ring_;
+    // Batches published by the producer and released by the consumer; each
+    // side writes only its own counter.
+    alignas(64) std::atomic<size_t> published_{0};
+    alignas(64) std::atomic<size_t> released_{0};
+    std::atomic<bool> stop_{false};
+    // Taken only to sleep and to wake a sleeper; the counters stay lock-free.
+    std::mutex mutex_;
+    std::condition_variable progress_;
+
+    Batch* batch_ = nullptr;
+    size_t position_ = 0;
+    Token current_;
+    std::thread producer_;
+};
+
+#endif // TOY_LANG_TOKEN_PIPELINE
@@ -7,6 +7,21 @@
 #include <utility>
 #include <stdexcept>
 
+namespace {
+
+Integer parseLiteral(const std::string& digits) {
+    int64_t value = 0;
+    for (char c : digits) {
+        if (__builtin_mul_overflow(value, 10, &value) ||
+            __builtin_add_overflow(value, c - '0', &value)) {
+            return Integer::Parse(digits);
+        }
+    }
+    return Integer(value);
+}
+
+}  // namespace
+
 Tokenizer::Tokenizer(std::istream* in) : in_(in) {
     Next();
 }
@@ -31,14 +46,14 @@ void Tokenizer::Next() {
     }
     
     if (std::isdigit(c)) {
-        int value = c - '0';
+        std::string digits(1, c);
         while (in_->get(c) && std::isdigit(c)) {
-            value = value * 10 + (c - '0');
+            digits += c;
         }
         if (in_->good()) {
             in_->unget();
         }
-        current_token_ = ConstantToken{value};
+        current_token_ = ConstantToken{parseLiteral(digits)};
         return;
     }
     
@@ -120,4 +135,8 @@ void Tokenizer::Next() {
 
 Token Tokenizer::GetToken() {
     return current_token_;
-}
\ No newline at end of file
+}
+
+bool Tokenizer::ReadLine(std::string* line) {
+    return static_cast<bool>(std::getline(*in_, *line));
+}
@@ -8,6 +8,7 @@
 #include <type_traits>
 #include <utility>
 #include "../error.h"
+#include "../integer/integer.h"
 
 struct SymbolToken {
   std::string name;
@@ -15,7 +16,7 @@ struct SymbolToken {
 };
 
 struct ConstantToken {
-  int value;
+  Integer value;
   bool operator==(const ConstantToken& other) const { return value == other.value; }
 };
 
@@ -64,6 +65,11 @@ public:
 
   Token GetToken();
 
+  // Reads the raw text from the end of the current token up to the end of
+  // its line, consuming the newline; false at the end of input. The current
+  // token stays as it is until the next call of Next().
+  bool ReadLine(std::string* line);
+
 private:
   std::istream* in_;
   Token current_token_;
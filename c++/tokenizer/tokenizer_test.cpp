@@ -1,6 +1,10 @@
 #include "tokenizer.h"
+#include "token_pipeline.h"
 #include <gtest/gtest.h>
+#include <chrono>
+#include <ctime>
 #include <sstream>
+#include <thread>
 #include "../error.h"
 
 class TokenizerTest : public ::testing::Test {
@@ -224,4 +228,83 @@ TEST_F(TokenizerTest, ParseErrorCases) {
         std::stringstream ss("\"unterminated");
         EXPECT_THROW(Tokenizer tokenizer(&ss), SyntaxError);
     }
-}
\ No newline at end of file
+}
+
+TEST_F(TokenizerTest, ParseLongNumber) {
+    std::stringstream ss("9223372036854775807 123456789012345678901234567890");
+    Tokenizer tokenizer(&ss);
+
+    auto token = tokenizer.GetToken();
+    ASSERT_TRUE(std::holds_alternative<ConstantToken>(token));
+    EXPECT_TRUE(std::get<ConstantToken>(token).value.IsSmall());
+    EXPECT_EQ(std::get<ConstantToken>(token).value, 9223372036854775807LL);
+
+    tokenizer.Next();
+    token = tokenizer.GetToken();
+    ASSERT_TRUE(std::holds_alternative<ConstantToken>(token));
+    EXPECT_EQ(std::get<ConstantToken>(token).value.ToString(), "123456789012345678901234567890");
+}
+
+TEST_F(TokenizerTest, PipelineMatchesTokenizer) {
+    std::string source;
+    for (int i = 0; i < 500; ++i) {
+        source += "def f" + std::to_string(i) + "(a, b) return if a < b then a * 2 else f(b - 1, a) != 3\n";
+    }
+    std::stringstream direct_in(source);
+    std::stringstream piped_in(source);
+    Tokenizer tokenizer(&direct_in);
+    TokenPipeline pipeline(&piped_in, 7, 2);
+    size_t count = 0;
+    while (!tokenizer.IsEnd()) {
+        ASSERT_FALSE(pipeline.IsEnd());
+        ASSERT_TRUE(tokenizer.GetToken() == pipeline.GetToken()) << "token " << count;
+        tokenizer.Next();
+        pipeline.Next();
+        ++count;
+    }
+    EXPECT_TRUE(pipeline.IsEnd());
+    pipeline.Next();
+    EXPECT_TRUE(pipeline.IsEnd());
+    EXPECT_GT(count, 500u * 7);
+}
+
+TEST_F(TokenizerTest, PipelineRethrowsAtErrorPosition) {
+    {
+        std::stringstream ss("@");
+        EXPECT_THROW(TokenPipeline pipeline(&ss), SyntaxError);
+    }
+    std::stringstream ss("x = 1 + 2 @");
+    TokenPipeline pipeline(&ss, 2, 1);
+    for (int i = 0; i < 4; ++i) {
+        pipeline.Next();
+    }
+    ASSERT_TRUE(std::holds_alternative<ConstantToken>(pipeline.GetToken()));
+    EXPECT_THROW(pipeline.Next(), SyntaxError);
+}
+
+TEST_F(TokenizerTest, PipelineStopsWhenAbandoned) {
+    std::string source;
+    for (int i = 0; i < 10000; ++i) {
+        source += "x = y\n";
+    }
+    std::stringstream ss(source);
+    TokenPipeline pipeline(&ss, 4, 2);
+    pipeline.Next();
+    EXPECT_TRUE(std::holds_alternative<OperatorToken>(pipeline.GetToken()));
+}
+
+TEST_F(TokenizerTest, PipelineSleepsWhileRingIsFull) {
+    std::string source;
+    for (int i = 0; i < 10000; ++i) {
+        source += "x = y\n";
+    }
+    std::stringstream ss(source);
+    TokenPipeline pipeline(&ss, 4, 2);
+    // The producer fills both slots and then has to wait out the stall.
+    std::clock_t start = std::clock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    double cpu_seconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+    EXPECT_LT(cpu_seconds, 0.05);
+    pipeline.Next();
+    EXPECT_TRUE(std::holds_alternative<OperatorToken>(pipeline.GetToken()));
+}
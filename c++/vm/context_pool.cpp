@@ -0,0 +1,26 @@
+#include "context_pool.h"
+
+void ContextPool::Releaser::operator()(ExecutionContext* context) const {
+    std::unique_ptr<ExecutionContext> owned(context);
+    std::lock_guard<std::mutex> lock(pool_->mutex_);
+    pool_->idle_.push_back(std::move(owned));
+}
+
+ContextPool::ContextPool(std::shared_ptr<const CompiledProgram> program) : program_(std::move(program)) {}
+
+ContextPool::Lease ContextPool::Acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            ExecutionContext* context = idle_.back().release();
+            idle_.pop_back();
+            return Lease(context, Releaser(this));
+        }
+    }
+    return Lease(new ExecutionContext(program_), Releaser(this));
+}
+
+size_t ContextPool::Idle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
@@ -0,0 +1,38 @@
+#ifndef TOY_LANG_CONTEXT_POOL
+#define TOY_LANG_CONTEXT_POOL
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "vm.h"
+
+// Recycles the ExecutionContexts of one shared CompiledProgram, so serving a
+// request neither compiles nor allocates globals and stacks once the pool is
+// warm. The lock is held only to move a pointer in or out of the idle list.
+// Leases must not outlive the pool.
+class ContextPool {
+public:
+    class Releaser {
+    public:
+        explicit Releaser(ContextPool* pool = nullptr) : pool_(pool) {}
+        void operator()(ExecutionContext* context) const;
+
+    private:
+        ContextPool* pool_;
+    };
+
+    using Lease = std::unique_ptr<ExecutionContext, Releaser>;
+
+    explicit ContextPool(std::shared_ptr<const CompiledProgram> program);
+
+    Lease Acquire();
+
+    size_t Idle() const;
+
+private:
+    std::shared_ptr<const CompiledProgram> program_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<ExecutionContext>> idle_;
+};
+
+#endif // TOY_LANG_CONTEXT_POOL
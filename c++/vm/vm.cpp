@@ -0,0 +1,598 @@
+#include "vm.h"
+#include <algorithm>
+#include "../analysis/dependencies.h"
+
+namespace {
+
+bool isParam(const std::string& name, const std::vector<std::string>& params) {
+    return std::find(params.begin(), params.end(), name) != params.end();
+}
+
+}  // namespace
+
+class BytecodeCompiler {
+public:
+    BytecodeCompiler(CompiledProgram& program, const NativeRegistry* natives)
+        : program_(program), registry_(natives) {}
+
+    void Compile(const Program& program) {
+        static const std::vector<std::string> no_params;
+        for (const auto& stmt : program.statements) {
+            if (auto func = dynamic_cast<const FunctionDef*>(stmt.get())) {
+                defined_.insert(func->name);
+            }
+        }
+        for (const auto& stmt : program.statements) {
+            if (auto func = dynamic_cast<const FunctionDef*>(stmt.get())) {
+                Function compiled{func->name, func->params.size(), std::nullopt};
+                if (auto ret = dynamic_cast<const Return*>(func->Body())) {
+                    compiled.body = compileEntry(*ret->value, func->params);
+                } else if (auto assignment = dynamic_cast<const Assignment*>(func->Body())) {
+                    compiled.body = compileEntry(*assignment->value, func->params);
+                }
+                auto index = static_cast<uint32_t>(program_.functions_.size());
+                program_.functions_.push_back(std::move(compiled));
+                program_.steps_.push_back(Step{StepKind::DEFINE, functionSlot(func->name), index});
+            } else if (auto assignment = dynamic_cast<const Assignment*>(stmt.get())) {
+                CodeEntry code = compileEntry(*assignment->value, no_params);
+                program_.steps_.push_back(Step{StepKind::ASSIGN, global(assignment->name), 0, code});
+            } else if (auto ret = dynamic_cast<const Return*>(stmt.get())) {
+                program_.steps_.push_back(Step{StepKind::RETURN, 0, 0, compileEntry(*ret->value, no_params)});
+            }
+        }
+    }
+
+private:
+    using OpCode = CompiledProgram::OpCode;
+    using Instruction = CompiledProgram::Instruction;
+    using CodeEntry = CompiledProgram::CodeEntry;
+    using Function = CompiledProgram::Function;
+    using Step = CompiledProgram::Step;
+    using StepKind = CompiledProgram::StepKind;
+
+    CompiledProgram& program_;
+    const NativeRegistry* registry_;
+    std::unordered_set<std::string> defined_;
+    uint32_t stack_depth_ = 0;
+    uint32_t max_stack_depth_ = 0;
+    uint32_t label_ = 0;  // most recent jump target; instructions are not fused across it
+
+    uint32_t global(const std::string& name);
+    uint32_t functionSlot(const std::string& name);
+    uint32_t emit(Instruction instruction);
+    void bindLabel(uint32_t jump);
+    CodeEntry compileEntry(const Expression& expr, const std::vector<std::string>& params);
+    void compile(const Expression& expr, const std::vector<std::string>& params);
+    void compileVariable(const std::string& name, const std::vector<std::string>& params);
+    void compileConstant(const Integer& value);
+    void compileBinary(OperatorToken op);
+    uint32_t compileBranch();
+    bool compileCallee(const std::string& callee, uint32_t argc, bool args_may_fail);
+    void compileCall(const std::string& callee, uint32_t argc);
+};
+
+CompiledProgram::CompiledProgram(const Program& program, const NativeRegistry* natives, size_t max_depth)
+    : max_depth_(max_depth) {
+    BytecodeCompiler(*this, natives).Compile(program);
+}
+
+ExecutionContext::ExecutionContext(std::shared_ptr<const CompiledProgram> program)
+    : program_(std::move(program)),
+      globals_(program_->globals_.size()),
+      bound_(program_->function_slots_.size(), nullptr) {}
+
+std::optional<Integer> ExecutionContext::Run(const ExecutionLimits& limits) {
+    std::fill(globals_.begin(), globals_.end(), std::nullopt);
+    std::fill(bound_.begin(), bound_.end(), nullptr);
+    limits_ = limits;
+    fuel_ = 0;
+    fuel_reserve_ = limits.fuel == 0 ? UINT64_MAX : limits.fuel;
+    fuel_issued_ = 0;
+    for (const auto& step : program_->steps_) {
+        switch (step.kind) {
+            case CompiledProgram::StepKind::DEFINE:
+                bound_[step.target] = &program_->functions_[step.function];
+                break;
+            case CompiledProgram::StepKind::ASSIGN:
+                globals_[step.target] = execute(step.code);
+                break;
+            case CompiledProgram::StepKind::RETURN:
+                return execute(step.code);
+        }
+    }
+    return std::nullopt;
+}
+
+Integer ExecutionContext::GetGlobal(const std::string& name) const {
+    auto it = program_->global_index_.find(name);
+    if (it == program_->global_index_.end() || !globals_[it->second]) {
+        throw NameError("Undefined variable: " + name);
+    }
+    return *globals_[it->second];
+}
+
+const ExecutionContext::Function& ExecutionContext::resolve(uint32_t slot, uint32_t argc) const {
+    if (!bound_[slot]) {
+        throw NameError("Undefined function: " + program_->function_slots_[slot]);
+    }
+    const Function& func = *bound_[slot];
+    if (func.arity != argc) {
+        throw RuntimeError("Function '" + func.name + "' expects " + std::to_string(func.arity) +
+                           " arguments, got " + std::to_string(argc));
+    }
+    if (!func.body) {
+        throw RuntimeError("Function '" + func.name + "' does not return a value");
+    }
+    return func;
+}
+
+void ExecutionContext::growFrames(size_t depth) {
+    if (depth >= program_->max_depth_) {
+        throw RuntimeError("Maximum recursion depth of " + std::to_string(program_->max_depth_) + " exceeded");
+    }
+    frames_.resize(std::min(std::max<size_t>(64, 2 * frames_.size()), program_->max_depth_));
+}
+
+void ExecutionContext::growStack(size_t needed) {
+    stack_.resize(std::max(needed, 2 * stack_.size()));
+}
+
+void ExecutionContext::refuel() {
+    // Without a deadline an unlimited run only ever refuels once.
+    const int64_t window = limits_.deadline ? kFuelCheckInterval : INT64_MAX / 2;
+    while (fuel_ < 0) {
+        if (fuel_reserve_ == 0) {
+            throw RuntimeError("Fuel budget of " + std::to_string(limits_.fuel) + " exhausted");
+        }
+        if (limits_.deadline && std::chrono::steady_clock::now() >= *limits_.deadline) {
+            throw RuntimeError("Execution deadline exceeded");
+        }
+        auto amount = static_cast<int64_t>(std::min<uint64_t>(fuel_reserve_, window));
+        fuel_reserve_ -= amount;
+        fuel_ += amount;
+        fuel_issued_ += amount;
+    }
+}
+
+uint32_t BytecodeCompiler::global(const std::string& name) {
+    auto it = program_.global_index_.find(name);
+    if (it != program_.global_index_.end()) {
+        return it->second;
+    }
+    auto index = static_cast<uint32_t>(program_.globals_.size());
+    program_.global_index_.emplace(name, index);
+    program_.globals_.push_back(name);
+    return index;
+}
+
+uint32_t BytecodeCompiler::functionSlot(const std::string& name) {
+    auto it = program_.function_index_.find(name);
+    if (it != program_.function_index_.end()) {
+        return it->second;
+    }
+    auto index = static_cast<uint32_t>(program_.function_slots_.size());
+    program_.function_index_.emplace(name, index);
+    program_.function_slots_.push_back(name);
+    return index;
+}
+
+uint32_t BytecodeCompiler::emit(Instruction instruction) {
+    switch (instruction.code) {
+        case OpCode::CONST:
+        case OpCode::SLOT:
+        case OpCode::GLOBAL:
+        case OpCode::THROW:
+            ++stack_depth_;
+            break;
+        case OpCode::ADD:
+        case OpCode::SUBTRACT:
+        case OpCode::MULTIPLY:
+        case OpCode::DIVIDE:
+        case OpCode::EQUAL:
+        case OpCode::NOT_EQUAL:
+        case OpCode::LESS:
+        case OpCode::JUMP_IF_ZERO:
+        case OpCode::JUMP_UNLESS_EQUAL_CONST:
+        case OpCode::JUMP_UNLESS_LESS_CONST:
+            --stack_depth_;
+            break;
+        case OpCode::CALL:
+        case OpCode::CALL_NATIVE:
+            stack_depth_ = stack_depth_ - instruction.argc + 1;
+            break;
+        case OpCode::ADD_CONST:
+        case OpCode::SUBTRACT_CONST:
+        case OpCode::EQUAL_CONST:
+        case OpCode::LESS_CONST:
+        case OpCode::JUMP:
+        case OpCode::RESOLVE:
+        case OpCode::RETURN:
+            break;
+    }
+    max_stack_depth_ = std::max(max_stack_depth_, stack_depth_);
+    program_.code_.push_back(instruction);
+    return static_cast<uint32_t>(program_.code_.size() - 1);
+}
+
+void BytecodeCompiler::bindLabel(uint32_t jump) {
+    label_ = static_cast<uint32_t>(program_.code_.size());
+    program_.code_[jump].operand = label_;
+}
+
+CompiledProgram::CodeEntry BytecodeCompiler::compileEntry(const Expression& expr,
+                                                         const std::vector<std::string>& params) {
+    auto entry = static_cast<uint32_t>(program_.code_.size());
+    stack_depth_ = max_stack_depth_ = 0;
+    compile(expr, params);
+    emit(Instruction{OpCode::RETURN});
+    // A jump to the final return returns itself, sparing a dispatch per call.
+    for (size_t pc = entry; pc < program_.code_.size(); ++pc) {
+        Instruction& instruction = program_.code_[pc];
+        if (instruction.code == OpCode::JUMP && program_.code_[instruction.operand].code == OpCode::RETURN) {
+            instruction = Instruction{OpCode::RETURN};
+        }
+    }
+    return CodeEntry{entry, max_stack_depth_, static_cast<uint32_t>(program_.code_.size()) - entry};
+}
+
+void BytecodeCompiler::compile(const Expression& expr, const std::vector<std::string>& params) {
+    switch (expr.kind) {
+        case ExprKind::NUMBER:
+            compileConstant(static_cast<const NumberExpr&>(expr).value);
+            return;
+        case ExprKind::VARIABLE:
+            compileVariable(static_cast<const VariableExpr&>(expr).name, params);
+            return;
+        case ExprKind::BINARY: {
+            const auto& binary = static_cast<const BinaryExpr&>(expr);
+            compile(*binary.left, params);
+            compile(*binary.right, params);
+            compileBinary(binary.op);
+            return;
+        }
+        case ExprKind::TERNARY: {
+            const auto& ternary = static_cast<const TernaryExpr&>(expr);
+            compile(*ternary.cond, params);
+            uint32_t to_else = compileBranch();
+            compile(*ternary.then_expr, params);
+            uint32_t to_end = emit(Instruction{OpCode::JUMP});
+            --stack_depth_;
+            bindLabel(to_else);
+            compile(*ternary.else_expr, params);
+            bindLabel(to_end);
+            return;
+        }
+        case ExprKind::CALL: {
+            const auto& call = static_cast<const CallExpr&>(expr);
+            auto argc = static_cast<uint32_t>(call.args.size());
+            bool args_may_fail = std::any_of(call.args.begin(), call.args.end(),
+                                             [&](const auto& arg) { return MayFail(*arg, params); });
+            if (!compileCallee(call.callee, argc, args_may_fail)) {
+                return;
+            }
+            for (const auto& arg : call.args) {
+                compile(*arg, params);
+            }
+            compileCall(call.callee, argc);
+            return;
+        }
+        case ExprKind::VAR_LESS_CONST: {
+            const auto& fused = static_cast<const VarLessConstExpr&>(expr);
+            compileVariable(fused.name, params);
+            compileConstant(fused.constant);
+            compileBinary(OperatorToken::LESS);
+            return;
+        }
+        case ExprKind::VAR_SUB_CONST: {
+            const auto& fused = static_cast<const VarSubConstExpr&>(expr);
+            compileVariable(fused.name, params);
+            compileConstant(fused.constant);
+            compileBinary(OperatorToken::MINUS);
+            return;
+        }
+        case ExprKind::CALL_VAR_SUB_CONST: {
+            const auto& fused = static_cast<const CallVarSubConstExpr&>(expr);
+            if (!compileCallee(fused.callee, 1, !isParam(fused.name, params))) {
+                return;
+            }
+            compileVariable(fused.name, params);
+            compileConstant(fused.constant);
+            compileBinary(OperatorToken::MINUS);
+            compileCall(fused.callee, 1);
+            return;
+        }
+        case ExprKind::IF_VAR_EQ_CONST: {
+            const auto& fused = static_cast<const IfVarEqConstExpr&>(expr);
+            compileVariable(fused.name, params);
+            compileConstant(fused.constant);
+            compileBinary(OperatorToken::EQ_EQ);
+            uint32_t to_else = compileBranch();
+            compile(*fused.then_expr, params);
+            uint32_t to_end = emit(Instruction{OpCode::JUMP});
+            --stack_depth_;
+            bindLabel(to_else);
+            compile(*fused.else_expr, params);
+            bindLabel(to_end);
+            return;
+        }
+    }
+    throw RuntimeError("Unknown expression node");
+}
+
+void BytecodeCompiler::compileVariable(const std::string& name, const std::vector<std::string>& params) {
+    auto param = std::find(params.begin(), params.end(), name);
+    if (param != params.end()) {
+        emit(Instruction{OpCode::SLOT, 0, static_cast<uint32_t>(param - params.begin())});
+    } else {
+        emit(Instruction{OpCode::GLOBAL, 0, global(name)});
+    }
+}
+
+void BytecodeCompiler::compileConstant(const Integer& value) {
+    emit(Instruction{OpCode::CONST, 0, static_cast<uint32_t>(program_.constants_.size())});
+    program_.constants_.push_back(value);
+}
+
+void BytecodeCompiler::compileBinary(OperatorToken op) {
+    // A literal right operand folds into the instruction: `n - 1`, `n < 2`.
+    if (!program_.code_.empty() && program_.code_.back().code == OpCode::CONST && label_ != program_.code_.size()) {
+        OpCode fused;
+        switch (op) {
+            case OperatorToken::PLUS:
+                fused = OpCode::ADD_CONST;
+                break;
+            case OperatorToken::MINUS:
+                fused = OpCode::SUBTRACT_CONST;
+                break;
+            case OperatorToken::EQ_EQ:
+                fused = OpCode::EQUAL_CONST;
+                break;
+            case OperatorToken::LESS:
+                fused = OpCode::LESS_CONST;
+                break;
+            default:
+                fused = OpCode::CONST;
+                break;
+        }
+        if (fused != OpCode::CONST) {
+            program_.code_.back().code = fused;
+            --stack_depth_;
+            return;
+        }
+    }
+    switch (op) {
+        case OperatorToken::PLUS:
+            emit(Instruction{OpCode::ADD});
+            return;
+        case OperatorToken::MINUS:
+            emit(Instruction{OpCode::SUBTRACT});
+            return;
+        case OperatorToken::MULTIPLY:
+            emit(Instruction{OpCode::MULTIPLY});
+            return;
+        case OperatorToken::DIVIDE:
+            emit(Instruction{OpCode::DIVIDE});
+            return;
+        case OperatorToken::EQ_EQ:
+            emit(Instruction{OpCode::EQUAL});
+            return;
+        case OperatorToken::NOT_EQ:
+            emit(Instruction{OpCode::NOT_EQUAL});
+            return;
+        case OperatorToken::LESS:
+            emit(Instruction{OpCode::LESS});
+            return;
+        default:
+            throw RuntimeError("Unsupported binary operator");
+    }
+}
+
+uint32_t BytecodeCompiler::compileBranch() {
+    // A comparison with a literal right before the branch folds into it.
+    if (!program_.code_.empty() && label_ != program_.code_.size()) {
+        Instruction& last = program_.code_.back();
+        if (last.code == OpCode::EQUAL_CONST || last.code == OpCode::LESS_CONST) {
+            last.code = last.code == OpCode::EQUAL_CONST ? OpCode::JUMP_UNLESS_EQUAL_CONST
+                                                         : OpCode::JUMP_UNLESS_LESS_CONST;
+            last.argc = last.operand;
+            --stack_depth_;
+            return static_cast<uint32_t>(program_.code_.size() - 1);
+        }
+    }
+    return emit(Instruction{OpCode::JUMP_IF_ZERO});
+}
+
+bool BytecodeCompiler::compileCallee(const std::string& callee, uint32_t argc, bool args_may_fail) {
+    if (registry_ && !defined_.count(callee)) {
+        if (const NativeFunction* native = registry_->Find(callee)) {
+            if (native->arity == argc) {
+                return true;
+            }
+            emit(Instruction{OpCode::THROW, 0, static_cast<uint32_t>(program_.messages_.size())});
+            program_.messages_.push_back("Function '" + callee + "' expects " + std::to_string(native->arity) +
+                                " arguments, got " + std::to_string(argc));
+            return false;
+        }
+    }
+    // CALL itself resolves the callee again; RESOLVE only moves the name and
+    // arity errors ahead of arguments whose own errors would otherwise win.
+    if (args_may_fail) {
+        emit(Instruction{OpCode::RESOLVE, argc, functionSlot(callee)});
+    }
+    return true;
+}
+
+void BytecodeCompiler::compileCall(const std::string& callee, uint32_t argc) {
+    if (registry_ && !defined_.count(callee)) {
+        if (const NativeFunction* native = registry_->Find(callee)) {
+            emit(Instruction{OpCode::CALL_NATIVE, argc, static_cast<uint32_t>(program_.natives_.size())});
+            program_.natives_.push_back(native);
+            return;
+        }
+    }
+    emit(Instruction{OpCode::CALL, argc, functionSlot(callee)});
+}
+
+Integer ExecutionContext::execute(CompiledProgram::CodeEntry entry) {
+    fuel_ -= entry.cost;
+    if (fuel_ < 0) {
+        refuel();
+    }
+    if (stack_.size() < entry.stack) {
+        stack_.resize(entry.stack);
+    }
+    const CompiledProgram& program = *program_;
+    const Instruction* code = program.code_.data();
+    const Integer* constants = program.constants_.data();
+    const Instruction* pc = code + entry.pc;
+    Integer* stack = stack_.data();
+    Integer* stack_end = stack + stack_.size();
+    Frame* frames = frames_.data();
+    Frame* frames_end = frames + std::min(frames_.size(), program.max_depth_);
+    Frame* frame = frames;
+    Integer* slots = stack;
+    Integer* top = slots;
+    for (;;) {
+        const Instruction& instruction = *pc++;
+        switch (instruction.code) {
+            case OpCode::CONST:
+                *top++ = constants[instruction.operand];
+                break;
+            case OpCode::SLOT:
+                *top++ = slots[instruction.operand];
+                break;
+            case OpCode::GLOBAL: {
+                const std::optional<Integer>& global = globals_[instruction.operand];
+                if (!global) {
+                    throw NameError("Undefined variable: " + program.globals_[instruction.operand]);
+                }
+                *top++ = *global;
+                break;
+            }
+            case OpCode::ADD:
+                --top;
+                top[-1] = top[-1] + *top;
+                break;
+            case OpCode::SUBTRACT:
+                --top;
+                top[-1] = top[-1] - *top;
+                break;
+            case OpCode::MULTIPLY:
+                --top;
+                top[-1] = top[-1] * *top;
+                break;
+            case OpCode::DIVIDE:
+                --top;
+                if (top->IsZero()) {
+                    throw RuntimeError("Division by zero");
+                }
+                top[-1] = top[-1] / *top;
+                break;
+            case OpCode::EQUAL:
+                --top;
+                top[-1] = Integer(top[-1] == *top);
+                break;
+            case OpCode::NOT_EQUAL:
+                --top;
+                top[-1] = Integer(top[-1] != *top);
+                break;
+            case OpCode::LESS:
+                --top;
+                top[-1] = Integer(top[-1] < *top);
+                break;
+            case OpCode::ADD_CONST:
+                top[-1] = top[-1] + constants[instruction.operand];
+                break;
+            case OpCode::SUBTRACT_CONST:
+                top[-1] = top[-1] - constants[instruction.operand];
+                break;
+            case OpCode::EQUAL_CONST:
+                top[-1] = Integer(top[-1] == constants[instruction.operand]);
+                break;
+            case OpCode::LESS_CONST:
+                top[-1] = Integer(top[-1] < constants[instruction.operand]);
+                break;
+            case OpCode::JUMP:
+                pc = code + instruction.operand;
+                break;
+            case OpCode::JUMP_IF_ZERO:
+                --top;
+                if (top->IsZero()) {
+                    pc = code + instruction.operand;
+                }
+                break;
+            case OpCode::RESOLVE: {
+                const Function* func = bound_[instruction.operand];
+                if (!func || func->arity != instruction.argc) {
+                    resolve(instruction.operand, instruction.argc);
+                }
+                break;
+            }
+            case OpCode::JUMP_UNLESS_EQUAL_CONST:
+                --top;
+                if (*top != constants[instruction.argc]) {
+                    pc = code + instruction.operand;
+                }
+                break;
+            case OpCode::JUMP_UNLESS_LESS_CONST:
+                --top;
+                if (!(*top < constants[instruction.argc])) {
+                    pc = code + instruction.operand;
+                }
+                break;
+            case OpCode::CALL: {
+                const Function* func = bound_[instruction.operand];
+                if (!func || func->arity != instruction.argc || !func->body) {
+                    func = &resolve(instruction.operand, instruction.argc);
+                }
+                const CompiledProgram::CodeEntry& body = *func->body;
+                fuel_ -= body.cost;
+                if (fuel_ < 0) {
+                    refuel();
+                }
+                if (frame == frames_end) {
+                    auto depth = static_cast<size_t>(frame - frames);
+                    growFrames(depth);
+                    frames = frames_.data();
+                    frames_end = frames + std::min(frames_.size(), program.max_depth_);
+                    frame = frames + depth;
+                }
+                *frame++ = Frame{pc, static_cast<size_t>(slots - stack)};
+                // The arguments already on the stack become the callee's slots.
+                if (static_cast<size_t>(stack_end - top) < body.stack) {
+                    auto used = static_cast<size_t>(top - stack);
+                    growStack(used + body.stack);
+                    stack = stack_.data();
+                    stack_end = stack + stack_.size();
+                    top = stack + used;
+                }
+                slots = top - instruction.argc;
+                pc = code + body.pc;
+                break;
+            }
+            case OpCode::CALL_NATIVE: {
+                top -= instruction.argc;
+                *top = program.natives_[instruction.operand]->Call(top);
+                ++top;
+                break;
+            }
+            case OpCode::THROW:
+                throw RuntimeError(program.messages_[instruction.operand]);
+            case OpCode::RETURN: {
+                if (frame == frames) {
+                    return std::move(top[-1]);
+                }
+                // The result replaces the callee's slots.
+                *slots = std::move(top[-1]);
+                top = slots + 1;
+                --frame;
+                pc = frame->return_pc;
+                slots = stack + frame->slots;
+                break;
+            }
+        }
+    }
+}
+
+BytecodeProgram::BytecodeProgram(const Program& program, const NativeRegistry* natives, size_t max_depth)
+    : context_(std::make_shared<const CompiledProgram>(program, natives, max_depth)) {}
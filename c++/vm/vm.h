@@ -0,0 +1,184 @@
+#ifndef TOY_LANG_VM
+#define TOY_LANG_VM
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../ast/ast.h"
+#include "../error.h"
+#include "../native/native_registry.h"
+
+constexpr size_t kDefaultMaxCallDepth = size_t(1) << 24;
+
+// Bounds on one run for untrusted scripts. Fuel is charged one unit per
+// instruction of a function body or top-level statement, up front when it is
+// entered; the deadline is checked every kFuelCheckInterval units. Either
+// limit raises RuntimeError when exceeded.
+struct ExecutionLimits {
+    uint64_t fuel = 0;  // 0: unlimited
+    std::optional<std::chrono::steady_clock::time_point> deadline{};
+};
+
+constexpr int64_t kFuelCheckInterval = int64_t(1) << 16;
+
+// A Program compiled to flat stack bytecode. It is frozen once constructed:
+// every member is read-only afterwards, so one instance can be shared by any
+// number of threads without locking. All state of a run lives in an
+// ExecutionContext. Bound natives must themselves be safe to call
+// concurrently when contexts run in parallel.
+class CompiledProgram {
+public:
+    explicit CompiledProgram(const Program& program, const NativeRegistry* natives = nullptr,
+                             size_t max_depth = kDefaultMaxCallDepth);
+
+    CompiledProgram(const CompiledProgram&) = delete;
+    CompiledProgram& operator=(const CompiledProgram&) = delete;
+
+private:
+    enum class OpCode : uint8_t {
+        CONST,
+        SLOT,
+        GLOBAL,
+        ADD,
+        SUBTRACT,
+        MULTIPLY,
+        DIVIDE,
+        EQUAL,
+        NOT_EQUAL,
+        LESS,
+        ADD_CONST,
+        SUBTRACT_CONST,
+        EQUAL_CONST,
+        LESS_CONST,
+        JUMP,
+        JUMP_IF_ZERO,
+        JUMP_UNLESS_EQUAL_CONST,
+        JUMP_UNLESS_LESS_CONST,
+        RESOLVE,
+        CALL,
+        CALL_NATIVE,
+        THROW,
+        RETURN
+    };
+
+    struct Instruction {
+        OpCode code;
+        uint32_t argc = 0;     // RESOLVE, CALL, CALL_NATIVE; constant index of JUMP_UNLESS_*
+        uint32_t operand = 0;  // constant / slot / global / function / native / message index, jump target
+    };
+
+    // Start of a compiled expression and the most values it keeps on the
+    // stack at once, so a call can reserve its stack space up front.
+    struct CodeEntry {
+        uint32_t pc = 0;
+        uint32_t stack = 0;
+        uint32_t cost = 0;  // instructions, charged as fuel on entry
+    };
+
+    struct Function {
+        std::string name;
+        size_t arity = 0;
+        std::optional<CodeEntry> body;  // unset when the body does not yield a value
+    };
+
+    enum class StepKind { DEFINE, ASSIGN, RETURN };
+
+    struct Step {
+        StepKind kind = StepKind::DEFINE;
+        uint32_t target = 0;  // function slot / global slot
+        uint32_t function = 0;
+        CodeEntry code{};
+    };
+
+    std::vector<Instruction> code_;
+    std::vector<Integer> constants_;
+    std::vector<std::string> messages_;
+    std::vector<const NativeFunction*> natives_;
+    std::vector<Function> functions_;
+    std::vector<std::string> globals_;         // names by global slot
+    std::vector<std::string> function_slots_;  // names by function slot
+    std::unordered_map<std::string, uint32_t> global_index_;
+    std::unordered_map<std::string, uint32_t> function_index_;
+    std::vector<Step> steps_;
+    size_t max_depth_;
+
+    friend class BytecodeCompiler;
+    friend class ExecutionContext;
+};
+
+// The mutable half of a run: globals, function bindings, the value stack
+// and the frame stack. Call frames and their slots live in two growable heap
+// vectors: a call pushes a frame record and reuses the arguments already on
+// the value stack as the callee's slots, a return truncates back to them.
+// Both vectors only grow, so a call checks each against a cached end pointer
+// and resizes only when it is reached.
+// Script recursion is bounded only by the program's max depth, which raises
+// RuntimeError. A context is used by one thread at a time; its buffers are
+// kept between runs.
+class ExecutionContext {
+public:
+    explicit ExecutionContext(std::shared_ptr<const CompiledProgram> program);
+
+    std::optional<Integer> Run() { return Run(ExecutionLimits{}); }
+    std::optional<Integer> Run(const ExecutionLimits& limits);
+
+    Integer GetGlobal(const std::string& name) const;
+
+    // Fuel charged by the last run, including the charge that exhausted it.
+    uint64_t FuelUsed() const { return fuel_issued_ - fuel_; }
+
+    const std::shared_ptr<const CompiledProgram>& Compiled() const { return program_; }
+
+private:
+    using Instruction = CompiledProgram::Instruction;
+    using Function = CompiledProgram::Function;
+    using OpCode = CompiledProgram::OpCode;
+
+    struct Frame {
+        const Instruction* return_pc;
+        size_t slots;  // offset of the caller's slots in stack_
+    };
+
+    std::shared_ptr<const CompiledProgram> program_;
+    std::vector<std::optional<Integer>> globals_;
+    std::vector<const Function*> bound_;
+    // Only [0, top) is live; the slots above are reused without being cleared.
+    std::vector<Integer> stack_;
+    std::vector<Frame> frames_;  // likewise, up to the frame pointer of execute()
+
+    // Fuel is handed out in windows: charges only decrement fuel_, and the
+    // limits are consulted in refuel() once it drops below zero.
+    ExecutionLimits limits_;
+    int64_t fuel_ = 0;
+    uint64_t fuel_reserve_ = 0;  // budget not yet moved into fuel_
+    uint64_t fuel_issued_ = 0;
+
+    Integer execute(CompiledProgram::CodeEntry entry);
+    const Function& resolve(uint32_t slot, uint32_t argc) const;
+    [[gnu::cold]] void growFrames(size_t depth);
+    [[gnu::cold]] void growStack(size_t needed);
+    void refuel();
+};
+
+// Compiles and runs a program from the calling thread only.
+class BytecodeProgram {
+public:
+    explicit BytecodeProgram(const Program& program, const NativeRegistry* natives = nullptr,
+                             size_t max_depth = kDefaultMaxCallDepth);
+
+    std::optional<Integer> Run(const ExecutionLimits& limits = {}) { return context_.Run(limits); }
+
+    Integer GetGlobal(const std::string& name) const { return context_.GetGlobal(name); }
+
+    uint64_t FuelUsed() const { return context_.FuelUsed(); }
+
+private:
+    ExecutionContext context_;
+};
+
+#endif // TOY_LANG_VM
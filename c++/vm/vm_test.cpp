@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+#include "vm.h"
+#include "context_pool.h"
+#include "../interpreter/interpreter.h"
+#include "../optimizer/fusion.h"
+#include "../parser/parser.h"
+
+class BytecodeProgramTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Program> parse(const std::string& source) {
+        std::stringstream ss(source);
+        Parser parser(&ss);
+        return parser.Parse();
+    }
+};
+
+TEST_F(BytecodeProgramTest, EvaluatesGlobals) {
+    auto program = parse("x = 1 + 2 * 3\ny = (x - 1) / 2\nz = if x < y then 10 else 20\n");
+    BytecodeProgram compiled(*program);
+    EXPECT_FALSE(compiled.Run().has_value());
+    EXPECT_EQ(compiled.GetGlobal("x"), 7);
+    EXPECT_EQ(compiled.GetGlobal("y"), 3);
+    EXPECT_EQ(compiled.GetGlobal("z"), 20);
+}
+
+TEST_F(BytecodeProgramTest, MatchesInterpreter) {
+    const char* sources[] = {
+        "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\nreturn fib(15)\n",
+        "def add(x, y)\n    x = x + y\nreturn add(2, 3)\n",
+        "scale = 10\ndef f(x) return x * scale\nreturn f(4)\n",
+        "def f(a, b, c, d, e) return a - b + c * d / e\nreturn f(1, 2, 3, 4, 5)\n",
+        "def choose(n, k) return if k == 0 then 1 else choose(n - 1, k - 1) * n / k\nreturn choose(100, 50)\n",
+        "def f(c) return 10 - (if c then 1 else 2)\nreturn f(0) * 100 + f(1)\n",
+        "def zero() return 7\ndef g(a) return a + zero() * zero()\nreturn g(zero())\n",
+    };
+    for (const char* source : sources) {
+        auto program = parse(source);
+        BytecodeProgram compiled(*program);
+        EXPECT_EQ(compiled.Run(), Interpreter().Run(*program)) << source;
+        auto fused = parse(source);
+        FuseExpressions(*fused);
+        EXPECT_EQ(BytecodeProgram(*fused).Run(), Interpreter().Run(*program)) << source;
+    }
+}
+
+TEST_F(BytecodeProgramTest, RecursesBeyondNativeStack) {
+    auto program = parse(
+        "def sum(n) return if n == 0 then 0 else n + sum(n - 1)\n"
+        "return sum(1000000)\n");
+    BytecodeProgram compiled(*program);
+    EXPECT_EQ(compiled.Run(), 500000500000);
+}
+
+TEST_F(BytecodeProgramTest, LimitsCallDepth) {
+    auto program = parse(
+        "def down(n) return if n == 0 then 0 else down(n - 1)\n"
+        "x = down(99)\n"
+        "return down(100)\n");
+    BytecodeProgram compiled(*program, nullptr, 100);
+    EXPECT_THROW(compiled.Run(), RuntimeError);
+    EXPECT_EQ(compiled.GetGlobal("x"), 0);
+    EXPECT_EQ(BytecodeProgram(*program, nullptr, 101).Run(), 0);
+}
+
+TEST_F(BytecodeProgramTest, MetersFuel) {
+    auto program = parse("def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\nx = fib(15)\nreturn x\n");
+    BytecodeProgram compiled(*program);
+    EXPECT_EQ(compiled.Run(), 610);
+    uint64_t used = compiled.FuelUsed();
+    EXPECT_GT(used, 1973u);  // at least one unit per call
+    EXPECT_EQ(compiled.Run(ExecutionLimits{used}), 610);
+    EXPECT_EQ(compiled.FuelUsed(), used);
+
+    EXPECT_THROW(compiled.Run(ExecutionLimits{used - 1}), RuntimeError);
+    EXPECT_EQ(compiled.FuelUsed(), used);
+    EXPECT_EQ(compiled.GetGlobal("x"), 610);  // only `return x` was short
+    EXPECT_THROW(compiled.Run(ExecutionLimits{used / 2}), RuntimeError);
+    EXPECT_THROW(compiled.GetGlobal("x"), NameError);
+
+    BytecodeProgram exponential(*parse("def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\n"
+                                       "return fib(90)\n"));
+    try {
+        exponential.Run(ExecutionLimits{100000});
+        FAIL() << "expected the budget to run out";
+    } catch (const RuntimeError& error) {
+        EXPECT_STREQ(error.what(), "Fuel budget of 100000 exhausted");
+    }
+}
+
+TEST_F(BytecodeProgramTest, EnforcesDeadline) {
+    using Clock = std::chrono::steady_clock;
+    BytecodeProgram compiled(*parse("def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\n"
+                                    "return fib(90)\n"));
+    ExecutionLimits limits;
+    limits.deadline = Clock::now() + std::chrono::milliseconds(20);
+    auto start = Clock::now();
+    try {
+        compiled.Run(limits);
+        FAIL() << "expected the deadline to pass";
+    } catch (const RuntimeError& error) {
+        EXPECT_STREQ(error.what(), "Execution deadline exceeded");
+    }
+    EXPECT_LT(Clock::now() - start, std::chrono::seconds(2));
+
+    limits.deadline = Clock::now() + std::chrono::hours(1);
+    EXPECT_EQ(BytecodeProgram(*parse("def f(n) return n * 2\nreturn f(21)\n")).Run(limits), 42);
+}
+
+TEST_F(BytecodeProgramTest, CallsNatives) {
+    NativeRegistry natives;
+    natives.Add("twice", [](int64_t x) { return 2 * x; });
+    auto program = parse("def f(n) return twice(n) + 1\nreturn f(20)\n");
+    EXPECT_EQ(BytecodeProgram(*program, &natives).Run(), 41);
+    EXPECT_THROW(BytecodeProgram(*parse("return twice(1, 2)\n"), &natives).Run(), RuntimeError);
+}
+
+TEST_F(BytecodeProgramTest, ReportsErrors) {
+    EXPECT_THROW(BytecodeProgram(*parse("x = y\n")).Run(), NameError);
+    EXPECT_THROW(BytecodeProgram(*parse("x = f(1)\n")).Run(), NameError);
+    EXPECT_THROW(BytecodeProgram(*parse("x = 1 / 0\n")).Run(), RuntimeError);
+    EXPECT_THROW(BytecodeProgram(*parse("def f(a) return a\nx = f(1, 2)\n")).Run(), RuntimeError);
+    EXPECT_THROW(BytecodeProgram(*parse("def f(a) def g(b) return b\nx = f(1)\n")).Run(), RuntimeError);
+    BytecodeProgram compiled(*parse("x = 1\n"));
+    EXPECT_THROW(compiled.GetGlobal("x"), NameError);
+}
+
+TEST_F(BytecodeProgramTest, ResolvesCalleeBeforeArguments) {
+    NativeRegistry natives;
+    natives.Add("twice", [](int64_t x) { return 2 * x; });
+    const char* sources[] = {
+        "return undefined_fn(1 / 0)\n",
+        "def f(a) return a\nreturn f(1 / 0, 2)\n",
+        "def f(a) return a\nreturn f(y)\n",
+        "return twice(1 / 0, 2)\n",
+        "def f(a) def g(b) return b\nreturn f(1 / 0)\n",
+    };
+    for (const char* source : sources) {
+        auto program = parse(source);
+        std::string expected;
+        try {
+            Interpreter(&natives).Run(*program);
+        } catch (const std::exception& error) {
+            expected = error.what();
+        }
+        ASSERT_FALSE(expected.empty()) << source;
+        try {
+            BytecodeProgram(*program, &natives).Run();
+            ADD_FAILURE() << source;
+        } catch (const std::exception& error) {
+            EXPECT_EQ(error.what(), expected) << source;
+        }
+    }
+}
+
+TEST_F(BytecodeProgramTest, ContextsShareCompiledProgram) {
+    auto compiled = std::make_shared<const CompiledProgram>(*parse("x = 6 * 7\nreturn x + 1\n"));
+    ExecutionContext first(compiled);
+    ExecutionContext second(compiled);
+    EXPECT_EQ(first.Run(), 43);
+    EXPECT_EQ(first.GetGlobal("x"), 42);
+    EXPECT_THROW(second.GetGlobal("x"), NameError);
+    EXPECT_EQ(second.Run(), 43);
+    EXPECT_EQ(first.Compiled(), second.Compiled());
+}
+
+TEST_F(BytecodeProgramTest, PoolRecyclesContexts) {
+    ContextPool pool(std::make_shared<const CompiledProgram>(*parse("return 1\n")));
+    ExecutionContext* context = nullptr;
+    {
+        auto lease = pool.Acquire();
+        context = lease.get();
+        EXPECT_EQ(lease->Run(), 1);
+        EXPECT_EQ(pool.Idle(), 0u);
+    }
+    EXPECT_EQ(pool.Idle(), 1u);
+    auto first = pool.Acquire();
+    auto second = pool.Acquire();
+    EXPECT_EQ(first.get(), context);
+    EXPECT_NE(second.get(), context);
+}
+
+TEST_F(BytecodeProgramTest, RunsConcurrentlyFromPool) {
+    ContextPool pool(std::make_shared<const CompiledProgram>(*parse(
+        "def fib(n) return if n < 2 then n else fib(n - 1) + fib(n - 2)\n"
+        "def sum(n) return if n == 0 then 0 else n + sum(n - 1)\n"
+        "x = fib(15)\n"
+        "return x + sum(20000)\n")));
+    std::vector<std::thread> threads;
+    std::vector<int> failures(4, 0);
+    for (size_t t = 0; t < failures.size(); ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 20; ++i) {
+                auto context = pool.Acquire();
+                if (context->Run() != 610 + 200010000 || context->GetGlobal("x") != 610) {
+                    ++failures[t];
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int failed : failures) {
+        EXPECT_EQ(failed, 0);
+    }
+    EXPECT_LE(pool.Idle(), failures.size());
+}